@@ -104,6 +104,10 @@ public:
   virtual size_t transfersCount() const = 0;
   virtual size_t transactionsCount() const = 0;
   virtual uint64_t balance(uint32_t flags = IncludeDefault) const = 0;
+  // Unspent deposits with their interest, kept up to date as transfers change state rather than summed on each call.
+  // Locked covers unconfirmed deposits and those whose unlock height is not reached yet.
+  virtual uint64_t lockedDepositsBalance() const = 0;
+  virtual uint64_t unlockedDepositsBalance() const = 0;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags = IncludeDefault) const = 0;
   virtual bool getTransactionInformation(const crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const = 0;
@@ -590,6 +590,13 @@ typename FileMappedVector<T>::iterator FileMappedVector<T>::erase(const_iterator
 
   uint64_t newSize = size() - std::distance(first, last);
 
+  if (last == cend()) {
+    // Truncating the tail doesn't move any element, so it is enough to update the size
+    *sizePtr() = newSize;
+    flushSize();
+    return iterator(this, first.index());
+  }
+
   atomicUpdate(newSize, capacity(), prefixSize(), suffixSize(), [this, first, last](value_type* target) {
     std::copy(cbegin(), first, target);
     std::copy(last, cend(), target + std::distance(cbegin(), first));
@@ -619,6 +626,18 @@ typename FileMappedVector<T>::iterator FileMappedVector<T>::insert(const_iterato
     }
   } else {
     newCapacity = capacity();
+
+    if (position == cend()) {
+      // Appending within capacity: write new elements in place and publish them by updating the size
+      std::copy(first, last, vectorDataPtr() + size());
+      if (m_autoFlush) {
+        m_file.flush(reinterpret_cast<uint8_t*>(vectorDataPtr() + size()), (newSize - size()) * valueSize);
+      }
+
+      *sizePtr() = newSize;
+      flushSize();
+      return iterator(this, position.index());
+    }
   }
 
   atomicUpdate(newSize, newCapacity, prefixSize(), suffixSize(), [this, position, first, last](value_type* target) {
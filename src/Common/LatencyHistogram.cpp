@@ -0,0 +1,84 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace common {
+
+namespace {
+
+uint64_t bucketUpperBound(size_t bucket) {
+  return UINT64_C(1) << bucket;
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() : m_count(0), m_totalMicroseconds(0) {
+  for (auto& bucket : m_buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::add(std::chrono::nanoseconds duration) {
+  uint64_t microseconds = static_cast<uint64_t>(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+  size_t bucket = 0;
+  while (bucket + 1 < BUCKET_COUNT && microseconds >= bucketUpperBound(bucket)) {
+    ++bucket;
+  }
+
+  m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  m_totalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+  return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::totalMicroseconds() const {
+  return m_totalMicroseconds.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketCount(size_t bucket) const {
+  return m_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+  uint64_t counts[BUCKET_COUNT];
+  uint64_t total = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    counts[i] = bucketCount(i);
+    total += counts[i];
+  }
+
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return bucketUpperBound(i);
+    }
+  }
+
+  return bucketUpperBound(BUCKET_COUNT - 1);
+}
+
+std::string LatencyHistogram::toString() const {
+  uint64_t requests = count();
+  std::ostringstream stream;
+  stream << "count " << requests << ", mean " << (requests == 0 ? 0 : totalMicroseconds() / requests) << " us, p50 < " <<
+    percentile(0.5) << " us, p90 < " << percentile(0.9) << " us, p99 < " << percentile(0.99) << " us, max < " << percentile(1) << " us";
+  return stream.str();
+}
+
+}
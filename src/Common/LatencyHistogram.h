@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace common {
+
+// Counts durations in power of two microsecond buckets: bucket 0 holds durations under 1 us,
+// bucket i those in [2^(i-1), 2^i) us and the last bucket everything longer. Durations can be
+// added from any thread while others read.
+class LatencyHistogram {
+public:
+  static const size_t BUCKET_COUNT = 24;
+
+  LatencyHistogram();
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void add(std::chrono::nanoseconds duration);
+  uint64_t count() const;
+  uint64_t totalMicroseconds() const;
+  uint64_t bucketCount(size_t bucket) const;
+  // Upper bound in microseconds of the bucket the given fraction of durations falls in, 0 when empty
+  uint64_t percentile(double fraction) const;
+  // "count, mean, p50, p90, p99, max" on one line
+  std::string toString() const;
+
+private:
+  std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+  std::atomic<uint64_t> m_count;
+  std::atomic<uint64_t> m_totalMicroseconds;
+};
+
+}
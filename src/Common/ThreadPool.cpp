@@ -0,0 +1,109 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "ThreadPool.h"
+
+namespace common {
+
+ThreadPool::ThreadPool(size_t threadCount) : body(nullptr), count(0), nextIndex(0), busyThreads(0), generation(0), stopping(false) {
+  threads.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+
+  jobStarted.notify_all();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+size_t ThreadPool::getConcurrency() const {
+  return threads.size() + 1;
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+  std::lock_guard<std::mutex> jobLock(jobMutex);
+  if (threads.empty() || count < 2) {
+    for (size_t i = 0; i < count; ++i) {
+      body(i);
+    }
+
+    return;
+  }
+
+  {
+    // a thread that woke up too late for the previous job may still be looking at it
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return busyThreads == 0; });
+    this->body = &body;
+    this->count = count;
+    nextIndex = 0;
+    error = nullptr;
+    ++generation;
+  }
+
+  jobStarted.notify_all();
+  runJob();
+
+  std::exception_ptr jobError;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobFinished.wait(lock, [this] { return busyThreads == 0; });
+    std::swap(jobError, error);
+  }
+
+  if (jobError) {
+    std::rethrow_exception(jobError);
+  }
+}
+
+void ThreadPool::workerLoop() {
+  uint64_t lastGeneration = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  for (;;) {
+    jobStarted.wait(lock, [&] { return stopping || generation != lastGeneration; });
+    if (stopping) {
+      return;
+    }
+
+    lastGeneration = generation;
+    ++busyThreads;
+    lock.unlock();
+    runJob();
+    lock.lock();
+    if (--busyThreads == 0) {
+      jobFinished.notify_all();
+    }
+  }
+}
+
+void ThreadPool::runJob() {
+  for (;;) {
+    size_t index = nextIndex.fetch_add(1);
+    if (index >= count) {
+      break;
+    }
+
+    try {
+      (*body)(index);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+
+      nextIndex = count;
+    }
+  }
+}
+
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+// A fixed set of threads kept alive between jobs. A job is a parallel loop, the caller works on it
+// along with the threads and gets back control when every index has been processed.
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t threadCount);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  // Number of threads working on a job, the caller included
+  size_t getConcurrency() const;
+
+  // Calls body(i) for every i in [0, count) and waits until all calls are done. Jobs from different
+  // callers run one after another. The first exception thrown by body is rethrown, once the indices
+  // already taken are finished; the rest are skipped. body must not call parallelFor on the same pool.
+  void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+  void workerLoop();
+  void runJob();
+
+  std::mutex jobMutex;
+  std::mutex mutex;
+  std::condition_variable jobStarted;
+  std::condition_variable jobFinished;
+  std::vector<std::thread> threads;
+  const std::function<void(size_t)>* body;
+  size_t count;
+  std::atomic<size_t> nextIndex;
+  size_t busyThreads;
+  uint64_t generation;
+  bool stopping;
+  std::exception_ptr error;
+};
+
+}
@@ -103,6 +103,10 @@ static_assert(UPGRADE_VOTING_WINDOW > 1, "Bad UPGRADE_VOTING_WINDOW");
 const char     CRYPTONOTE_BLOCKS_FILENAME[] 			= "blocks.dat";
 const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[] 		= "blockindexes.dat";
 const char     CRYPTONOTE_BLOCKSCACHE_FILENAME[] 		= "blockscache.dat";
+const char     CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME[] 	= "blockscache.journal";
+const char     CRYPTONOTE_BLOCKSTORE_FILENAME[] 		= "blockstore.dat";
+const char     CRYPTONOTE_BLOCKSTOREINDEX_FILENAME[] 		= "blockstoreindex.dat";
+const char     CRYPTONOTE_KEYIMAGES_FILENAME[] 			= "keyimages.dat";
 const char     CRYPTONOTE_POOLDATA_FILENAME[] 			= "poolstate.bin";
 const char     P2P_NET_DATA_FILENAME[] 				    = "p2pstate.bin";
 const char     CRYPTONOTE_BLOCKCHAIN_INDICES_FILENAME[]       	= "blockchainindices.dat";
@@ -6,7 +6,7 @@
 
 #include "Account.h"
 #include "CryptoNoteSerialization.h"
-#include "crypto/keccak.c"
+#include "crypto/keccak.h"
 
 namespace cn {
 //-----------------------------------------------------------------
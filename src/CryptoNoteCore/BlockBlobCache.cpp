@@ -0,0 +1,97 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockBlobCache.h"
+
+namespace cn {
+
+namespace {
+
+size_t serializedSize(const SerializedBlock& block) {
+  size_t size = sizeof(SerializedBlock) + block.block.size();
+  // a transaction prefix is the transaction blob without signatures, count it at the blob size
+  for (const auto& transaction : block.transactions) {
+    size += sizeof(std::string) + sizeof(TransactionPrefixInfo) + 2 * transaction.size();
+  }
+
+  return size;
+}
+
+}
+
+BlockBlobCache::BlockBlobCache(size_t maxSize) : m_maxSize(maxSize), m_size(0), m_hits(0), m_misses(0) {
+}
+
+std::shared_ptr<const SerializedBlock> BlockBlobCache::get(uint32_t height, const crypto::Hash& blockHash) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(height);
+  if (it == m_entries.end() || it->second.block->blockHash != blockHash) {
+    ++m_misses;
+    return nullptr;
+  }
+
+  m_order.splice(m_order.end(), m_order, it->second.orderIter);
+  ++m_hits;
+  return it->second.block;
+}
+
+void BlockBlobCache::put(uint32_t height, std::shared_ptr<const SerializedBlock> block) {
+  size_t size = serializedSize(*block);
+  if (size > m_maxSize) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(height);
+  if (it != m_entries.end()) {
+    erase(it);
+  }
+
+  while (m_size + size > m_maxSize) {
+    erase(m_entries.find(m_order.front()));
+  }
+
+  Entry entry = { std::move(block), size, m_order.insert(m_order.end(), height) };
+  m_entries.emplace(height, std::move(entry));
+  m_size += size;
+}
+
+void BlockBlobCache::invalidateFrom(uint32_t height) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (it->first >= height) {
+      auto next = std::next(it);
+      erase(it);
+      it = next;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void BlockBlobCache::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_order.clear();
+  m_size = 0;
+}
+
+uint64_t BlockBlobCache::hits() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_hits;
+}
+
+uint64_t BlockBlobCache::misses() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_misses;
+}
+
+void BlockBlobCache::erase(std::unordered_map<uint32_t, Entry>::iterator it) {
+  m_size -= it->second.size;
+  m_order.erase(it->second.orderIter);
+  m_entries.erase(it);
+}
+
+}
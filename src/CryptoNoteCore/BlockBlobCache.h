@@ -0,0 +1,66 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+
+namespace cn {
+
+// A main chain block in the form wallet sync sends it: the block and its transaction blobs for
+// queryBlocks and the hashed transaction prefixes for queryBlocksLite. The miner transaction is
+// part of the block blob, so it has no entry of its own.
+struct SerializedBlock {
+  crypto::Hash blockHash;
+  uint64_t timestamp;
+  std::string block;
+  std::vector<std::string> transactions;
+  std::vector<TransactionPrefixInfo> transactionPrefixes;
+};
+
+// Height keyed LRU cache of serialized blocks, bounded by the size of their blobs.
+// Entries are immutable and shared, so readers keep using an entry after it is evicted.
+// Lookups pass the expected block hash, a mismatch after a reorganization is a miss.
+class BlockBlobCache {
+public:
+  explicit BlockBlobCache(size_t maxSize);
+
+  std::shared_ptr<const SerializedBlock> get(uint32_t height, const crypto::Hash& blockHash);
+  void put(uint32_t height, std::shared_ptr<const SerializedBlock> block);
+
+  // Drops the blocks at height and above
+  void invalidateFrom(uint32_t height);
+  void clear();
+
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+private:
+  struct Entry {
+    std::shared_ptr<const SerializedBlock> block;
+    size_t size;
+    std::list<uint32_t>::iterator orderIter;
+  };
+
+  void erase(std::unordered_map<uint32_t, Entry>::iterator it);
+
+  mutable std::mutex m_mutex;
+  const size_t m_maxSize;
+  size_t m_size;
+  std::unordered_map<uint32_t, Entry> m_entries;
+  std::list<uint32_t> m_order;
+  uint64_t m_hits;
+  uint64_t m_misses;
+};
+
+}
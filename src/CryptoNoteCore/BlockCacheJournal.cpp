@@ -0,0 +1,108 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockCacheJournal.h"
+
+namespace cn {
+
+namespace {
+
+const uint32_t JOURNAL_SIGNATURE = 0x4a434342; // "BCCJ"
+const uint32_t JOURNAL_VERSION = 1;
+const uint32_t MAX_RECORD_ENTRY_SIZE = 256 * 1024 * 1024;
+
+}
+
+BlockCacheJournal::BlockCacheJournal() : m_recordCount(0) {
+}
+
+bool BlockCacheJournal::open(const std::string& fileName) {
+  close();
+  m_fileName = fileName;
+  m_recordCount = 0;
+  m_file.open(m_fileName, std::ios::out | std::ios::binary | std::ios::app);
+  return static_cast<bool>(m_file);
+}
+
+void BlockCacheJournal::close() {
+  if (m_file.is_open()) {
+    m_file.close();
+  }
+}
+
+bool BlockCacheJournal::load(crypto::Hash& checkpointHash, std::vector<PopRecord>& records) {
+  std::ifstream file(m_fileName, std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  uint32_t signature;
+  uint32_t version;
+  file.read(reinterpret_cast<char*>(&signature), sizeof signature);
+  file.read(reinterpret_cast<char*>(&version), sizeof version);
+  file.read(reinterpret_cast<char*>(&checkpointHash), sizeof checkpointHash);
+  if (!file || signature != JOURNAL_SIGNATURE || version != JOURNAL_VERSION) {
+    return false;
+  }
+
+  for (;;) {
+    PopRecord record;
+    uint32_t entrySize;
+    file.read(reinterpret_cast<char*>(&record.height), sizeof record.height);
+    file.read(reinterpret_cast<char*>(&record.blockHash), sizeof record.blockHash);
+    file.read(reinterpret_cast<char*>(&entrySize), sizeof entrySize);
+    if (!file || entrySize > MAX_RECORD_ENTRY_SIZE) {
+      break;
+    }
+
+    record.entry.resize(entrySize);
+    file.read(reinterpret_cast<char*>(record.entry.data()), entrySize);
+    if (!file) {
+      break;
+    }
+
+    records.push_back(std::move(record));
+  }
+
+  m_recordCount = records.size();
+  return true;
+}
+
+bool BlockCacheJournal::reset(const crypto::Hash& checkpointHash) {
+  close();
+
+  m_file.open(m_fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  m_file.write(reinterpret_cast<const char*>(&JOURNAL_SIGNATURE), sizeof JOURNAL_SIGNATURE);
+  m_file.write(reinterpret_cast<const char*>(&JOURNAL_VERSION), sizeof JOURNAL_VERSION);
+  m_file.write(reinterpret_cast<const char*>(&checkpointHash), sizeof checkpointHash);
+  m_file.flush();
+  m_recordCount = 0;
+  return static_cast<bool>(m_file);
+}
+
+bool BlockCacheJournal::appendPop(uint32_t height, const crypto::Hash& blockHash, const uint8_t* entry, size_t entrySize) {
+  if (!m_file.is_open()) {
+    return false;
+  }
+
+  uint32_t size = static_cast<uint32_t>(entrySize);
+  m_file.write(reinterpret_cast<const char*>(&height), sizeof height);
+  m_file.write(reinterpret_cast<const char*>(&blockHash), sizeof blockHash);
+  m_file.write(reinterpret_cast<const char*>(&size), sizeof size);
+  m_file.write(reinterpret_cast<const char*>(entry), size);
+  m_file.flush();
+  if (!m_file) {
+    return false;
+  }
+
+  ++m_recordCount;
+  return true;
+}
+
+size_t BlockCacheJournal::recordCount() const {
+  return m_recordCount;
+}
+
+}
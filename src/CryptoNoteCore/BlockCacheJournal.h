@@ -0,0 +1,51 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CryptoNote.h"
+
+namespace cn {
+
+// Append-only log of the blocks popped from the main chain since the last blockchain cache checkpoint.
+// Pushed blocks need no record: the block store is append-only, so blocks above the checkpoint are
+// indexed again from the store. A popped block is gone from the store, so its serialized entry is kept
+// here to undo its index mutations on startup.
+class BlockCacheJournal {
+public:
+  struct PopRecord {
+    uint32_t height;
+    crypto::Hash blockHash;
+    BinaryArray entry;
+  };
+
+  BlockCacheJournal();
+
+  // Opens the journal for appending; the caller loads or resets it before appending records.
+  bool open(const std::string& fileName);
+  void close();
+
+  // Reads the checkpoint the journal was started against and all complete records.
+  // A record torn by a crash at the end of the file is ignored.
+  bool load(crypto::Hash& checkpointHash, std::vector<PopRecord>& records);
+
+  // Drops all records and starts a journal for a cache saved at checkpointHash.
+  bool reset(const crypto::Hash& checkpointHash);
+  bool appendPop(uint32_t height, const crypto::Hash& blockHash, const uint8_t* entry, size_t entrySize);
+
+  size_t recordCount() const;
+
+private:
+  std::string m_fileName;
+  std::ofstream m_file;
+  size_t m_recordCount;
+};
+
+}
@@ -12,12 +12,16 @@
 #include <numeric>
 #include <cstdio>
 #include <cmath>
+#include <deque>
+#include <future>
+#include <thread>
+#include <boost/filesystem.hpp>
 #include <boost/foreach.hpp>
 #include "Common/Math.h"
 #include "Common/int-util.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
-#include "Common/StdOutputStream.h"
+#include "Common/StringOutputStream.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Serialization/BinarySerializationTools.h"
 #include "CryptoNoteTools.h"
@@ -29,6 +33,42 @@ using namespace common;
 
 namespace {
 
+// The blockchain cache is saved again once replaying the journal and indexing the blocks above the
+// checkpoint would take about this many blocks worth of work
+const uint32_t BLOCKCACHE_CHECKPOINT_INTERVAL = 10000;
+const size_t BLOCKCACHE_JOURNAL_MAX_RECORDS = 1000;
+
+// Spent key images changed since the key image table was written are kept in memory, the table is
+// rewritten once there are this many
+const size_t KEY_IMAGES_MAX_PENDING = 500000;
+
+// Serialized blocks kept for wallet sync, enough for the recent blocks most wallets request
+const size_t BLOCK_BLOB_CACHE_SIZE = 64 * 1024 * 1024;
+
+// Verified key inputs remembered, well above what a full pool spends
+const size_t SIGNATURE_CACHE_SIZE = 65536;
+
+// Long hashes a preparation worker computes together, each with a 2 MiB scratchpad of its own
+const size_t PROOF_OF_WORK_WAYS = 2;
+
+// Writes the file next to the old one and replaces it only when complete, so a crash while saving
+// leaves the previous file intact
+bool replaceFile(const std::string& fileName, const std::string& data) {
+  std::string tmpFileName = fileName + ".tmp";
+  {
+    std::ofstream file(tmpFileName, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    file.flush();
+    if (!file) {
+      return false;
+    }
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::rename(tmpFileName, fileName, ec);
+  return !ec;
+}
+
 std::string appendPath(const std::string& path, const std::string& fileName) {
   std::string result = path;
   if (!result.empty()) {
@@ -51,7 +91,7 @@ bool operator<(const crypto::KeyImage& keyImage1, const crypto::KeyImage& keyIma
 }
 }
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 3
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 5
 #define CURRENT_BLOCKCHAININDICES_STORAGE_ARCHIVE_VER 1
 
 namespace cn {
@@ -90,30 +130,6 @@ bool serialize(google::sparse_hash_set<K, Hash>& value, common::StringView name,
   return true;
 }
 
-// custom serialization to speedup cache loading
-bool serialize(std::vector<std::pair<Blockchain::TransactionIndex, uint16_t>>& value, common::StringView name, cn::ISerializer& s) {
-  const size_t elementSize = sizeof(std::pair<Blockchain::TransactionIndex, uint16_t>);
-  size_t size = value.size() * elementSize;
-
-  if (!s.beginArray(size, name)) {
-    return false;
-  }
-
-  if (s.type() == cn::ISerializer::INPUT) {
-    if (size % elementSize != 0) {
-      throw std::runtime_error("Invalid vector size");
-    }
-    value.resize(size / elementSize);
-  }
-
-  if (size) {
-    s.binary(value.data(), size, "");
-  }
-
-  s.endArray();
-  return true;
-}
-
 void serialize(Blockchain::TransactionIndex& value, ISerializer& s) {
   s(value.block, "block");
   s(value.transaction, "tx");
@@ -141,14 +157,10 @@ public:
     }
   }
 
-  bool save(const std::string& filename) {
+  // Serializes the cache into memory, Blockchain::writeCache saves it once the blockchain lock is released
+  bool save(std::string& data) {
     try {
-      std::ofstream file(filename, std::ios::binary);
-      if (!file) {
-        return false;
-      }
-
-      StdOutputStream stream(file);
+      StringOutputStream stream(data);
       BinaryOutputStreamSerializer s(stream);
       cn::serialize(*this, s);
     } catch (std::exception&) {
@@ -172,13 +184,7 @@ public:
     std::string operation;
     if (s.type() == ISerializer::INPUT) {
       operation = "loading ";
-      crypto::Hash blockHash;
-      s(blockHash, "last_block");
-
-      if (blockHash != m_lastBlockHash) {
-        return;
-      }
-
+      s(m_lastBlockHash, "last_block");
     } else {
       operation = "- saving ";
       s(m_lastBlockHash, "last_block");
@@ -187,12 +193,15 @@ public:
     logger(INFO, GREEN) << operation << "block index";
     s(m_bs.m_blockIndex, "block_index");
 
+    if (s.type() == ISerializer::INPUT &&
+        (m_bs.m_blockIndex.size() == 0 || m_bs.m_blockIndex.getBlockId(m_bs.m_blockIndex.size() - 1) != m_lastBlockHash)) {
+      logger(WARNING) << "block index doesn't end with the checkpoint block";
+      return;
+    }
+
     logger(INFO, GREEN) << operation << "transaction map";
     s(m_bs.m_transactionMap, "transactions");
 
-    logger(INFO, GREEN) << operation << "spent keys";
-    s(m_bs.m_spent_keys, "spent_keys");
-
     logger(INFO, GREEN) << operation << "outputs";
     s(m_bs.m_outputs, "outputs");
 
@@ -213,6 +222,10 @@ public:
     return m_loaded;
   }
 
+  const crypto::Hash& lastBlockHash() const {
+    return m_lastBlockHash;
+  }
+
 private:
   LoggerRef logger;
   bool m_loaded;
@@ -317,6 +330,12 @@ m_currency(currency),
 m_tx_pool(tx_pool),
 m_current_block_cumul_sz_limit(0),
 m_checkpoints(logger),
+m_blobCache(BLOCK_BLOB_CACHE_SIZE),
+m_signatureCache(SIGNATURE_CACHE_SIZE),
+m_cacheCheckpointHeight(0),
+m_cacheSaveFailed(false),
+m_cacheSnapshotCount(0),
+m_cacheSnapshotWritten(0),
 m_blockchainIndexesEnabled(blockchainIndexesEnabled),
 m_upgradeDetectorV2(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger),
 m_upgradeDetectorV3(currency, m_blocks, BLOCK_MAJOR_VERSION_3, logger)
@@ -325,8 +344,6 @@ m_upgradeDetectorV3(currency, m_blocks, BLOCK_MAJOR_VERSION_3, logger)
 
   m_outputs.set_deleted_key(0);
   m_multisignatureOutputs.set_deleted_key(0);
-  crypto::KeyImage nullImage = boost::value_initialized<decltype(nullImage)>();
-  m_spent_keys.set_deleted_key(nullImage);
 }
 
 bool Blockchain::addObserver(IBlockchainStorageObserver* observer) {
@@ -396,17 +413,17 @@ bool Blockchain::checkTransactionSize(size_t blobSize) {
 }
 
 bool Blockchain::haveTransaction(const crypto::Hash &id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_transactionMap.find(id) != m_transactionMap.end();
 }
 
 bool Blockchain::have_tx_keyimg_as_spent(const crypto::KeyImage &key_im) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  return  m_spent_keys.find(key_im) != m_spent_keys.end();
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  return m_spent_keys.contains(key_im);
 }
 
 uint32_t Blockchain::getCurrentBlockchainHeight() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return static_cast<uint32_t>(m_blocks.size());
 }
 
@@ -419,19 +436,49 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   m_config_folder = config_folder;
 
-  if (!m_blocks.open(appendPath(config_folder, m_currency.blocksFileName()), appendPath(config_folder, m_currency.blockIndexesFileName()), 1024)) {
+  if (!m_blocks.open(appendPath(config_folder, m_currency.blockStoreFileName()), appendPath(config_folder, m_currency.blockStoreIndexFileName()), 1024)) {
+    logger(ERROR, BRIGHT_RED) << "<< Blockchain.cpp << Failed to open block store";
+    return false;
+  }
+
+  if (load_existing && m_blocks.empty()) {
+    std::string legacyBlocksFile = appendPath(config_folder, m_currency.blocksFileName());
+    std::string legacyIndexesFile = appendPath(config_folder, m_currency.blockIndexesFileName());
+    if (boost::filesystem::exists(legacyBlocksFile) && boost::filesystem::exists(legacyIndexesFile)) {
+      logger(INFO, BRIGHT_WHITE) << "<< Blockchain.cpp << Importing blocks from " << legacyBlocksFile << " into the block store";
+      if (!m_blocks.importSwappedVector(legacyBlocksFile, legacyIndexesFile)) {
+        logger(ERROR, BRIGHT_RED) << "<< Blockchain.cpp << Failed to import blocks from " << legacyBlocksFile;
+        return false;
+      }
+
+      logger(INFO, BRIGHT_WHITE) << "<< Blockchain.cpp << Imported " << m_blocks.size() << " blocks, " << legacyBlocksFile << " and " << legacyIndexesFile << " are no longer used";
+    }
+  }
+
+  if (!m_cacheJournal.open(appendPath(config_folder, m_currency.blocksCacheJournalFileName()))) {
+    logger(ERROR, BRIGHT_RED) << "<< Blockchain.cpp << Failed to open blockchain cache journal";
     return false;
   }
 
+  if (!m_spent_keys.open(appendPath(config_folder, m_currency.keyImagesFileName()))) {
+    logger(ERROR, BRIGHT_RED) << "<< Blockchain.cpp << Failed to open spent key images";
+    return false;
+  }
+
+  m_cacheCheckpointHeight = 0;
+  m_cacheSaveFailed = false;
+
   if (load_existing && !m_blocks.empty()) {
     logger(INFO, BRIGHT_WHITE) << "<< Blockchain.cpp << Loading blockchain";
-    BlockCacheSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
-    loader.load(appendPath(config_folder, m_currency.blocksCacheFileName()));
-
-    if (!loader.loaded()) {
+    if (!loadCache()) {
       logger(WARNING, BRIGHT_YELLOW) << "<< Blockchain.cpp << No actual blockchain cache found, rebuilding internal structures";
       rebuildCache();
+      storeCache();
+    } else if (cacheCheckpointIsStale()) {
+      storeCache();
     }
+
+    rebuildUnlockedOutputCounts();
     
         /* Load (or generate) the indices only if Explorer mode is enabled */
     if (m_blockchainIndexesEnabled) {
@@ -442,6 +489,11 @@ bool Blockchain::init(const std::string& config_folder, bool load_existing) {
 
   } else {
     m_blocks.clear();
+    m_cacheJournal.reset(NULL_HASH);
+    if (!m_spent_keys.clear()) {
+      logger(ERROR, BRIGHT_RED) << "<< Blockchain.cpp << Failed to clear spent key images";
+      return false;
+    }
   }
 
   if (m_blocks.empty()) {
@@ -519,81 +571,310 @@ bool Blockchain::checkCheckpoints(uint32_t& lastValidCheckpointHeight) {
   return true;
 }
 
+bool Blockchain::loadCache() {
+  BlockCacheSerializer loader(*this, NULL_HASH, logger.getLogger());
+  loader.load(appendPath(m_config_folder, m_currency.blocksCacheFileName()));
+  if (!loader.loaded()) {
+    return false;
+  }
+
+  crypto::Hash journalHash;
+  std::vector<BlockCacheJournal::PopRecord> records;
+  if (!m_cacheJournal.load(journalHash, records)) {
+    // Cache saved before the journal was introduced, only usable if it matches the stored chain
+    if (loader.lastBlockHash() != get_block_hash(m_blocks.back().bl)) {
+      return false;
+    }
+
+    m_cacheJournal.reset(loader.lastBlockHash());
+  } else if (journalHash != loader.lastBlockHash()) {
+    logger(WARNING, BRIGHT_YELLOW) << "Blockchain cache journal doesn't belong to the saved cache";
+    return false;
+  }
+
+  if (m_spent_keys.checkpointHash() != loader.lastBlockHash()) {
+    logger(WARNING, BRIGHT_YELLOW) << "Spent key images don't belong to the saved cache";
+    return false;
+  }
+
+  for (const auto& record : records) {
+    BlockEntry block;
+    if (m_blockIndex.size() != record.height + 1 || m_blockIndex.getBlockId(record.height) != record.blockHash ||
+        !fromBinaryArray(block, record.entry)) {
+      logger(WARNING, BRIGHT_YELLOW) << "Blockchain cache journal is inconsistent at height " << record.height;
+      return false;
+    }
+
+    popTransactions(block, getObjectHash(block.bl.baseTransaction));
+    m_depositIndex.popBlock();
+    m_blockIndex.pop();
+  }
+
+  uint32_t checkpointHeight = m_blockIndex.size();
+  if (checkpointHeight == 0 || checkpointHeight > m_blocks.size() ||
+      m_blockIndex.getBlockId(checkpointHeight - 1) != get_block_hash(m_blocks[checkpointHeight - 1].bl)) {
+    logger(WARNING, BRIGHT_YELLOW) << "Blockchain cache doesn't match the stored blocks";
+    return false;
+  }
+
+  m_cacheCheckpointHeight = checkpointHeight;
+  logger(INFO, BRIGHT_WHITE) << "Blockchain cache checkpoint at height " << checkpointHeight - 1 << ", undid " << records.size() <<
+    " popped blocks, indexing " << m_blocks.size() - checkpointHeight << " new blocks";
+
+  indexBlocks(checkpointHeight);
+  return true;
+}
+
+bool Blockchain::cacheCheckpointIsStale() const {
+  return m_cacheSaveFailed || m_blocks.size() - m_cacheCheckpointHeight >= BLOCKCACHE_CHECKPOINT_INTERVAL ||
+    m_cacheJournal.recordCount() >= BLOCKCACHE_JOURNAL_MAX_RECORDS ||
+    m_spent_keys.checkpointHash() == NULL_HASH || m_spent_keys.pendingCount() >= KEY_IMAGES_MAX_PENDING;
+}
+
 void Blockchain::rebuildCache() {
   logger(INFO, BRIGHT_WHITE) << "Rebuilding cache";
 
   std::chrono::steady_clock::time_point timePoint = std::chrono::steady_clock::now();
   m_blockIndex.clear();
   m_transactionMap.clear();
-  m_spent_keys.clear();
+  if (!m_spent_keys.clear()) {
+    throw std::runtime_error("Blockchain::rebuildCache, failed to clear spent key images");
+  }
+
   m_outputs.clear();
   m_multisignatureOutputs.clear();
-  for (uint32_t b = 0; b < m_blocks.size(); ++b) {
-    if (b % 1000 == 0) {
-      logger(INFO, BRIGHT_WHITE) << "Rebuilding Cache for Height " << b << " of " << m_blocks.size();
-    }
-
-    const BlockEntry& block = m_blocks[b];
-    crypto::Hash blockHash = get_block_hash(block.bl);
-    m_blockIndex.push(blockHash);
-    uint64_t interest = 0;
-    for (uint16_t t = 0; t < block.transactions.size(); ++t) {
-      const TransactionEntry& transaction = block.transactions[t];
-      crypto::Hash transactionHash = getObjectHash(transaction.tx);
-      TransactionIndex transactionIndex = { b, t };
-      m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
-
-      // process inputs
-      for (auto& i : transaction.tx.inputs) {
-        if (i.type() == typeid(KeyInput)) {
-          m_spent_keys.insert(::boost::get<KeyInput>(i).keyImage);
-        } else if (i.type() == typeid(MultisignatureInput)) {
-          auto out = ::boost::get<MultisignatureInput>(i);
-          m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
-        }
+  m_depositIndex.popBlocks(0);
+  indexBlocks(0);
+
+  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count();
+}
+
+// Indexes blocks in two stages: worker threads decode and hash batches of blocks straight from the
+// block store, and the calling thread merges the batches into the indices in height order. At most
+// a few batches per worker are in flight, so memory stays bounded on a full rebuild.
+void Blockchain::indexBlocks(uint32_t startHeight) {
+  assert(m_blockIndex.size() == startHeight);
+
+  struct DecodedBlock {
+    BlockEntry block;
+    crypto::Hash blockHash;
+    std::vector<crypto::Hash> transactionHashes;
+    uint64_t interest;
+  };
+
+  struct DecodedBatch {
+    std::vector<DecodedBlock> blocks;
+    std::chrono::steady_clock::duration decodeTime;
+    std::chrono::steady_clock::duration hashTime;
+  };
+
+  const uint32_t batchSize = 1000;
+  const uint32_t blockCount = static_cast<uint32_t>(m_blocks.size());
+
+  size_t workers = std::thread::hardware_concurrency();
+  if (workers == 0) {
+    workers = 2;
+  }
+
+  auto decodeBatch = [this, blockCount, batchSize](uint32_t first) {
+    DecodedBatch batch;
+    batch.decodeTime = std::chrono::steady_clock::duration::zero();
+    batch.hashTime = std::chrono::steady_clock::duration::zero();
+    batch.blocks.resize(std::min(batchSize, blockCount - first));
+    for (uint32_t i = 0; i < batch.blocks.size(); ++i) {
+      uint32_t height = first + i;
+      DecodedBlock& decoded = batch.blocks[i];
+
+      auto decodeStart = std::chrono::steady_clock::now();
+      // reads straight from the mapped store, bypassing its cache, so it is safe from several threads
+      m_blocks.decodePrefix(height, decoded.block);
+      auto hashStart = std::chrono::steady_clock::now();
+
+      decoded.blockHash = get_block_hash(decoded.block.bl);
+      decoded.interest = 0;
+      decoded.transactionHashes.reserve(decoded.block.transactions.size());
+      for (const TransactionEntry& transaction : decoded.block.transactions) {
+        decoded.transactionHashes.push_back(getObjectHash(transaction.tx));
+        decoded.interest += m_currency.calculateTotalTransactionInterest(transaction.tx, height); //block.height shows 0 wrongly sometimes apparently
       }
 
-      // process outputs
-      for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
-        const auto& out = transaction.tx.outputs[o];
-        if (out.target.type() == typeid(KeyOutput)) {
-          m_outputs[out.amount].push_back(std::make_pair<>(transactionIndex, o));
-        } else if (out.target.type() == typeid(MultisignatureOutput)) {
-          MultisignatureOutputUsage usage = { transactionIndex, o, false };
-          m_multisignatureOutputs[out.amount].push_back(usage);
+      auto hashEnd = std::chrono::steady_clock::now();
+      batch.decodeTime += hashStart - decodeStart;
+      batch.hashTime += hashEnd - hashStart;
+    }
+
+    return batch;
+  };
+
+  auto timePoint = std::chrono::steady_clock::now();
+  auto reportTimePoint = timePoint;
+  uint32_t reportHeight = startHeight;
+  std::chrono::steady_clock::duration decodeTime = std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration hashTime = std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration mergeTime = std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration waitTime = std::chrono::steady_clock::duration::zero();
+
+  std::deque<std::future<DecodedBatch>> pending;
+  uint32_t nextBatch = startHeight;
+  for (uint32_t b = startHeight; b < blockCount;) {
+    while (nextBatch < blockCount && pending.size() < workers * 2) {
+      pending.push_back(std::async(std::launch::async, decodeBatch, nextBatch));
+      nextBatch += std::min(batchSize, blockCount - nextBatch);
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+    DecodedBatch batch = pending.front().get();
+    pending.pop_front();
+    auto mergeStart = std::chrono::steady_clock::now();
+
+    for (const DecodedBlock& decoded : batch.blocks) {
+      const BlockEntry& block = decoded.block;
+      m_blockIndex.push(decoded.blockHash);
+      for (uint16_t t = 0; t < block.transactions.size(); ++t) {
+        const TransactionEntry& transaction = block.transactions[t];
+        TransactionIndex transactionIndex = { b, t };
+        m_transactionMap.insert(std::make_pair(decoded.transactionHashes[t], transactionIndex));
+
+        // process inputs
+        for (auto& i : transaction.tx.inputs) {
+          if (i.type() == typeid(KeyInput)) {
+            m_spent_keys.insert(::boost::get<KeyInput>(i).keyImage);
+          } else if (i.type() == typeid(MultisignatureInput)) {
+            auto out = ::boost::get<MultisignatureInput>(i);
+            m_multisignatureOutputs[out.amount][out.outputIndex].isUsed = true;
+          }
+        }
+
+        // process outputs
+        for (uint16_t o = 0; o < transaction.tx.outputs.size(); ++o) {
+          const auto& out = transaction.tx.outputs[o];
+          if (out.target.type() == typeid(KeyOutput)) {
+            KeyOutputEntry entry = { transactionIndex, o, ::boost::get<KeyOutput>(out.target).key, transaction.tx.unlockTime };
+            m_outputs[out.amount].push_back(entry);
+          } else if (out.target.type() == typeid(MultisignatureOutput)) {
+            MultisignatureOutputUsage usage = { transactionIndex, o, false };
+            m_multisignatureOutputs[out.amount].push_back(usage);
+          }
         }
       }
 
-      interest += m_currency.calculateTotalTransactionInterest(transaction.tx, b); //block.height); //block.height shows 0 wrongly sometimes apparently
+      pushToDepositIndex(block, decoded.interest);
+      ++b;
     }
 
-    pushToDepositIndex(block, interest);
+    // The table no longer matches the saved cache, the caller saves the cache again when indexing is done
+    if (m_spent_keys.pendingCount() >= KEY_IMAGES_MAX_PENDING && !m_spent_keys.merge(NULL_HASH)) {
+      logger(ERROR, BRIGHT_RED) << "Failed to write spent key images";
+      throw std::runtime_error("Blockchain::indexBlocks, failed to write spent key images");
+    }
+
+    auto mergeEnd = std::chrono::steady_clock::now();
+    decodeTime += batch.decodeTime;
+    hashTime += batch.hashTime;
+    mergeTime += mergeEnd - mergeStart;
+    waitTime += mergeStart - waitStart;
+
+    if (b - reportHeight >= 10 * batchSize || b == blockCount) {
+      std::chrono::duration<double> interval = mergeEnd - reportTimePoint;
+      logger(INFO, BRIGHT_WHITE) << "Rebuilding Cache for Height " << b << " of " << blockCount << ", " <<
+        static_cast<uint64_t>((b - reportHeight) / std::max(interval.count(), 0.001)) << " blocks/s";
+      reportHeight = b;
+      reportTimePoint = mergeEnd;
+    }
   }
 
-  std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
-  logger(INFO, BRIGHT_WHITE) << "Rebuilding internal structures took: " << duration.count();
+  typedef std::chrono::duration<double> Seconds;
+  Seconds total = std::chrono::steady_clock::now() - timePoint;
+  logger(INFO, BRIGHT_WHITE) << "Indexed " << blockCount - startHeight << " blocks in " << total.count() << " s using " << workers << " workers: " <<
+    "decode " << Seconds(decodeTime).count() << " s, hash " << Seconds(hashTime).count() << " s (summed over workers), " <<
+    "merge " << Seconds(mergeTime).count() << " s, merge waiting for workers " << Seconds(waitTime).count() << " s";
 }
 
+// The cache is serialized under the blockchain lock and written out after releasing it. The key image
+// table is still rewritten under the lock.
 bool Blockchain::storeCache() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  std::string cache;
+  uint64_t snapshot;
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
-  logger(INFO, BRIGHT_WHITE) << "Saving blockchain...";
-  BlockCacheSerializer ser(*this, getTailId(), logger.getLogger());
-  if (!ser.save(appendPath(m_config_folder, m_currency.blocksCacheFileName()))) {
+    logger(INFO, BRIGHT_WHITE) << "Saving blockchain...";
+    if (!m_spent_keys.merge(getTailId())) {
+      logger(ERROR, BRIGHT_RED) << "Failed to write spent key images";
+      return false;
+    }
+
+    BlockCacheSerializer ser(*this, getTailId(), logger.getLogger());
+    if (!ser.save(cache)) {
+      logger(ERROR, BRIGHT_RED) << "Failed to save blockchain cache";
+      return false;
+    }
+
+    // Pops below the new checkpoint are journaled from here on, before the cache reaches the disk
+    m_cacheJournal.reset(getTailId());
+    m_cacheCheckpointHeight = static_cast<uint32_t>(m_blocks.size());
+    m_cacheSaveFailed = false;
+    snapshot = ++m_cacheSnapshotCount;
+  }
+
+  if (!writeCache(cache, snapshot)) {
     logger(ERROR, BRIGHT_RED) << "Failed to save blockchain cache";
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    if (snapshot == m_cacheSnapshotCount) {
+      m_cacheSaveFailed = true;
+    }
+
+    return false;
+  }
+
+  logger(INFO, BRIGHT_GREEN) << "The Blockchain was successfully saved.";
+  return true;
+}
+
+// Saves may overlap once the blockchain lock is released, a snapshot older than the saved one is dropped
+bool Blockchain::writeCache(const std::string& cache, uint64_t snapshot) {
+  std::lock_guard<std::mutex> lk(m_cacheSaveLock);
+  if (snapshot < m_cacheSnapshotWritten) {
+    return true;
+  }
+
+  if (!replaceFile(appendPath(m_config_folder, m_currency.blocksCacheFileName()), cache)) {
     return false;
   }
-logger(INFO, BRIGHT_GREEN) << "The Blockchain was successfully saved.";
 
+  m_cacheSnapshotWritten = snapshot;
   return true;
 }
 
 bool Blockchain::deinit() {
-  storeCache();
+  {
+    // Blocks above the checkpoint are indexed again on startup, save only when that gets expensive
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    if (cacheCheckpointIsStale()) {
+      storeCache();
+    }
+
+    m_cacheJournal.close();
+    m_spent_keys.close();
+  }
+
+  {
+    // Destroying the futures waits for the workers still hashing
+    std::lock_guard<std::mutex> lk(m_preparedBlocksLock);
+    m_preparedProofsOfWork.clear();
+    m_preparationWorkers.clear();
+  }
   
     if (m_blockchainIndexesEnabled) {
     storeBlockchainIndices();
   }
+
+  RecursiveSharedMutex::Statistics lockStatistics = m_blockchain_lock.statistics();
+  logger(INFO) << "Blockchain lock: " << lockStatistics.sharedLocks << " shared locks, " << lockStatistics.sharedWaits << " waited " <<
+    lockStatistics.sharedWaitMicroseconds / 1000 << " ms; " << lockStatistics.exclusiveLocks << " exclusive locks, " <<
+    lockStatistics.exclusiveWaits << " waited " << lockStatistics.exclusiveWaitMicroseconds / 1000 << " ms";
+  logger(INFO) << "Serialized block cache: " << m_blobCache.hits() << " hits, " << m_blobCache.misses() << " misses";
   
   assert(m_messageQueueList.empty());
   return true;
@@ -602,10 +883,19 @@ bool Blockchain::deinit() {
 bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
   std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   m_blocks.clear();
+  m_blobCache.clear();
+  m_unlockedOutputCounts.clear();
+  m_cacheJournal.reset(NULL_HASH);
+  m_cacheCheckpointHeight = 0;
+  m_cacheSaveFailed = false;
   m_blockIndex.clear();
   m_transactionMap.clear();
 
-  m_spent_keys.clear();
+  if (!m_spent_keys.clear()) {
+    logger(ERROR, BRIGHT_RED) << "Failed to clear spent key images";
+    return false;
+  }
+
   m_alternative_chains.clear();
   m_outputs.clear();
 
@@ -621,24 +911,24 @@ bool Blockchain::resetAndSetGenesisBlock(const Block& b) {
 
 crypto::Hash Blockchain::getTailId(uint32_t& height) {
   assert(!m_blocks.empty());
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   height = getCurrentBlockchainHeight() - 1;
   return getTailId();
 }
 
 crypto::Hash Blockchain::getTailId() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_blocks.empty() ? NULL_HASH : m_blockIndex.getTailId();
 }
 
 std::vector<crypto::Hash> Blockchain::buildSparseChain() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(m_blockIndex.size() != 0);
   return doBuildSparseChain(m_blockIndex.getTailId());
 }
 
 std::vector<crypto::Hash> Blockchain::buildSparseChain(const crypto::Hash& startBlockId) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(haveBlock(startBlockId));
   return doBuildSparseChain(startBlockId);
 }
@@ -675,18 +965,18 @@ std::vector<crypto::Hash> Blockchain::doBuildSparseChain(const crypto::Hash& sta
 }
 
 crypto::Hash Blockchain::getBlockIdByHeight(uint32_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   assert(height < m_blockIndex.size());
   return m_blockIndex.getBlockId(height);
 }
 
 bool Blockchain::getBlockByHash(const crypto::Hash& blockHash, Block& b) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   uint32_t height = 0;
 
   if (m_blockIndex.getBlockHeight(blockHash, height)) {
-    b = m_blocks[height].bl;
+    loadBlock(height, b);
     return true;
   }
 
@@ -702,12 +992,12 @@ bool Blockchain::getBlockByHash(const crypto::Hash& blockHash, Block& b) {
 }
 
 bool Blockchain::getBlockHeight(const crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lock(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lock(m_blockchain_lock);
   return m_blockIndex.getBlockHeight(blockId, blockHeight);
 }
 
 difficulty_type Blockchain::getDifficultyForNextBlock() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   std::vector<uint64_t> timestamps;
   std::vector<difficulty_type> commulative_difficulties;
 
@@ -739,7 +1029,7 @@ uint64_t Blockchain::getBlockTimestamp(uint32_t height) {
 }
 
 uint64_t Blockchain::getCoinsInCirculation() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blocks.empty()) {
     return 0;
   } else {
@@ -748,13 +1038,13 @@ uint64_t Blockchain::getCoinsInCirculation() {
 }
 
 uint64_t Blockchain::coinsEmittedAtHeight(uint64_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   const auto& block = m_blocks[height];
   return block.already_generated_coins;
 }
 
 difficulty_type Blockchain::difficultyAtHeight(uint64_t height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   const auto& current = m_blocks[height];
   if (height < 1) {
     return current.cumulative_difficulty;
@@ -1076,7 +1366,7 @@ bool Blockchain::validate_miner_transaction(const Block& b, uint32_t height, siz
 }
 
 bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(from_height < m_blocks.size())) {
     logger(ERROR, BRIGHT_RED)
       << "Internal error: get_backward_blocks_sizes called with from_height="
@@ -1094,7 +1384,7 @@ bool Blockchain::getBackwardBlocksSize(size_t from_height, std::vector<size_t>&
 }
 
 bool Blockchain::get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!m_blocks.size()) {
     return true;
   }
@@ -1111,7 +1401,7 @@ bool Blockchain::complete_timestamps_vector(uint64_t start_top_height, std::vect
     return true;
   }
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   size_t need_elements = m_currency.timestampCheckWindow() - timestamps.size();
 
   if (!(start_top_height < m_blocks.size())) {
@@ -1338,15 +1628,16 @@ bool Blockchain::handle_alternative_block(const Block& b, const crypto::Hash& id
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
 
-  for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+  for (uint32_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
+    blocks.push_back(Block());
+    loadBlock(i, blocks.back());
     std::list<crypto::Hash> missed_ids;
-    getTransactions(m_blocks[i].bl.transactionHashes, txs, missed_ids);
+    getTransactions(blocks.back().transactionHashes, txs, missed_ids);
     if (!(!missed_ids.size())) {
       logger(ERROR, BRIGHT_RED) << "have missed transactions in own block in main blockchain";
       return false;
@@ -1357,20 +1648,60 @@ bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Bloc
 }
 
 bool Blockchain::getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_offset >= m_blocks.size()) {
     return false;
   }
 
   for (uint32_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++) {
-    blocks.push_back(m_blocks[i].bl);
+    blocks.push_back(Block());
+    loadBlock(i, blocks.back());
   }
 
   return true;
 }
 
+std::shared_ptr<const SerializedBlock> Blockchain::getSerializedBlock(uint32_t height) {
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  if (height >= m_blocks.size()) {
+    return nullptr;
+  }
+
+  crypto::Hash blockHash = m_blockIndex.getBlockId(height);
+  std::shared_ptr<const SerializedBlock> cached = m_blobCache.get(height, blockHash);
+  if (cached) {
+    return cached;
+  }
+
+  const BlockEntry& block = m_blocks[height];
+  std::shared_ptr<SerializedBlock> serialized = std::make_shared<SerializedBlock>();
+  serialized->blockHash = blockHash;
+  serialized->timestamp = block.bl.timestamp;
+  serialized->block = asString(toBinaryArray(block.bl));
+  for (size_t i = 1; i < block.transactions.size(); ++i) {
+    serialized->transactions.push_back(asString(toBinaryArray(block.transactions[i].tx)));
+    serialized->transactionPrefixes.push_back({ block.bl.transactionHashes[i - 1], block.transactions[i].tx });
+  }
+
+  m_blobCache.put(height, serialized);
+  return serialized;
+}
+
+void Blockchain::cacheSerializedBlock(const BlockEntry& block, const crypto::Hash& blockHash, const std::vector<BinaryArray>& transactionBlobs) {
+  std::shared_ptr<SerializedBlock> serialized = std::make_shared<SerializedBlock>();
+  serialized->blockHash = blockHash;
+  serialized->timestamp = block.bl.timestamp;
+  serialized->block = asString(toBinaryArray(block.bl));
+  for (size_t i = 0; i < transactionBlobs.size(); ++i) {
+    serialized->transactions.push_back(asString(transactionBlobs[i]));
+    serialized->transactionPrefixes.push_back({ block.bl.transactionHashes[i], block.transactions[i + 1].tx });
+  }
+
+  m_blobCache.put(block.height, serialized);
+}
+
 bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) { //Deprecated. Should be removed with CryptoNoteProtocolHandler.
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   rsp.current_blockchain_height = getCurrentBlockchainHeight();
   std::list<Block> blocks;
   getBlocks(arg.blocks, blocks, rsp.missed_ids);
@@ -1402,7 +1733,7 @@ bool Blockchain::handleGetObjects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTI
 }
 
 bool Blockchain::getTransactionsWithOutputGlobalIndexes(const std::vector<crypto::Hash>& txs_ids, std::list<crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs) {
-    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   for (const auto& tx_id : txs_ids) {
     auto it = m_transactionMap.find(tx_id);
@@ -1423,7 +1754,7 @@ bool Blockchain::getTransactionsWithOutputGlobalIndexes(const std::vector<crypto
 }
 
 bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   for (auto& alt_bl : m_alternative_chains) {
     blocks.push_back(alt_bl.second.bl);
   }
@@ -1432,48 +1763,57 @@ bool Blockchain::getAlternativeBlocks(std::list<Block>& blocks) {
 }
 
 uint32_t Blockchain::getAlternativeBlocksCount() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return static_cast<uint32_t>(m_alternative_chains.size());
 }
 
-bool Blockchain::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  const Transaction& tx = transactionByIndex(amount_outs[i].first).tx;
-  if (!(tx.outputs.size() > amount_outs[i].second)) {
-    logger(ERROR, BRIGHT_RED) << "internal error: in global outs index, transaction out index="
-      << amount_outs[i].second << " more than transaction outputs = " << tx.outputs.size() << ", for tx id = " << getObjectHash(tx); return false;
-  }
-  if (!(tx.outputs[amount_outs[i].second].target.type() == typeid(KeyOutput))) { logger(ERROR, BRIGHT_RED) << "unknown tx out type"; return false; }
-
-  //check if transaction is unlocked
-  if (!is_tx_spendtime_unlocked(tx.unlockTime))
+bool Blockchain::add_out_to_get_random_outs(std::vector<KeyOutputEntry>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs, uint64_t amount, size_t i) {
+  //check if transaction is unlocked, almost all outputs have no unlock time
+  if (amount_outs[i].unlockTime != 0 && !is_tx_spendtime_unlocked(amount_outs[i].unlockTime))
     return false;
 
   COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry& oen = *result_outs.outs.insert(result_outs.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::out_entry());
   oen.global_amount_index = static_cast<uint32_t>(i);
-  oen.out_key = boost::get<KeyOutput>(tx.outputs[amount_outs[i].second].target).key;
+  oen.out_key = amount_outs[i].key;
   return true;
 }
 
-size_t Blockchain::find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-  if (amount_outs.empty()) {
-    return 0;
+void Blockchain::rebuildUnlockedOutputCounts() {
+  m_unlockedOutputCounts.clear();
+  uint32_t height = static_cast<uint32_t>(m_blocks.size());
+  if (height < m_currency.minedMoneyUnlockWindow()) {
+    return;
   }
 
-  size_t i = amount_outs.size();
-  do {
-    --i;
-    if (amount_outs[i].first.block + m_currency.minedMoneyUnlockWindow() <= getCurrentBlockchainHeight()) {
-      return i + 1;
+  // outputs are appended in block order, so the unlocked ones are the ones up to the last unlocked block
+  uint32_t lastUnlockedBlock = height - static_cast<uint32_t>(m_currency.minedMoneyUnlockWindow());
+  for (const auto& amountOutputs : m_outputs) {
+    auto end = std::upper_bound(amountOutputs.second.begin(), amountOutputs.second.end(), lastUnlockedBlock,
+      [](uint32_t block, const KeyOutputEntry& output) { return block < output.transactionIndex.block; });
+    if (end != amountOutputs.second.begin()) {
+      m_unlockedOutputCounts[amountOutputs.first] = static_cast<uint32_t>(end - amountOutputs.second.begin());
     }
-  } while (i != 0);
+  }
+}
 
-  return 0;
+// Blocks leave the unlock window one at a time as the chain grows, so only the outputs of that block move the boundary
+void Blockchain::updateUnlockedOutputCounts(uint32_t blockHeight, bool unlock) {
+  const BlockEntry& block = m_blocks[blockHeight];
+  for (const auto& transaction : block.transactions) {
+    for (const auto& output : transaction.tx.outputs) {
+      if (output.target.type() == typeid(KeyOutput)) {
+        if (unlock) {
+          ++m_unlockedOutputCounts[output.amount];
+        } else {
+          --m_unlockedOutputCounts[output.amount];
+        }
+      }
+    }
+  }
 }
 
 bool Blockchain::getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   for (uint64_t amount : req.amounts) {
     COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount& result_outs = *res.outs.insert(res.outs.end(), COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount());
@@ -1485,11 +1825,12 @@ bool Blockchain::getRandomOutsByAmount(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_
       continue;//actually this is strange situation, wallet should use some real outs when it lookup for some mix, so, at least one out for this amount should exist
     }
 
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs = it->second;
+    std::vector<KeyOutputEntry>& amount_outs = it->second;
     //it is not good idea to use top fresh outs, because it increases possibility of transaction canceling on split
-    //lets find upper bound of not fresh outs
-    size_t up_index_limit = find_end_of_allowed_index(amount_outs);
-    if (!(up_index_limit <= amount_outs.size())) { logger(ERROR, BRIGHT_RED) << "internal error: find_end_of_allowed_index returned wrong index=" << up_index_limit << ", with amount_outs.size = " << amount_outs.size(); return false; }
+    //outputs past the unlock window are a prefix of amount_outs, its length is maintained as blocks are pushed and popped
+    auto unlockedCount = m_unlockedOutputCounts.find(amount);
+    size_t up_index_limit = unlockedCount == m_unlockedOutputCounts.end() ? 0 : unlockedCount->second;
+    if (!(up_index_limit <= amount_outs.size())) { logger(ERROR, BRIGHT_RED) << "internal error: unlocked outputs count=" << up_index_limit << ", with amount_outs.size = " << amount_outs.size(); return false; }
 
     if (up_index_limit > 0) {
       ShuffleGenerator<size_t, crypto::random_engine<size_t>> generator(up_index_limit);
@@ -1505,7 +1846,7 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<crypto::Hash>& q
   assert(!qblock_ids.empty());
   assert(qblock_ids.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   uint32_t blockIndex;
   // assert above guarantees that method returns true
   m_blockIndex.findSupplement(qblock_ids, blockIndex);
@@ -1513,7 +1854,7 @@ uint32_t Blockchain::findBlockchainSupplement(const std::vector<crypto::Hash>& q
 }
 
 uint64_t Blockchain::blockDifficulty(size_t i) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (!(i < m_blocks.size())) { logger(ERROR, BRIGHT_RED) << "wrong block index i = " << i << " at Blockchain::block_difficulty()"; return false; }
   if (i == 0)
     return m_blocks[i].cumulative_difficulty;
@@ -1523,7 +1864,7 @@ uint64_t Blockchain::blockDifficulty(size_t i) {
 
 void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (start_index >= m_blocks.size()) {
     logger(INFO, BRIGHT_WHITE) <<
       "Wrong starter index set: " << start_index << ", expected max index " << m_blocks.size() - 1;
@@ -1541,7 +1882,7 @@ void Blockchain::print_blockchain(uint64_t start_index, uint64_t end_index) {
 
 void Blockchain::print_blockchain_index() {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   std::vector<crypto::Hash> blockIds = m_blockIndex.getBlockIds(0, std::numeric_limits<uint32_t>::max());
   logger(INFO, BRIGHT_WHITE) << "Current blockchain index:";
@@ -1555,13 +1896,13 @@ void Blockchain::print_blockchain_index() {
 
 void Blockchain::print_blockchain_outs(const std::string& file) {
   std::stringstream ss;
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   for (const outputs_container::value_type& v : m_outputs) {
-    const std::vector<std::pair<TransactionIndex, uint16_t>>& vals = v.second;
+    const std::vector<KeyOutputEntry>& vals = v.second;
     if (!vals.empty()) {
       ss << "amount: " << v.first << ENDL;
       for (size_t i = 0; i != vals.size(); i++) {
-        ss << "\t" << getObjectHash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+        ss << "\t" << getObjectHash(transactionByIndex(vals[i].transactionIndex).tx) << ": " << vals[i].outputIndex << ENDL;
       }
     }
   }
@@ -1581,7 +1922,7 @@ std::vector<crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
   assert(!remoteBlockIds.empty());
   assert(remoteBlockIds.back() == m_blockIndex.getBlockId(0));
 
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   totalBlockCount = getCurrentBlockchainHeight();
   startBlockIndex = findBlockchainSupplement(remoteBlockIds);
 
@@ -1589,7 +1930,7 @@ std::vector<crypto::Hash> Blockchain::findBlockchainSupplement(const std::vector
 }
 
 bool Blockchain::haveBlock(const crypto::Hash& id) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   if (m_blockIndex.hasBlock(id))
     return true;
 
@@ -1600,12 +1941,12 @@ bool Blockchain::haveBlock(const crypto::Hash& id) {
 }
 
 size_t Blockchain::getTotalTransactions() {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_transactionMap.size();
 }
 
 bool Blockchain::getTransactionOutputGlobalIndexes(const crypto::Hash& tx_id, std::vector<uint32_t>& indexs) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   auto it = m_transactionMap.find(tx_id);
   if (it == m_transactionMap.end()) {
     logger(WARNING, YELLOW) << "warning: get_tx_outputs_gindexs failed to find transaction with id = " << tx_id;
@@ -1623,7 +1964,7 @@ bool Blockchain::getTransactionOutputGlobalIndexes(const crypto::Hash& tx_id, st
 }
 
 bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, MultisignatureOutput& out) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   auto it = m_multisignatureOutputs.find(amount);
   if (it == m_multisignatureOutputs.end()) {
     return false;
@@ -1646,7 +1987,7 @@ bool Blockchain::get_out_by_msig_gindex(uint64_t amount, uint64_t gindex, Multis
 
 
 bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t& max_used_block_height, crypto::Hash& max_used_block_id, BlockInfo* tail) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   if (tail)
     tail->id = getTailId(tail->height);
@@ -1670,12 +2011,13 @@ bool Blockchain::haveTransactionKeyImagesAsSpent(const Transaction &tx) {
   return false;
 }
 
-bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height) {
+bool Blockchain::checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height, RingSignatureBatch* signatureBatch, size_t transactionIndex) {
   crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix*>(&tx));
-  return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height);
+  return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height, signatureBatch, transactionIndex);
 }
 
-bool Blockchain::checkTransactionInputs(const Transaction& tx, const crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height) {
+bool Blockchain::checkTransactionInputs(const Transaction& tx, const crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height,
+  RingSignatureBatch* signatureBatch, size_t transactionIndex) {
   size_t inputIndex = 0;
   if (pmax_used_block_height) {
     *pmax_used_block_height = 0;
@@ -1695,7 +2037,7 @@ bool Blockchain::checkTransactionInputs(const Transaction& tx, const crypto::Has
       }
 
       if (!isInCheckpointZone(getCurrentBlockchainHeight())) {
-        if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height)) {
+        if (!check_tx_input(in_to_key, tx_prefix_hash, tx.signatures[inputIndex], pmax_used_block_height, signatureBatch, transactionIndex, inputIndex)) {
           logger(INFO, BRIGHT_WHITE) <<
             "Failed to check input in transaction " << transactionHash;
           return false;
@@ -1740,39 +2082,45 @@ bool Blockchain::is_tx_spendtime_unlocked(uint64_t unlock_time) {
   return false;
 }
 
-bool Blockchain::check_tx_input(const KeyInput& txin, const crypto::Hash& tx_prefix_hash, const std::vector<crypto::Signature>& sig, uint32_t* pmax_related_block_height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+bool Blockchain::getKeyInputOutputKeys(const KeyInput& txin, std::vector<const crypto::PublicKey*>& outputKeys, uint32_t* pmax_related_block_height) {
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  auto it = m_outputs.find(txin.amount);
+  if (it == m_outputs.end() || txin.outputIndexes.empty()) {
+    return false;
+  }
 
-  struct outputs_visitor {
-    std::vector<const crypto::PublicKey *>& m_results_collector;
-    Blockchain& m_bch;
-    LoggerRef logger;
-    outputs_visitor(std::vector<const crypto::PublicKey *>& results_collector, Blockchain& bch, ILogger& logger) :m_results_collector(results_collector), m_bch(bch), logger(logger, "outputs_visitor") {
+  const std::vector<KeyOutputEntry>& amountOutputs = it->second;
+  std::vector<uint32_t> absoluteOffsets = relative_output_offsets_to_absolute(txin.outputIndexes);
+  for (uint32_t i : absoluteOffsets) {
+    if (i >= amountOutputs.size()) {
+      logger(INFO) << "Wrong index in transaction inputs: " << i << ", expected maximum " << amountOutputs.size() - 1;
+      return false;
     }
 
-    bool handle_output(const Transaction& tx, const TransactionOutput& out, size_t transactionOutputIndex) {
-      //check tx unlock time
-      if (!m_bch.is_tx_spendtime_unlocked(tx.unlockTime)) {
-        logger(INFO, BRIGHT_WHITE) <<
-          "One of outputs for one of inputs have wrong tx.unlockTime = " << tx.unlockTime;
-        return false;
-      }
+    const KeyOutputEntry& output = amountOutputs[i];
+    if (!is_tx_spendtime_unlocked(output.unlockTime)) {
+      logger(INFO, BRIGHT_WHITE) <<
+        "One of outputs for one of inputs have wrong tx.unlockTime = " << output.unlockTime;
+      return false;
+    }
 
-      if (out.target.type() != typeid(KeyOutput)) {
-        logger(INFO, BRIGHT_WHITE) <<
-          "Output have wrong type id, which=" << out.target.which();
-        return false;
-      }
+    outputKeys.push_back(&output.key);
+  }
 
-      m_results_collector.push_back(&boost::get<KeyOutput>(out.target).key);
-      return true;
-    }
-  };
+  if (pmax_related_block_height != NULL && *pmax_related_block_height < amountOutputs[absoluteOffsets.back()].transactionIndex.block) {
+    *pmax_related_block_height = amountOutputs[absoluteOffsets.back()].transactionIndex.block;
+  }
+
+  return true;
+}
+
+bool Blockchain::check_tx_input(const KeyInput& txin, const crypto::Hash& tx_prefix_hash, const std::vector<crypto::Signature>& sig, uint32_t* pmax_related_block_height,
+  RingSignatureBatch* signatureBatch, size_t transactionIndex, size_t inputIndex) {
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   //check ring signature
   std::vector<const crypto::PublicKey *> output_keys;
-  outputs_visitor vi(output_keys, *this, logger.getLogger());
-  if (!scanOutputKeysForIndexes(txin, vi, pmax_related_block_height)) {
+  if (!getKeyInputOutputKeys(txin, output_keys, pmax_related_block_height)) {
     logger(INFO, BRIGHT_WHITE) <<
       "Failed to get output keys for tx with amount = " << m_currency.formatAmount(txin.amount) <<
       " and count indexes " << txin.outputIndexes.size();
@@ -1795,13 +2143,24 @@ bool Blockchain::check_tx_input(const KeyInput& txin, const crypto::Hash& tx_pre
     return true;
   }
 
-  static const crypto::KeyImage I = { {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
-  static const crypto::KeyImage L = { {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
-  if (!(scalarmultKey(txin.keyImage, L) == I)) {
+  // Transactions are checked when they enter the pool, again each time the pool revalidates them
+  // and once more in their block, the signature only the first time
+  crypto::Hash cacheKey = SignatureCache::makeKey(tx_prefix_hash, inputIndex, output_keys, sig);
+  if (m_signatureCache.contains(cacheKey)) {
+    return true;
+  }
+
+  if (signatureBatch != NULL) {
+    signatureBatch->add(transactionIndex, inputIndex, tx_prefix_hash, txin.keyImage, output_keys, sig);
+    return true;
+  }
+
+  if (!checkKeyInputSignature(tx_prefix_hash, txin.keyImage, output_keys.data(), output_keys.size(), sig.data())) {
     return false;
   }
 
-  return crypto::check_ring_signature(tx_prefix_hash, txin.keyImage, output_keys, sig.data());
+  m_signatureCache.insert(cacheKey);
+  return true;
 }
 
 uint64_t Blockchain::get_adjusted_time() {
@@ -1931,6 +2290,7 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
   }
 
   bool add_result;
+  bool saveCache;
 
   // to avoid deadlock lets lock tx_pool for whole add/reorganize process
   {
@@ -1956,6 +2316,13 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
         sendMessage(BlockchainMessage(NewBlockMessage(id)));
       }
     }
+
+    saveCache = add_result && bvc.m_added_to_main_chain && cacheCheckpointIsStale();
+  }
+
+  // Moves the checkpoint once replaying from it gets expensive, the pool is unlocked while the cache is written
+  if (saveCache) {
+    storeCache();
   }
 
   if (add_result && bvc.m_added_to_main_chain) {
@@ -1965,10 +2332,125 @@ bool Blockchain::addNewBlock(const Block& bl_, block_verification_context& bvc)
   return add_result;
 }
 
+// The long hash depends on the block alone, so it is computed for a whole batch of queued blocks on
+// worker threads while the blocks ahead of them are pushed. Blocks in the checkpoint zone skip it.
+void Blockchain::prepareBlocks(std::vector<Block> blocks) {
+  struct PreparationJob {
+    std::vector<Block> blocks;
+    std::vector<std::promise<crypto::Hash>> proofsOfWork;
+    std::atomic<size_t> next;
+  };
+
+  if (blocks.empty()) {
+    return;
+  }
+
+  size_t first = 0;
+  {
+    SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    uint32_t height;
+    if (!m_blockIndex.getBlockHeight(blocks.front().previousBlockHash, height)) {
+      return;
+    }
+
+    while (first < blocks.size() && m_checkpoints.is_in_checkpoint_zone(height + 1 + static_cast<uint32_t>(first))) {
+      ++first;
+    }
+  }
+
+  if (first == blocks.size()) {
+    return;
+  }
+
+  auto job = std::make_shared<PreparationJob>();
+  job->blocks.assign(std::make_move_iterator(blocks.begin() + first), std::make_move_iterator(blocks.end()));
+  job->proofsOfWork.resize(job->blocks.size());
+  job->next = 0;
+
+  size_t workers = std::thread::hardware_concurrency();
+  if (workers == 0) {
+    workers = 2;
+  }
+
+  workers = std::min(workers, (job->blocks.size() + PROOF_OF_WORK_WAYS - 1) / PROOF_OF_WORK_WAYS);
+
+  std::lock_guard<std::mutex> lk(m_preparedBlocksLock);
+  // Whatever is done by now belongs to blocks that were never pushed
+  for (auto it = m_preparedProofsOfWork.begin(); it != m_preparedProofsOfWork.end();) {
+    if (it->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+      it = m_preparedProofsOfWork.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  m_preparationWorkers.erase(std::remove_if(m_preparationWorkers.begin(), m_preparationWorkers.end(), [](const std::future<void>& worker) {
+    return worker.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+  }), m_preparationWorkers.end());
+
+  for (size_t i = 0; i < job->blocks.size(); ++i) {
+    m_preparedProofsOfWork[get_block_hash(job->blocks[i])] = job->proofsOfWork[i].get_future().share();
+  }
+
+  for (size_t i = 0; i < workers; ++i) {
+    m_preparationWorkers.push_back(std::async(std::launch::async, [job] {
+      crypto::cn_context contexts[PROOF_OF_WORK_WAYS];
+      for (size_t index = job->next.fetch_add(PROOF_OF_WORK_WAYS); index < job->blocks.size(); index = job->next.fetch_add(PROOF_OF_WORK_WAYS)) {
+        size_t count = std::min(PROOF_OF_WORK_WAYS, job->blocks.size() - index);
+        BinaryArray blobs[PROOF_OF_WORK_WAYS];
+        crypto::Hash proofsOfWork[PROOF_OF_WORK_WAYS];
+        bool hashed = true;
+        for (size_t i = 0; i < count; ++i) {
+          hashed = hashed && job->blocks[index + i].majorVersion == job->blocks[index].majorVersion &&
+            get_block_hashing_blob(job->blocks[index + i], blobs[i]);
+        }
+
+        if (hashed) {
+          get_block_longhashes(contexts, count, job->blocks[index].majorVersion, blobs, proofsOfWork);
+        } else {
+          for (size_t i = 0; i < count; ++i) {
+            if (!get_block_longhash(contexts[0], job->blocks[index + i], proofsOfWork[i])) {
+              proofsOfWork[i] = NULL_HASH;
+            }
+          }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+          job->proofsOfWork[index + i].set_value(proofsOfWork[i]);
+        }
+      }
+    }));
+  }
+}
+
+bool Blockchain::checkProofOfWork(const Block& block, const crypto::Hash& blockHash, difficulty_type currentDifficulty, crypto::Hash& proofOfWork) {
+  std::shared_future<crypto::Hash> prepared;
+  {
+    std::lock_guard<std::mutex> lk(m_preparedBlocksLock);
+    auto it = m_preparedProofsOfWork.find(blockHash);
+    if (it != m_preparedProofsOfWork.end()) {
+      prepared = it->second;
+      m_preparedProofsOfWork.erase(it);
+    }
+  }
+
+  if (prepared.valid() && prepared.get() != NULL_HASH) {
+    proofOfWork = prepared.get();
+    return check_hash(proofOfWork, currentDifficulty);
+  }
+
+  return m_currency.checkProofOfWork(m_cn_context, block, currentDifficulty, proofOfWork);
+}
+
 const Blockchain::TransactionEntry& Blockchain::transactionByIndex(TransactionIndex index) {
   return m_blocks[index.block].transactions[index.transaction];
 }
 
+// Decodes only the block part of the entry, transactions of the block are left in the store
+void Blockchain::loadBlock(uint32_t height, Block& block) {
+  m_blocks.decodePrefix(height, block);
+}
+
 bool Blockchain::pushBlock(const Block& blockData, const crypto::Hash& id, block_verification_context& bvc, uint32_t height) {
   std::vector<Transaction> transactions;
   if (!loadTransactions(blockData, transactions, height)) {
@@ -1981,6 +2463,7 @@ bool Blockchain::pushBlock(const Block& blockData, const crypto::Hash& id, block
     return false;
   }
 
+  m_tx_pool.on_blockchain_inc(m_blocks.size(), id, transactions);
   return true;
 }
 
@@ -2048,7 +2531,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       return false;
     }
   } else {
-    if (!m_currency.checkProofOfWork(m_cn_context, blockData, currentDifficulty, proof_of_work)) {
+    if (!checkProofOfWork(blockData, blockHash, currentDifficulty, proof_of_work)) {
       logger(INFO, BRIGHT_WHITE) <<
         "Block " << blockHash << ", has too weak proof of work: " << common::podToHex(proof_of_work) << ", expected difficulty: " << currentDifficulty << " MajorVersion: " << std::to_string(blockData.majorVersion);
       bvc.m_verification_failed = true;
@@ -2079,12 +2562,17 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   size_t cumulative_block_size = coinbase_blob_size;
   uint64_t fee_summary = 0;
   uint64_t interestSummary = 0;
+  RingSignatureBatch signatureBatch;
+  uint64_t signatureCacheHits = m_signatureCache.getStatistics().hits;
+  std::vector<BinaryArray> transactionBlobs;
+  transactionBlobs.reserve(transactions.size());
 
   for (size_t i = 0; i < transactions.size(); ++i) {
     const crypto::Hash& tx_id = blockData.transactionHashes[i];
     block.transactions.resize(block.transactions.size() + 1);
     block.transactions.back().tx = transactions[i];
-    size_t blob_size = toBinaryArray(transactions[i]).size();
+    transactionBlobs.push_back(toBinaryArray(transactions[i]));
+    size_t blob_size = transactionBlobs.back().size();
 
     uint64_t in_amount = m_currency.getTransactionAllInputsAmount(transactions[i], block.height);
 	  uint64_t out_amount = getOutputAmount(transactions[i]);
@@ -2096,7 +2584,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
       logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " can't contain transaction " << tx_id << " because it has invalid version " << transactions[i].version;
     }
 
-    if (!checkTransactionInputs(transactions[i])) {
+    if (!checkTransactionInputs(transactions[i], NULL, &signatureBatch, i)) {
       isTransactionValid = false;
       logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id;
     }
@@ -2123,6 +2611,25 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     interestSummary += m_currency.calculateTotalTransactionInterest(transactions[i], block.height);
   }
 
+  // Ring signatures were only collected above, they need no chain state and are checked in parallel
+  auto signatureCheckStart = std::chrono::steady_clock::now();
+  size_t signatureThreads = std::thread::hardware_concurrency();
+  if (signatureThreads == 0) {
+    signatureThreads = 2;
+  }
+
+  RingSignatureBatch::Failure signatureFailure;
+  if (!signatureBatch.verify(signatureThreads, signatureFailure)) {
+    logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has invalid ring signature in input " << signatureFailure.inputIndex <<
+      " of transaction " << blockData.transactionHashes[signatureFailure.transactionIndex];
+    bvc.m_verification_failed = true;
+    popTransactions(block, minerTransactionHash);
+    return false;
+  }
+
+  auto signature_checking_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - signatureCheckStart).count();
+  signatureCacheHits = m_signatureCache.getStatistics().hits - signatureCacheHits;
+
   if (!checkCumulativeBlockSize(blockHash, cumulative_block_size, block.height)) {
     bvc.m_verification_failed = true;
     return false;
@@ -2148,6 +2655,7 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
 
   pushBlock(block);
   pushToDepositIndex(block, interestSummary);
+  cacheSerializedBlock(block, blockHash, transactionBlobs);
 
   auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
 
@@ -2157,7 +2665,8 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
     << ENDL << "HEIGHT " << block.height << ", difficulty:\t" << currentDifficulty
     << ENDL << "block reward: " << m_currency.formatAmount(reward) << ", fee = " << m_currency.formatAmount(fee_summary)
     << ", coinbase_blob_size: " << coinbase_blob_size << ", cumulative size: " << cumulative_block_size
-    << ", " << block_processing_time << "(" << target_calculating_time << "/" << longhash_calculating_time << ")ms";
+    << ", " << block_processing_time << "(" << target_calculating_time << "/" << longhash_calculating_time << "/" << signature_checking_time << ")ms"
+    << ", " << signatureBatch.size() << " ring signatures, " << signatureCacheHits << " verified in pool";
 
   bvc.m_added_to_main_chain = true;
 
@@ -2169,18 +2678,22 @@ bool Blockchain::pushBlock(const Block& blockData, const std::vector<Transaction
   return true;
 }
 
+std::string Blockchain::getSignatureCacheStatistics() const {
+  return m_signatureCache.toString();
+}
+
 uint64_t Blockchain::fullDepositAmount() const {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_depositIndex.fullDepositAmount();
 }
 
 uint64_t Blockchain::depositAmountAtHeight(size_t height) const {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_depositIndex.depositAmountAtHeight(static_cast<DepositIndex::DepositHeight>(height));
 }
 
 uint64_t Blockchain::depositInterestAtHeight(size_t height) const {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_depositIndex.depositInterestAtHeight(static_cast<DepositIndex::DepositHeight>(height));
 }
 
@@ -2217,6 +2730,10 @@ bool Blockchain::pushBlock(BlockEntry& block) {
   m_timestampIndex.add(block.bl.timestamp, blockHash);
   m_generatedTransactionsIndex.add(block.bl);
 
+  if (m_blocks.size() >= m_currency.minedMoneyUnlockWindow()) {
+    updateUnlockedOutputCounts(static_cast<uint32_t>(m_blocks.size() - m_currency.minedMoneyUnlockWindow()), true);
+  }
+
   assert(m_blockIndex.size() == m_blocks.size());
 
   return true;
@@ -2243,7 +2760,13 @@ void Blockchain::popBlock(const crypto::Hash& blockHash) {
   m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
   m_generatedTransactionsIndex.remove(m_blocks.back().bl);
 
+  if (m_blocks.size() >= m_currency.minedMoneyUnlockWindow()) {
+    updateUnlockedOutputCounts(static_cast<uint32_t>(m_blocks.size() - m_currency.minedMoneyUnlockWindow()), false);
+  }
+
   m_depositIndex.popBlock();
+  journalLastBlockPop(blockHash);
+  m_blobCache.invalidateFrom(static_cast<uint32_t>(m_blocks.size() - 1));
   m_blocks.pop_back();
   m_blockIndex.pop();
 
@@ -2251,7 +2774,8 @@ void Blockchain::popBlock(const crypto::Hash& blockHash) {
 
   m_upgradeDetectorV2.blockPopped();
   m_upgradeDetectorV3.blockPopped();
-    
+
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), getTailId());
 }
 
 bool Blockchain::pushTransaction(BlockEntry& block, const crypto::Hash& transactionHash, TransactionIndex transactionIndex) {
@@ -2275,8 +2799,7 @@ bool Blockchain::pushTransaction(BlockEntry& block, const crypto::Hash& transact
 
   for (size_t i = 0; i < transaction.tx.inputs.size(); ++i) {
     if (transaction.tx.inputs[i].type() == typeid(KeyInput)) {
-      auto result = m_spent_keys.insert(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage);
-      if (!result.second) {
+      if (!m_spent_keys.insert(::boost::get<KeyInput>(transaction.tx.inputs[i]).keyImage)) {
         logger(ERROR, BRIGHT_RED) <<
           "Double spending transaction was pushed to blockchain.";
 
@@ -2303,7 +2826,8 @@ bool Blockchain::pushTransaction(BlockEntry& block, const crypto::Hash& transact
     if (transaction.tx.outputs[output].target.type() == typeid(KeyOutput)) {
       auto& amountOutputs = m_outputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
-      amountOutputs.push_back(std::make_pair<>(transactionIndex, output));
+      KeyOutputEntry entry = { transactionIndex, output, ::boost::get<KeyOutput>(transaction.tx.outputs[output].target).key, transaction.tx.unlockTime };
+      amountOutputs.push_back(entry);
     } else if (transaction.tx.outputs[output].target.type() == typeid(MultisignatureOutput)) {
       auto& amountOutputs = m_multisignatureOutputs[transaction.tx.outputs[output].amount];
       transaction.m_global_output_indexes[output] = static_cast<uint32_t>(amountOutputs.size());
@@ -2337,14 +2861,14 @@ void Blockchain::popTransaction(const Transaction& transaction, const crypto::Ha
         continue;
       }
 
-      if (amountOutputs->second.back().first.block != transactionIndex.block || amountOutputs->second.back().first.transaction != transactionIndex.transaction) {
+      if (amountOutputs->second.back().transactionIndex.block != transactionIndex.block || amountOutputs->second.back().transactionIndex.transaction != transactionIndex.transaction) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - invalid transaction index.";
 
         continue;
       }
 
-      if (amountOutputs->second.back().second != transaction.outputs.size() - 1 - outputIndex) {
+      if (amountOutputs->second.back().outputIndex != transaction.outputs.size() - 1 - outputIndex) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - invalid output index.";
 
@@ -2401,8 +2925,7 @@ void Blockchain::popTransaction(const Transaction& transaction, const crypto::Ha
 
   for (auto& input : transaction.inputs) {
     if (input.type() == typeid(KeyInput)) {
-      size_t count = m_spent_keys.erase(::boost::get<KeyInput>(input).keyImage);
-      if (count != 1) {
+      if (!m_spent_keys.erase(::boost::get<KeyInput>(input).keyImage)) {
         logger(ERROR, BRIGHT_RED) <<
           "Blockchain consistency broken - cannot find spent key.";
       }
@@ -2513,6 +3036,8 @@ bool Blockchain::rollbackBlockchainTo(uint32_t height) {
   while (height + 1 < m_blocks.size()) {
     removeLastBlock();
   }
+
+  m_tx_pool.on_blockchain_dec(m_blocks.size(), getTailId());
   logger(INFO, GREEN) << "Rollback complete. Synchronization will resume.";   
   return true;
 }
@@ -2531,6 +3056,13 @@ bool Blockchain::removeLastBlock() {
   m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
   m_generatedTransactionsIndex.remove(m_blocks.back().bl);
 
+  if (m_blocks.size() >= m_currency.minedMoneyUnlockWindow()) {
+    updateUnlockedOutputCounts(static_cast<uint32_t>(m_blocks.size() - m_currency.minedMoneyUnlockWindow()), false);
+  }
+
+  m_depositIndex.popBlock();
+  journalLastBlockPop(blockHash);
+  m_blobCache.invalidateFrom(static_cast<uint32_t>(m_blocks.size() - 1));
   m_blocks.pop_back();
   m_blockIndex.pop();
 
@@ -2538,9 +3070,26 @@ bool Blockchain::removeLastBlock() {
   return true;
 }
 
+void Blockchain::journalLastBlockPop(const crypto::Hash& blockHash) {
+  uint32_t height = static_cast<uint32_t>(m_blocks.size() - 1);
+  if (height >= m_cacheCheckpointHeight) {
+    // Not part of the saved cache, the blocks replacing it are indexed anew on the next start
+    return;
+  }
+
+  common::ArrayView<uint8_t> entry = m_blocks.blob(height);
+  if (!m_cacheJournal.appendPop(height, blockHash, entry.getData(), entry.getSize())) {
+    // A journal with a missing record must never be replayed, start over from a full rebuild instead
+    logger(WARNING, BRIGHT_YELLOW) << "Failed to journal popped block " << height << ", blockchain cache will be rebuilt on next start";
+    m_cacheJournal.reset(NULL_HASH);
+  }
+
+  m_cacheCheckpointHeight = std::min(m_cacheCheckpointHeight, height);
+}
+
 
 bool Blockchain::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_t& height) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   assert(startOffset < m_blocks.size());
 
@@ -2556,12 +3105,12 @@ bool Blockchain::getLowerBound(uint64_t timestamp, uint64_t startOffset, uint32_
 }
 
 std::vector<crypto::Hash> Blockchain::getBlockIds(uint32_t startHeight, uint32_t maxCount) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_blockIndex.getBlockIds(startHeight, maxCount);
 }
 
 bool Blockchain::getBlockContainingTransaction(const crypto::Hash& txId, crypto::Hash& blockId, uint32_t& blockHeight) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   auto it = m_transactionMap.find(txId);
   if (it == m_transactionMap.end()) {
     return false;
@@ -2573,7 +3122,7 @@ bool Blockchain::getBlockContainingTransaction(const crypto::Hash& txId, crypto:
 }
 
 bool Blockchain::getAlreadyGeneratedCoins(const crypto::Hash& hash, uint64_t& generatedCoins) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   // try to find block in main chain
   uint32_t height = 0;
@@ -2594,7 +3143,7 @@ bool Blockchain::getAlreadyGeneratedCoins(const crypto::Hash& hash, uint64_t& ge
 }
 
 bool Blockchain::getBlockSize(const crypto::Hash& hash, size_t& size) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
   // try to find block in main chain
   uint32_t height = 0;
@@ -2615,7 +3164,7 @@ bool Blockchain::getBlockSize(const crypto::Hash& hash, size_t& size) {
 }
 
 bool Blockchain::getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<crypto::Hash, size_t>& outputReference) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   MultisignatureOutputsContainer::const_iterator amountIter = m_multisignatureOutputs.find(txInMultisig.amount);
   if (amountIter == m_multisignatureOutputs.end()) {
     logger(DEBUGGING) << "Transaction contains multisignature input with invalid amount.";
@@ -2682,22 +3231,22 @@ bool Blockchain::loadBlockchainIndices() {
 }
 
 bool Blockchain::getGeneratedTransactionsNumber(uint32_t height, uint64_t& generatedTransactions) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_generatedTransactionsIndex.find(height, generatedTransactions);
 }
 
 bool Blockchain::getOrphanBlockIdsByHeight(uint32_t height, std::vector<crypto::Hash>& blockHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_orthanBlocksIndex.find(height, blockHashes);
 }
 
 bool Blockchain::getBlockIdsByTimestamp(uint64_t timestampBegin, uint64_t timestampEnd, uint32_t blocksNumberLimit, std::vector<crypto::Hash>& hashes, uint32_t& blocksNumberWithinTimestamps) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_timestampIndex.find(timestampBegin, timestampEnd, blocksNumberLimit, hashes, blocksNumberWithinTimestamps);
 }
 
 bool Blockchain::getTransactionIdsByPaymentId(const crypto::Hash& paymentId, std::vector<crypto::Hash>& transactionHashes) {
-  std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+  SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
   return m_paymentIdIndex.find(paymentId, transactionHashes);
 }
 
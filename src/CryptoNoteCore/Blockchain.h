@@ -10,6 +10,8 @@
 #define STDC_HEADERS 1
 
 #include <atomic>
+#include <future>
+#include <mutex>
 
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
@@ -22,7 +24,13 @@
 #include "CryptoNoteCore/DepositIndex.h"
 #include "CryptoNoteCore/IBlockchainStorageObserver.h"
 #include "CryptoNoteCore/ITransactionValidator.h"
-#include "CryptoNoteCore/SwappedVector.h"
+#include "CryptoNoteCore/BlockBlobCache.h"
+#include "CryptoNoteCore/BlockCacheJournal.h"
+#include "CryptoNoteCore/KeyImageSet.h"
+#include "CryptoNoteCore/MappedBlockStore.h"
+#include "CryptoNoteCore/RecursiveSharedMutex.h"
+#include "CryptoNoteCore/RingSignatureBatch.h"
+#include "CryptoNoteCore/SignatureCache.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionPool.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
@@ -71,6 +79,7 @@ namespace cn {
     void setCheckpoints(Checkpoints&& chk_pts) { m_checkpoints = chk_pts; }
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks, std::list<Transaction>& txs);
     bool getBlocks(uint32_t start_offset, uint32_t count, std::list<Block>& blocks);
+    std::shared_ptr<const SerializedBlock> getSerializedBlock(uint32_t height);
     bool getTransactionsWithOutputGlobalIndexes(const std::vector<crypto::Hash>& txs_ids, std::list<crypto::Hash>& missed_txs, std::vector<std::pair<Transaction, std::vector<uint32_t>>>& txs);
     bool getAlternativeBlocks(std::list<Block>& blocks);
     uint32_t getAlternativeBlocksCount();
@@ -91,6 +100,8 @@ namespace cn {
     uint64_t getCoinsInCirculation();
     uint8_t get_block_major_version_for_height(uint64_t height) const;
     bool addNewBlock(const Block& bl_, block_verification_context& bvc);
+    // Starts computing the proof of work of blocks about to be added on worker threads, pushBlock waits for the result
+    void prepareBlocks(std::vector<Block> blocks);
     bool resetAndSetGenesisBlock(const Block& b);
     bool haveBlock(const crypto::Hash& id);
     size_t getTotalTransactions();
@@ -123,6 +134,7 @@ namespace cn {
     uint64_t depositInterestAtHeight(size_t height) const;
     uint64_t coinsEmittedAtHeight(uint64_t height);
     uint64_t difficultyAtHeight(uint64_t height);
+    std::string getSignatureCacheStatistics() const;
     bool isInCheckpointZone(const uint32_t height);
 
     template<class visitor_t> bool scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height = NULL);
@@ -132,7 +144,7 @@ namespace cn {
 
     template<class t_ids_container, class t_blocks_container, class t_missed_container>
     bool getBlocks(const t_ids_container& block_ids, t_blocks_container& blocks, t_missed_container& missed_bs) {
-      std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+      SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
       for (const auto& bl_id : block_ids) {
         uint32_t height = 0;
@@ -141,7 +153,8 @@ namespace cn {
         } else {
           if (!(height < m_blocks.size())) { logger(logging::ERROR, logging::BRIGHT_RED) << "Internal error: bl_id=" << common::podToHex(bl_id)
             << " have index record with offset=" << height << ", bigger then m_blocks.size()=" << m_blocks.size(); return false; }
-            blocks.push_back(m_blocks[height].bl);
+            blocks.push_back(Block());
+            loadBlock(height, blocks.back());
         }
       }
 
@@ -150,7 +163,7 @@ namespace cn {
 
     template<class t_ids_container, class t_tx_container, class t_missed_container>
     void getBlockchainTransactions(const t_ids_container& txs_ids, t_tx_container& txs, t_missed_container& missed_txs) {
-      std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+      SharedLockGuard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
 
       for (const auto& tx_id : txs_ids) {
         auto it = m_transactionMap.find(tx_id);
@@ -198,6 +211,22 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
 
   private:
 
+    // A key output by its global index, with the fields ring resolution needs stored inline
+    // so that checking an input never has to load the transaction holding the output
+    struct KeyOutputEntry {
+      TransactionIndex transactionIndex;
+      uint16_t outputIndex;
+      crypto::PublicKey key;
+      uint64_t unlockTime;
+
+      void serialize(ISerializer& s) {
+        s(transactionIndex, "txindex");
+        s(outputIndex, "outindex");
+        s(key, "key");
+        s(unlockTime, "unlock_time");
+      }
+    };
+
     struct MultisignatureOutputUsage {
       TransactionIndex transactionIndex;
       uint16_t outputIndex;
@@ -238,27 +267,27 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
       }
     };
 
-    typedef google::sparse_hash_set<crypto::KeyImage> key_images_container;
     typedef std::unordered_map<crypto::Hash, BlockEntry> blocks_ext_by_hash;
-    typedef google::sparse_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //crypto::Hash - tx hash, size_t - index of out in transaction
+    typedef google::sparse_hash_map<uint64_t, std::vector<KeyOutputEntry>> outputs_container; // amount -> key outputs by global index
     typedef google::sparse_hash_map<uint64_t, std::vector<MultisignatureOutputUsage>> MultisignatureOutputsContainer;
 
     const Currency& m_currency;
     tx_memory_pool& m_tx_pool;
-    mutable std::recursive_mutex m_blockchain_lock; // TODO: add here reader/writer lock
+    mutable RecursiveSharedMutex m_blockchain_lock; // shared for reads, exclusive for anything that changes the chain or its indices
     crypto::cn_context m_cn_context;
     tools::ObserverManager<IBlockchainStorageObserver> m_observerManager;
 
-    key_images_container m_spent_keys;
+    KeyImageSet m_spent_keys; // sorted table on disk, matches the cache checkpoint while checkpointHash() is set
     size_t m_current_block_cumul_sz_limit;
     blocks_ext_by_hash m_alternative_chains; // crypto::Hash -> block_extended_info
     outputs_container m_outputs;
+    std::unordered_map<uint64_t, uint32_t> m_unlockedOutputCounts; // amount -> outputs past the mined money unlock window, always a prefix of m_outputs
 
     std::string m_config_folder;
     Checkpoints m_checkpoints;
     std::atomic<bool> m_is_in_checkpoint_zone;
 
-    typedef SwappedVector<BlockEntry> Blocks;
+    typedef MappedBlockStore<BlockEntry> Blocks;
     typedef std::unordered_map<crypto::Hash, uint32_t> BlockMap;
     typedef std::unordered_map<crypto::Hash, TransactionIndex> TransactionMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
@@ -267,6 +296,17 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
     friend class BlockchainIndicesSerializer;
 
     Blocks m_blocks;
+    BlockCacheJournal m_cacheJournal;
+    BlockBlobCache m_blobCache;
+    SignatureCache m_signatureCache; // key inputs verified for the pool, consulted again for blocks
+    std::mutex m_preparedBlocksLock;
+    std::unordered_map<crypto::Hash, std::shared_future<crypto::Hash>> m_preparedProofsOfWork; // block hash -> long hash, NULL_HASH if it couldn't be computed
+    std::vector<std::future<void>> m_preparationWorkers;
+    uint32_t m_cacheCheckpointHeight; // lowest height whose cached state is unchanged since the last checkpoint
+    bool m_cacheSaveFailed; // the last checkpoint didn't reach the disk, saved again with the next block
+    uint64_t m_cacheSnapshotCount;
+    std::mutex m_cacheSaveLock; // may be taken while holding m_blockchain_lock, never held while taking it
+    uint64_t m_cacheSnapshotWritten;
     cn::BlockIndex m_blockIndex;
     cn::DepositIndex m_depositIndex;
     TransactionMap m_transactionMap;
@@ -294,9 +334,10 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
     bool validate_miner_transaction(const Block& b, uint32_t height, size_t cumulativeBlockSize, uint64_t alreadyGeneratedCoins, uint64_t fee, uint64_t& reward, int64_t& emissionChange);
     bool rollback_blockchain_switching(std::list<Block>& original_chain, size_t rollback_height);
     bool get_last_n_blocks_sizes(std::vector<size_t>& sz, size_t count);
-    bool add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
+    bool add_out_to_get_random_outs(std::vector<KeyOutputEntry>& amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount& result_outs, uint64_t amount, size_t i);
     bool is_tx_spendtime_unlocked(uint64_t unlock_time);
-    size_t find_end_of_allowed_index(const std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs);
+    void rebuildUnlockedOutputCounts();
+    void updateUnlockedOutputCounts(uint32_t blockHeight, bool unlock);
     bool check_block_timestamp_main(const Block& b);
     bool check_block_timestamp(std::vector<uint64_t> timestamps, const Block& b);
     uint64_t get_adjusted_time();
@@ -306,21 +347,32 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
     std::vector<crypto::Hash> doBuildSparseChain(const crypto::Hash& startBlockId) const;
     bool getBlockCumulativeSize(const Block& block, size_t& cumulativeSize);
     bool update_next_comulative_size_limit();
-    bool check_tx_input(const KeyInput& txin, const crypto::Hash& tx_prefix_hash, const std::vector<crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, const crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL);
-    bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL);
+    bool getKeyInputOutputKeys(const KeyInput& txin, std::vector<const crypto::PublicKey*>& outputKeys, uint32_t* pmax_related_block_height);
+    bool check_tx_input(const KeyInput& txin, const crypto::Hash& tx_prefix_hash, const std::vector<crypto::Signature>& sig, uint32_t* pmax_related_block_height = NULL,
+      RingSignatureBatch* signatureBatch = NULL, size_t transactionIndex = 0, size_t inputIndex = 0);
+    bool checkTransactionInputs(const Transaction& tx, const crypto::Hash& tx_prefix_hash, uint32_t* pmax_used_block_height = NULL,
+      RingSignatureBatch* signatureBatch = NULL, size_t transactionIndex = 0);
+    bool checkTransactionInputs(const Transaction& tx, uint32_t* pmax_used_block_height = NULL, RingSignatureBatch* signatureBatch = NULL, size_t transactionIndex = 0);
     bool check_tx_outputs(const Transaction& tx) const;
 
     const TransactionEntry& transactionByIndex(TransactionIndex index);
+    void loadBlock(uint32_t height, Block& block);
     bool pushBlock(const Block& blockData, const crypto::Hash& id, block_verification_context& bvc, uint32_t height);
     bool pushBlock(const Block& blockData, const std::vector<Transaction>& transactions, const crypto::Hash& id, block_verification_context& bvc);
     bool pushBlock(BlockEntry& block);
+    bool checkProofOfWork(const Block& block, const crypto::Hash& blockHash, difficulty_type currentDifficulty, crypto::Hash& proofOfWork);
     void popBlock(const crypto::Hash& blockHash);
     bool pushTransaction(BlockEntry& block, const crypto::Hash& transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction& transaction, const crypto::Hash& transactionHash);
     void popTransactions(const BlockEntry& block, const crypto::Hash& minerTransactionHash);
     bool validateInput(const MultisignatureInput& input, const crypto::Hash& transactionHash, const crypto::Hash& transactionPrefixHash, const std::vector<crypto::Signature>& transactionSignatures);
     bool removeLastBlock();
+    void journalLastBlockPop(const crypto::Hash& blockHash);
+    void cacheSerializedBlock(const BlockEntry& block, const crypto::Hash& blockHash, const std::vector<BinaryArray>& transactionBlobs);
+    bool loadCache();
+    bool cacheCheckpointIsStale() const;
+    bool writeCache(const std::string& cache, uint64_t snapshot);
+    void indexBlocks(uint32_t startHeight);
     bool checkCheckpoints(uint32_t& lastValidCheckpointHeight);    
     bool storeBlockchainIndices();
     bool loadBlockchainIndices();
@@ -331,6 +383,7 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
     void sendMessage(const BlockchainMessage& message);
 
     friend class LockedBlockchainStorage;
+    friend class SharedLockedBlockchainStorage;
   };
 
   class LockedBlockchainStorage: boost::noncopyable {
@@ -346,17 +399,34 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
   private:
 
     Blockchain& m_bc;
-    std::lock_guard<std::recursive_mutex> m_lock;
+    std::lock_guard<RecursiveSharedMutex> m_lock;
+  };
+
+  // Same as LockedBlockchainStorage for callers that only read, other readers aren't blocked
+  class SharedLockedBlockchainStorage: boost::noncopyable {
+  public:
+
+    SharedLockedBlockchainStorage(Blockchain& bc)
+      : m_bc(bc), m_lock(bc.m_blockchain_lock) {}
+
+    Blockchain* operator -> () {
+      return &m_bc;
+    }
+
+  private:
+
+    Blockchain& m_bc;
+    SharedLockGuard<RecursiveSharedMutex> m_lock;
   };
 
   template<class visitor_t> bool Blockchain::scanOutputKeysForIndexes(const KeyInput& tx_in_to_key, visitor_t& vis, uint32_t* pmax_related_block_height) {
-    std::lock_guard<std::recursive_mutex> lk(m_blockchain_lock);
+    SharedLockGuard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
     auto it = m_outputs.find(tx_in_to_key.amount);
     if (it == m_outputs.end() || !tx_in_to_key.outputIndexes.size())
       return false;
 
     std::vector<uint32_t> absolute_offsets = relative_output_offsets_to_absolute(tx_in_to_key.outputIndexes);
-    std::vector<std::pair<TransactionIndex, uint16_t>>& amount_outs_vec = it->second;
+    std::vector<KeyOutputEntry>& amount_outs_vec = it->second;
     size_t count = 0;
     for (uint64_t i : absolute_offsets) {
       if(i >= amount_outs_vec.size() ) {
@@ -367,24 +437,24 @@ bool have_tx_keyimg_as_spent(const crypto::KeyImage &key_im);
       //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
       //if (!(tx_it != m_transactionMap.end())) { logger(ERROR, BRIGHT_RED) << "Wrong transaction id in output indexes: " << common::podToHex(amount_outs_vec[i].first); return false; }
 
-      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].first);
+      const TransactionEntry& tx = transactionByIndex(amount_outs_vec[i].transactionIndex);
 
-      if (!(amount_outs_vec[i].second < tx.tx.outputs.size())) {
+      if (!(amount_outs_vec[i].outputIndex < tx.tx.outputs.size())) {
         logger(logging::ERROR, logging::BRIGHT_RED)
             << "Wrong index in transaction outputs: "
-            << amount_outs_vec[i].second << ", expected less then "
+            << amount_outs_vec[i].outputIndex << ", expected less then "
             << tx.tx.outputs.size();
         return false;
       }
 
-      if (!vis.handle_output(tx.tx, tx.tx.outputs[amount_outs_vec[i].second], amount_outs_vec[i].second)) {
+      if (!vis.handle_output(tx.tx, tx.tx.outputs[amount_outs_vec[i].outputIndex], amount_outs_vec[i].outputIndex)) {
         logger(logging::INFO) << "Failed to handle_output for output no = " << count << ", with absolute offset " << i;
         return false;
       }
 
       if(count++ == absolute_offsets.size()-1 && pmax_related_block_height) {
-        if (*pmax_related_block_height < amount_outs_vec[i].first.block) {
-          *pmax_related_block_height = amount_outs_vec[i].first.block;
+        if (*pmax_related_block_height < amount_outs_vec[i].transactionIndex.block) {
+          *pmax_related_block_height = amount_outs_vec[i].transactionIndex.block;
         }
       }
     }
@@ -340,6 +340,7 @@ bool core::add_new_tx(const Transaction& tx, const crypto::Hash& tx_hash, size_t
 }
 
 bool core::get_block_template(Block& b, const AccountPublicAddress& adr, difficulty_type& diffic, uint32_t& height, const BinaryArray& ex_nonce) {
+  auto start = std::chrono::steady_clock::now();
   size_t median_size;
   uint64_t already_generated_coins;
 
@@ -438,6 +439,7 @@ bool core::get_block_template(Block& b, const AccountPublicAddress& adr, difficu
       return false;
     }
 
+    m_blockTemplateLatency.add(std::chrono::steady_clock::now() - start);
     return true;
   }
 
@@ -528,6 +530,30 @@ bool core::getPoolChangesLite(const crypto::Hash& tailBlockId, const std::vector
   return returnStatus;
 }
 
+bool core::getPoolChangesSince(const crypto::Hash& tailBlockId, uint64_t poolVersion, std::vector<TransactionPrefixInfo>& addedTxs,
+                               std::vector<crypto::Hash>& deletedTxsIds, uint64_t& currentPoolVersion, bool& isFullPool) {
+
+  std::vector<crypto::Hash> addedTxsIds;
+  std::vector<Transaction> added;
+  {
+    auto guard = m_mempool.obtainGuard();
+    isFullPool = !m_mempool.getChangesSince(poolVersion, addedTxsIds, deletedTxsIds, currentPoolVersion);
+    std::vector<crypto::Hash> misses;
+    m_mempool.getTransactions(addedTxsIds, added, misses);
+    assert(misses.empty());
+  }
+
+  for (size_t i = 0; i < added.size(); ++i) {
+    TransactionPrefixInfo tpi;
+    tpi.txPrefix = added[i];
+    tpi.txHash = addedTxsIds[i];
+
+    addedTxs.push_back(std::move(tpi));
+  }
+
+  return tailBlockId == m_blockchain.getTailId();
+}
+
 void core::getPoolChanges(const std::vector<crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                           std::vector<crypto::Hash>& deletedTxsIds) {
 
@@ -597,6 +623,10 @@ bool core::handle_incoming_block(const Block& b, block_verification_context& bvc
   return true;
 }
 
+void core::prepareBlocks(std::vector<Block> blocks) {
+  m_blockchain.prepareBlocks(std::move(blocks));
+}
+
 crypto::Hash core::get_tail_id() {
   return m_blockchain.getTailId();
 }
@@ -639,7 +669,7 @@ std::vector<crypto::Hash> core::buildSparseChain() {
 }
 
 std::vector<crypto::Hash> core::buildSparseChain(const crypto::Hash& startBlockId) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
   assert(m_blockchain.haveBlock(startBlockId));
   return m_blockchain.buildSparseChain(startBlockId);
 }
@@ -649,7 +679,7 @@ bool core::handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS::request& arg, NOTIFY_R
 }
 
 crypto::Hash core::getBlockIdByHeight(uint32_t height) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
   if (height < m_blockchain.getCurrentBlockchainHeight()) {
     return m_blockchain.getBlockIdByHeight(height);
   } else {
@@ -681,6 +711,14 @@ std::string core::print_pool(bool short_format) {
   return m_mempool.print_pool(short_format);
 }
 
+std::string core::print_signature_cache() {
+  return m_blockchain.getSignatureCacheStatistics();
+}
+
+std::string core::print_block_template_latency() {
+  return m_blockTemplateLatency.toString();
+}
+
 bool core::update_miner_block_template() {
   m_miner->on_block_chain_update();
   return true;
@@ -726,7 +764,7 @@ void core::poolUpdated() {
 bool core::queryBlocks(const std::vector<crypto::Hash>& knownBlockIds, uint64_t timestamp,
   uint32_t& resStartHeight, uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockFullInfo>& entries) {
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   uint32_t currentHeight = lbs->getCurrentBlockchainHeight();
   uint32_t startOffset = 0;
@@ -754,26 +792,19 @@ bool core::queryBlocks(const std::vector<crypto::Hash>& knownBlockIds, uint64_t
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(startFullOffset, blocksLeft, blocks);
+  uint32_t endHeight = std::min(startFullOffset + blocksLeft, currentHeight);
+  for (uint32_t height = startFullOffset; height < endHeight; ++height) {
+    std::shared_ptr<const SerializedBlock> block = lbs->getSerializedBlock(height);
+    if (!block) {
+      break;
+    }
 
-  for (auto& b : blocks) {
     BlockFullInfo item;
+    item.block_id = block->blockHash;
 
-    item.block_id = get_block_hash(b);
-
-    if (b.timestamp >= timestamp) {
-      // query transactions
-      std::list<Transaction> txs;
-      std::list<crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
-
-      // fill data
-      block_complete_entry& completeEntry = item;
-      completeEntry.block = asString(toBinaryArray(b));
-      for (auto& tx : txs) {
-        completeEntry.txs.push_back(asString(toBinaryArray(tx)));
-      }
+    if (block->timestamp >= timestamp) {
+      item.block = block->block;
+      item.txs.assign(block->transactions.begin(), block->transactions.end());
     }
 
     entries.push_back(std::move(item));
@@ -783,7 +814,7 @@ bool core::queryBlocks(const std::vector<crypto::Hash>& knownBlockIds, uint64_t
 }
 
 bool core::findStartAndFullOffsets(const std::vector<crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& startOffset, uint32_t& startFullOffset) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   if (knownBlockIds.empty()) {
     logger(ERROR, BRIGHT_RED) << "<< Core.cpp << " << "knownBlockIds is empty";
@@ -806,7 +837,7 @@ bool core::findStartAndFullOffsets(const std::vector<crypto::Hash>& knownBlockId
 std::vector<crypto::Hash> core::findIdsForShortBlocks(uint32_t startOffset, uint32_t startFullOffset) {
   assert(startOffset <= startFullOffset);
 
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   std::vector<crypto::Hash> result;
   if (startOffset < startFullOffset) {
@@ -818,7 +849,7 @@ std::vector<crypto::Hash> core::findIdsForShortBlocks(uint32_t startOffset, uint
 
 bool core::queryBlocksLite(const std::vector<crypto::Hash>& knownBlockIds, uint64_t timestamp, uint32_t& resStartHeight,
   uint32_t& resCurrentHeight, uint32_t& resFullOffset, std::vector<BlockShortInfo>& entries) {
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   resCurrentHeight = lbs->getCurrentBlockchainHeight();
   resStartHeight = 0;
@@ -842,28 +873,19 @@ bool core::queryBlocksLite(const std::vector<crypto::Hash>& knownBlockIds, uint6
     return true;
   }
 
-  std::list<Block> blocks;
-  lbs->getBlocks(resFullOffset, blocksLeft, blocks);
+  uint32_t endHeight = std::min(resFullOffset + blocksLeft, resCurrentHeight);
+  for (uint32_t height = resFullOffset; height < endHeight; ++height) {
+    std::shared_ptr<const SerializedBlock> block = lbs->getSerializedBlock(height);
+    if (!block) {
+      break;
+    }
 
-  for (auto& b : blocks) {
     BlockShortInfo item;
+    item.blockId = block->blockHash;
 
-    item.blockId = get_block_hash(b);
-
-    if (b.timestamp >= timestamp) {
-      std::list<Transaction> txs;
-      std::list<crypto::Hash> missedTxs;
-      lbs->getTransactions(b.transactionHashes, txs, missedTxs);
-
-      item.block = asString(toBinaryArray(b));
-
-      for (const auto& tx: txs) {
-        TransactionPrefixInfo info;
-        info.txPrefix = tx;
-        info.txHash = getObjectHash(tx);
-
-        item.txPrefixes.push_back(std::move(info));
-      }
+    if (block->timestamp >= timestamp) {
+      item.block = block->block;
+      item.txPrefixes = block->transactionPrefixes;
     }
 
     entries.push_back(std::move(item));
@@ -1068,7 +1090,7 @@ bool core::handleIncomingTransaction(const Transaction& tx, const crypto::Hash&
 
 std::unique_ptr<IBlock> core::getBlock(const crypto::Hash& blockId) {
   std::lock_guard<decltype(m_mempool)> lk(m_mempool);
-  LockedBlockchainStorage lbs(m_blockchain);
+  SharedLockedBlockchainStorage lbs(m_blockchain);
 
   std::unique_ptr<BlockWithTransactions> blockPtr(new BlockWithTransactions());
   if (!lbs->getBlockByHash(blockId, blockPtr->block)) {
@@ -20,6 +20,7 @@
 #include "CryptoNoteCore/MinerConfig.h"
 #include "ICore.h"
 #include "ICoreObserver.h"
+#include "Common/LatencyHistogram.h"
 #include "Common/ObserverManager.h"
 
 #include "System/Dispatcher.h"
@@ -62,6 +63,7 @@ namespace cn {
      virtual bool saveBlockchain() override;
      virtual size_t addChain(const std::vector<const IBlock*>& chain) override;
      virtual bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp) override; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
+     virtual void prepareBlocks(std::vector<Block> blocks) override;
      virtual bool getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) override;
      virtual bool getBlockSize(const crypto::Hash& hash, size_t& size) override;
      virtual bool getAlreadyGeneratedCoins(const crypto::Hash& hash, uint64_t& generatedCoins) override;
@@ -137,12 +139,16 @@ namespace cn {
      void print_blockchain(uint32_t start_index, uint32_t end_index);
      void print_blockchain_index();
      std::string print_pool(bool short_format);
+     std::string print_signature_cache();
+     std::string print_block_template_latency();
      std::list<cn::tx_memory_pool::TransactionDetails> getMemoryPool() const;
      void print_blockchain_outs(const std::string& file);
      virtual bool getPoolChanges(const crypto::Hash& tailBlockId, const std::vector<crypto::Hash>& knownTxsIds,
                                  std::vector<Transaction>& addedTxs, std::vector<crypto::Hash>& deletedTxsIds) override;
      virtual bool getPoolChangesLite(const crypto::Hash& tailBlockId, const std::vector<crypto::Hash>& knownTxsIds,
                                   std::vector<TransactionPrefixInfo>& addedTxs, std::vector<crypto::Hash>& deletedTxsIds) override;
+     virtual bool getPoolChangesSince(const crypto::Hash& tailBlockId, uint64_t poolVersion, std::vector<TransactionPrefixInfo>& addedTxs,
+                                 std::vector<crypto::Hash>& deletedTxsIds, uint64_t& currentPoolVersion, bool& isFullPool) override;
      virtual void getPoolChanges(const std::vector<crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                                  std::vector<crypto::Hash>& deletedTxsIds) override;
 
@@ -193,5 +199,6 @@ namespace cn {
      friend class tx_validate_inputs;
      std::atomic<bool> m_starter_message_showed;
      tools::ObserverManager<ICoreObserver> m_observerManager;
+     common::LatencyHistogram m_blockTemplateLatency; // get_block_template calls that built a template
    };
 }
@@ -516,16 +516,35 @@ bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
     return false;
   }
 
-if (b.majorVersion >= 3) {
-    cn_conceal_slow_hash_v0(context, bd.data(), bd.size(), res);
-  } else if (b.majorVersion == 2) {
-    cn_fast_slow_hash_v1(context, bd.data(), bd.size(), res);
+  get_block_longhash(context, b.majorVersion, bd, res);
+  return true;
+}
+
+void get_block_longhash(cn_context &context, uint8_t majorVersion, const BinaryArray& blob, Hash& res) {
+  if (majorVersion >= 3) {
+    cn_conceal_slow_hash_v0(context, blob.data(), blob.size(), res);
+  } else if (majorVersion == 2) {
+    cn_fast_slow_hash_v1(context, blob.data(), blob.size(), res);
   } else {
-    cn_slow_hash(context, bd.data(), bd.size(), res);
+    cn_slow_hash(context, blob.data(), blob.size(), res);
   }
-  
+}
 
-  return true;
+void get_block_longhashes(cn_context *contexts, size_t count, uint8_t majorVersion, const BinaryArray* blobs, Hash* res) {
+  std::vector<const void*> data(count);
+  std::vector<size_t> lengths(count);
+  for (size_t i = 0; i < count; ++i) {
+    data[i] = blobs[i].data();
+    lengths[i] = blobs[i].size();
+  }
+
+  if (majorVersion >= 3) {
+    cn_conceal_slow_hash_v0(contexts, count, data.data(), lengths.data(), res);
+  } else if (majorVersion == 2) {
+    cn_fast_slow_hash_v1(contexts, count, data.data(), lengths.data(), res);
+  } else {
+    cn_slow_hash(contexts, count, data.data(), lengths.data(), res);
+  }
 }
 
 std::vector<uint32_t> relative_output_offsets_to_absolute(const std::vector<uint32_t>& off) {
@@ -78,6 +78,10 @@ bool get_aux_block_header_hash(const Block& b, crypto::Hash& res);
 bool get_block_hash(const Block& b, crypto::Hash& res);
 crypto::Hash get_block_hash(const Block& b);
 bool get_block_longhash(crypto::cn_context &context, const Block& b, crypto::Hash& res);
+// Long hash of a hashing blob already built by get_block_hashing_blob for a block of the given major version
+void get_block_longhash(crypto::cn_context &context, uint8_t majorVersion, const BinaryArray& blob, crypto::Hash& res);
+// Long hashes of count such blobs at once, one context each, interleaved as the multi-way slow hashes are
+void get_block_longhashes(crypto::cn_context *contexts, size_t count, uint8_t majorVersion, const BinaryArray* blobs, crypto::Hash* res);
 bool get_inputs_money_amount(const Transaction& tx, uint64_t& money);
 uint64_t get_outs_money_amount(const Transaction& tx);
 bool check_inputs_types_supported(const TransactionPrefix& tx);
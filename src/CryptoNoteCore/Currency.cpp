@@ -93,7 +93,11 @@ bool Currency::init() {
     
     m_blocksFileName = "testnet_" + m_blocksFileName;
     m_blocksCacheFileName = "testnet_" + m_blocksCacheFileName;
+    m_blocksCacheJournalFileName = "testnet_" + m_blocksCacheJournalFileName;
     m_blockIndexesFileName = "testnet_" + m_blockIndexesFileName;
+    m_blockStoreFileName = "testnet_" + m_blockStoreFileName;
+    m_blockStoreIndexFileName = "testnet_" + m_blockStoreIndexFileName;
+    m_keyImagesFileName = "testnet_" + m_keyImagesFileName;
     m_txPoolFileName = "testnet_" + m_txPoolFileName;
     m_blockchinIndicesFileName = "testnet_" + m_blockchinIndicesFileName;
   }
@@ -854,7 +858,11 @@ CurrencyBuilder::CurrencyBuilder(logging::ILogger& log) : m_currency(log) {
 
   blocksFileName(parameters::CRYPTONOTE_BLOCKS_FILENAME);
   blocksCacheFileName(parameters::CRYPTONOTE_BLOCKSCACHE_FILENAME);
+  blocksCacheJournalFileName(parameters::CRYPTONOTE_BLOCKSCACHE_JOURNAL_FILENAME);
   blockIndexesFileName(parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME);
+  blockStoreFileName(parameters::CRYPTONOTE_BLOCKSTORE_FILENAME);
+  blockStoreIndexFileName(parameters::CRYPTONOTE_BLOCKSTOREINDEX_FILENAME);
+  keyImagesFileName(parameters::CRYPTONOTE_KEYIMAGES_FILENAME);
   txPoolFileName(parameters::CRYPTONOTE_POOLDATA_FILENAME);
   blockchinIndicesFileName(parameters::CRYPTONOTE_BLOCKCHAIN_INDICES_FILENAME);
 
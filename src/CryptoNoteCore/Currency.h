@@ -120,7 +120,11 @@ public:
 
   const std::string& blocksFileName() const { return m_blocksFileName; }
   const std::string& blocksCacheFileName() const { return m_blocksCacheFileName; }
+  const std::string& blocksCacheJournalFileName() const { return m_blocksCacheJournalFileName; }
   const std::string& blockIndexesFileName() const { return m_blockIndexesFileName; }
+  const std::string& blockStoreFileName() const { return m_blockStoreFileName; }
+  const std::string& blockStoreIndexFileName() const { return m_blockStoreIndexFileName; }
+  const std::string& keyImagesFileName() const { return m_keyImagesFileName; }
   const std::string& txPoolFileName() const { return m_txPoolFileName; }
   const std::string& blockchinIndicesFileName() const { return m_blockchinIndicesFileName; }
   bool isBlockexplorer() const { return m_isBlockexplorer; }
@@ -245,7 +249,11 @@ private:
 
   std::string m_blocksFileName;
   std::string m_blocksCacheFileName;
+  std::string m_blocksCacheJournalFileName;
   std::string m_blockIndexesFileName;
+  std::string m_blockStoreFileName;
+  std::string m_blockStoreIndexFileName;
+  std::string m_keyImagesFileName;
   std::string m_txPoolFileName;
   std::string m_blockchinIndicesFileName;
 
@@ -339,7 +347,11 @@ public:
 
   CurrencyBuilder& blocksFileName(const std::string& val) { m_currency.m_blocksFileName = val; return *this; }
   CurrencyBuilder& blocksCacheFileName(const std::string& val) { m_currency.m_blocksCacheFileName = val; return *this; }
+  CurrencyBuilder& blocksCacheJournalFileName(const std::string& val) { m_currency.m_blocksCacheJournalFileName = val; return *this; }
   CurrencyBuilder& blockIndexesFileName(const std::string& val) { m_currency.m_blockIndexesFileName = val; return *this; }
+  CurrencyBuilder& blockStoreFileName(const std::string& val) { m_currency.m_blockStoreFileName = val; return *this; }
+  CurrencyBuilder& blockStoreIndexFileName(const std::string& val) { m_currency.m_blockStoreIndexFileName = val; return *this; }
+  CurrencyBuilder& keyImagesFileName(const std::string& val) { m_currency.m_keyImagesFileName = val; return *this; }
   CurrencyBuilder& txPoolFileName(const std::string& val) { m_currency.m_txPoolFileName = val; return *this; }
   CurrencyBuilder& blockchinIndicesFileName(const std::string& val) { m_currency.m_blockchinIndicesFileName = val; return *this; }
 
@@ -63,6 +63,7 @@ public:
   virtual void update_block_template_and_resume_mining() = 0;
   virtual bool handle_incoming_block_blob(const cn::BinaryArray& block_blob, cn::block_verification_context& bvc, bool control_miner, bool relay_block) = 0;
   virtual bool handle_incoming_block(const Block& b, block_verification_context& bvc, bool control_miner, bool relay_block) = 0;
+  virtual void prepareBlocks(std::vector<Block> blocks) = 0;
   virtual bool handle_get_objects(NOTIFY_REQUEST_GET_OBJECTS_request& arg, NOTIFY_RESPONSE_GET_OBJECTS_request& rsp) = 0; //Deprecated. Should be removed with CryptoNoteProtocolHandler.
   virtual void on_synchronized() = 0;
   virtual size_t addChain(const std::vector<const IBlock*>& chain) = 0;
@@ -82,6 +83,9 @@ public:
                               std::vector<TransactionPrefixInfo>& addedTxs, std::vector<crypto::Hash>& deletedTxsIds) = 0;
   virtual void getPoolChanges(const std::vector<crypto::Hash>& knownTxsIds, std::vector<Transaction>& addedTxs,
                               std::vector<crypto::Hash>& deletedTxsIds) = 0;
+  // Pool changes after poolVersion, the whole ready pool with isFullPool set when the version is unknown
+  virtual bool getPoolChangesSince(const crypto::Hash& tailBlockId, uint64_t poolVersion, std::vector<TransactionPrefixInfo>& addedTxs,
+                              std::vector<crypto::Hash>& deletedTxsIds, uint64_t& currentPoolVersion, bool& isFullPool) = 0;
   virtual bool queryBlocks(const std::vector<crypto::Hash>& block_ids, uint64_t timestamp,
     uint32_t& start_height, uint32_t& current_height, uint32_t& full_offset, std::vector<BlockFullInfo>& entries) = 0;
   virtual bool queryBlocksLite(const std::vector<crypto::Hash>& block_ids, uint64_t timestamp,
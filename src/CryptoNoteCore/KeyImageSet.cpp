@@ -0,0 +1,288 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "KeyImageSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace cn {
+
+namespace {
+
+const uint32_t TABLE_SIGNATURE = 0x54494b53; // "SKIT"
+const uint32_t TABLE_VERSION = 1;
+const size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(crypto::Hash);
+
+// 512 bit filter blocks (one cache line) with 16 bits and 6 probes per key, about 0.1% false positives.
+// The filter is sized for the table plus FILTER_HEADROOM pending additions and rebuilt on merge.
+const size_t FILTER_BLOCK_WORDS = 8;
+const size_t FILTER_BITS_PER_KEY = 16;
+const size_t FILTER_PROBES = 6;
+const size_t FILTER_HEADROOM = 1 << 19;
+
+bool keyImageLess(const crypto::KeyImage& a, const crypto::KeyImage& b) {
+  return memcmp(&a, &b, sizeof(crypto::KeyImage)) < 0;
+}
+
+void splitKeyImage(const crypto::KeyImage& keyImage, uint64_t& blockWord, uint64_t& bitsWord) {
+  memcpy(&blockWord, reinterpret_cast<const uint8_t*>(&keyImage), sizeof blockWord);
+  memcpy(&bitsWord, reinterpret_cast<const uint8_t*>(&keyImage) + sizeof blockWord, sizeof bitsWord);
+}
+
+bool openTable(const std::string& fileName, platform_system::MemoryMappedFile& file, size_t& count, crypto::Hash& checkpointHash) {
+  std::error_code ec;
+  file.open(fileName, ec);
+  if (ec) {
+    return false;
+  }
+
+  uint32_t signature;
+  uint32_t version;
+  uint64_t tableSize;
+  const uint8_t* data = file.data();
+  if (file.size() < HEADER_SIZE) {
+    file.close(ec);
+    return false;
+  }
+
+  memcpy(&signature, data, sizeof signature);
+  memcpy(&version, data + sizeof signature, sizeof version);
+  memcpy(&tableSize, data + sizeof signature + sizeof version, sizeof tableSize);
+  if (signature != TABLE_SIGNATURE || version != TABLE_VERSION ||
+    file.size() != HEADER_SIZE + tableSize * sizeof(crypto::KeyImage)) {
+    file.close(ec);
+    return false;
+  }
+
+  memcpy(&checkpointHash, data + sizeof signature + sizeof version + sizeof tableSize, sizeof checkpointHash);
+  count = static_cast<size_t>(tableSize);
+  return true;
+}
+
+}
+
+KeyImageSet::KeyImageSet() : m_tableSize(0), m_checkpointHash(NULL_HASH) {
+}
+
+bool KeyImageSet::open(const std::string& fileName) {
+  close();
+  m_fileName = fileName;
+  if (openTable(m_fileName, m_file, m_tableSize, m_checkpointHash)) {
+    rebuildFilter();
+    return true;
+  }
+
+  return clear();
+}
+
+void KeyImageSet::close() {
+  if (m_file.isOpened()) {
+    std::error_code ignore;
+    m_file.close(ignore);
+  }
+
+  m_tableSize = 0;
+  m_checkpointHash = NULL_HASH;
+  m_added.clear();
+  m_removed.clear();
+  m_filter.clear();
+}
+
+bool KeyImageSet::contains(const crypto::KeyImage& keyImage) const {
+  if (!filterContains(keyImage)) {
+    return false;
+  }
+
+  if (m_added.count(keyImage) != 0) {
+    return true;
+  }
+
+  if (m_removed.count(keyImage) != 0) {
+    return false;
+  }
+
+  return tableContains(keyImage);
+}
+
+bool KeyImageSet::insert(const crypto::KeyImage& keyImage) {
+  if (contains(keyImage)) {
+    return false;
+  }
+
+  // A removed key image is still in the table and in the filter
+  if (m_removed.erase(keyImage) != 0) {
+    return true;
+  }
+
+  m_added.insert(keyImage);
+  addToFilter(keyImage);
+  return true;
+}
+
+bool KeyImageSet::erase(const crypto::KeyImage& keyImage) {
+  if (m_added.erase(keyImage) != 0) {
+    return true;
+  }
+
+  if (m_removed.count(keyImage) != 0 || !tableContains(keyImage)) {
+    return false;
+  }
+
+  m_removed.insert(keyImage);
+  return true;
+}
+
+bool KeyImageSet::clear() {
+  std::string fileName = m_fileName;
+  close();
+  m_fileName = fileName;
+  return replaceTable(NULL_HASH);
+}
+
+size_t KeyImageSet::size() const {
+  return m_tableSize + m_added.size() - m_removed.size();
+}
+
+size_t KeyImageSet::pendingCount() const {
+  return m_added.size() + m_removed.size();
+}
+
+bool KeyImageSet::merge(const crypto::Hash& checkpointHash) {
+  if (pendingCount() == 0 && checkpointHash == m_checkpointHash && m_file.isOpened()) {
+    return true;
+  }
+
+  return replaceTable(checkpointHash);
+}
+
+const crypto::Hash& KeyImageSet::checkpointHash() const {
+  return m_checkpointHash;
+}
+
+bool KeyImageSet::write(const std::string& fileName, const crypto::Hash& checkpointHash) {
+  std::vector<crypto::KeyImage> added(m_added.begin(), m_added.end());
+  std::sort(added.begin(), added.end(), keyImageLess);
+
+  uint64_t count = size();
+  std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&TABLE_SIGNATURE), sizeof TABLE_SIGNATURE);
+  file.write(reinterpret_cast<const char*>(&TABLE_VERSION), sizeof TABLE_VERSION);
+  file.write(reinterpret_cast<const char*>(&count), sizeof count);
+  file.write(reinterpret_cast<const char*>(&checkpointHash), sizeof checkpointHash);
+
+  const crypto::KeyImage* tableBegin = table();
+  const crypto::KeyImage* tableEnd = tableBegin + m_tableSize;
+  auto addedIt = added.begin();
+  for (const crypto::KeyImage* it = tableBegin; it != tableEnd; ++it) {
+    for (; addedIt != added.end() && keyImageLess(*addedIt, *it); ++addedIt) {
+      file.write(reinterpret_cast<const char*>(&*addedIt), sizeof(crypto::KeyImage));
+    }
+
+    if (m_removed.count(*it) == 0) {
+      file.write(reinterpret_cast<const char*>(it), sizeof(crypto::KeyImage));
+    }
+  }
+
+  for (; addedIt != added.end(); ++addedIt) {
+    file.write(reinterpret_cast<const char*>(&*addedIt), sizeof(crypto::KeyImage));
+  }
+
+  file.flush();
+  return static_cast<bool>(file);
+}
+
+// The current table stays mapped until the new one is mapped and renamed over it, the set is left
+// as it was when any step fails
+bool KeyImageSet::replaceTable(const crypto::Hash& checkpointHash) {
+  std::string tmpName = m_fileName + ".tmp";
+  platform_system::MemoryMappedFile file;
+  size_t tableSize;
+  crypto::Hash tableCheckpointHash;
+  if (!write(tmpName, checkpointHash) || !openTable(tmpName, file, tableSize, tableCheckpointHash)) {
+    return false;
+  }
+
+  std::error_code ec;
+  file.rename(m_fileName, ec);
+  if (ec) {
+    return false;
+  }
+
+  m_file.swap(file);
+  m_tableSize = tableSize;
+  m_checkpointHash = tableCheckpointHash;
+  m_added.clear();
+  m_removed.clear();
+  rebuildFilter();
+  return true;
+}
+
+void KeyImageSet::rebuildFilter() {
+  resetFilter(m_tableSize);
+  const crypto::KeyImage* entries = table();
+  for (size_t i = 0; i < m_tableSize; ++i) {
+    addToFilter(entries[i]);
+  }
+
+  for (const crypto::KeyImage& keyImage : m_added) {
+    addToFilter(keyImage);
+  }
+}
+
+bool KeyImageSet::tableContains(const crypto::KeyImage& keyImage) const {
+  const crypto::KeyImage* begin = table();
+  const crypto::KeyImage* end = begin + m_tableSize;
+  const crypto::KeyImage* it = std::lower_bound(begin, end, keyImage, keyImageLess);
+  return it != end && memcmp(it, &keyImage, sizeof(crypto::KeyImage)) == 0;
+}
+
+const crypto::KeyImage* KeyImageSet::table() const {
+  if (!m_file.isOpened()) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<const crypto::KeyImage*>(m_file.data() + HEADER_SIZE);
+}
+
+void KeyImageSet::resetFilter(size_t keyCount) {
+  size_t blockCount = ((keyCount + FILTER_HEADROOM) * FILTER_BITS_PER_KEY + FILTER_BLOCK_WORDS * 64 - 1) / (FILTER_BLOCK_WORDS * 64);
+  m_filter.assign(blockCount * FILTER_BLOCK_WORDS, 0);
+}
+
+void KeyImageSet::addToFilter(const crypto::KeyImage& keyImage) {
+  uint64_t blockWord;
+  uint64_t bitsWord;
+  splitKeyImage(keyImage, blockWord, bitsWord);
+
+  uint64_t* block = m_filter.data() + (blockWord % (m_filter.size() / FILTER_BLOCK_WORDS)) * FILTER_BLOCK_WORDS;
+  for (size_t i = 0; i < FILTER_PROBES; ++i, bitsWord >>= 9) {
+    size_t bit = static_cast<size_t>(bitsWord & 511);
+    block[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+}
+
+bool KeyImageSet::filterContains(const crypto::KeyImage& keyImage) const {
+  if (m_filter.empty()) {
+    return false;
+  }
+
+  uint64_t blockWord;
+  uint64_t bitsWord;
+  splitKeyImage(keyImage, blockWord, bitsWord);
+
+  const uint64_t* block = m_filter.data() + (blockWord % (m_filter.size() / FILTER_BLOCK_WORDS)) * FILTER_BLOCK_WORDS;
+  for (size_t i = 0; i < FILTER_PROBES; ++i, bitsWord >>= 9) {
+    size_t bit = static_cast<size_t>(bitsWord & 511);
+    if ((block[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}
@@ -0,0 +1,71 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "System/MemoryMappedFile.h"
+
+namespace cn {
+
+// Set of spent key images that keeps only a filter and the recent changes in memory.
+// The bulk of the set is a sorted table of key images in a memory mapped file. Key images added or
+// removed since the table was written are pending, and merge() writes a new table with them applied.
+// A blocked Bloom filter over the table and the pending additions answers most lookups of unspent
+// key images without touching the table. The filter never forgets removed key images, a false
+// positive only costs a lookup.
+//
+// Lookups may run concurrently, changes need exclusive access.
+class KeyImageSet {
+public:
+  KeyImageSet();
+
+  // Opens the table, an empty one is created if the file is missing or unreadable
+  bool open(const std::string& fileName);
+  void close();
+
+  bool contains(const crypto::KeyImage& keyImage) const;
+  // Returns false if the key image was already in the set
+  bool insert(const crypto::KeyImage& keyImage);
+  // Returns false if the key image was not in the set
+  bool erase(const crypto::KeyImage& keyImage);
+  bool clear();
+
+  size_t size() const;
+  size_t pendingCount() const;
+
+  // Writes a new table with the pending changes applied. checkpointHash names the blockchain cache
+  // checkpoint the table belongs to, NULL_HASH if it belongs to none. On failure the old table and
+  // the pending changes are kept.
+  bool merge(const crypto::Hash& checkpointHash);
+  const crypto::Hash& checkpointHash() const;
+
+private:
+  bool write(const std::string& fileName, const crypto::Hash& checkpointHash);
+  bool replaceTable(const crypto::Hash& checkpointHash);
+  void rebuildFilter();
+  bool tableContains(const crypto::KeyImage& keyImage) const;
+  const crypto::KeyImage* table() const;
+  void resetFilter(size_t keyCount);
+  void addToFilter(const crypto::KeyImage& keyImage);
+  bool filterContains(const crypto::KeyImage& keyImage) const;
+
+  std::string m_fileName;
+  platform_system::MemoryMappedFile m_file;
+  size_t m_tableSize;
+  crypto::Hash m_checkpointHash;
+  std::unordered_set<crypto::KeyImage> m_added;
+  std::unordered_set<crypto::KeyImage> m_removed;
+  std::vector<uint64_t> m_filter;
+};
+
+}
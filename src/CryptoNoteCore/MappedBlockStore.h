@@ -0,0 +1,501 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/ArrayView.h"
+#include "Common/FileMappedVector.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/VectorOutputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+
+// Append-only store of serialized items backed by two memory mapped files: a byte vector with the
+// concatenated item blobs and a vector of item offsets. Random reads decode straight from the mapping,
+// so an item that is not in the decoded cache costs a page-cache hit and a parse instead of seek+read.
+// The interface mirrors SwappedVector, so either one can be used as the block storage of Blockchain.
+// Every thread decodes into its own item cache, so any number of threads may read concurrently as
+// long as none of them modifies the store; a returned item stays valid until the same thread has
+// read poolSize other items or the store is modified. The cache of a thread is dropped when the
+// thread exits.
+template<class T> class MappedBlockStore {
+public:
+  typedef T value_type;
+
+  class const_iterator {
+  public:
+    typedef ptrdiff_t difference_type;
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef const T* pointer;
+    typedef const T& reference;
+    typedef T value_type;
+
+    const_iterator() : m_store(nullptr), m_index(0) {
+    }
+
+    const_iterator(MappedBlockStore* store, size_t index) : m_store(store), m_index(index) {
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+    bool operator<(const const_iterator& other) const {
+      return m_index < other.m_index;
+    }
+
+    bool operator<=(const const_iterator& other) const {
+      return m_index <= other.m_index;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return m_index == other.m_index;
+    }
+
+    bool operator>(const const_iterator& other) const {
+      return m_index > other.m_index;
+    }
+
+    bool operator>=(const const_iterator& other) const {
+      return m_index >= other.m_index;
+    }
+
+    const_iterator& operator++() {
+      ++m_index;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator i = *this;
+      ++m_index;
+      return i;
+    }
+
+    const_iterator& operator--() {
+      --m_index;
+      return *this;
+    }
+
+    const_iterator operator--(int) {
+      const_iterator i = *this;
+      --m_index;
+      return i;
+    }
+
+    const_iterator& operator+=(difference_type n) {
+      m_index += n;
+      return *this;
+    }
+
+    const_iterator& operator-=(difference_type n) {
+      m_index -= n;
+      return *this;
+    }
+
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(m_store, m_index + n);
+    }
+
+    friend const_iterator operator+(difference_type n, const const_iterator& i) {
+      return const_iterator(i.m_store, n + i.m_index);
+    }
+
+    difference_type operator-(const const_iterator& other) const {
+      return m_index - other.m_index;
+    }
+
+    const_iterator operator-(difference_type n) const {
+      return const_iterator(m_store, m_index - n);
+    }
+
+    const T& operator*() const {
+      return (*m_store)[m_index];
+    }
+
+    const T* operator->() const {
+      return &(*m_store)[m_index];
+    }
+
+    const T& operator[](difference_type offset) const {
+      return (*m_store)[m_index + offset];
+    }
+
+    size_t index() const {
+      return m_index;
+    }
+
+  private:
+    MappedBlockStore* m_store;
+    size_t m_index;
+  };
+
+  MappedBlockStore();
+  MappedBlockStore(const MappedBlockStore&) = delete;
+  ~MappedBlockStore();
+  MappedBlockStore& operator=(const MappedBlockStore&) = delete;
+
+  bool open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize);
+  void close();
+
+  // Imports items from a SwappedVector file pair (items file and index file with item sizes).
+  // The store must be open and empty.
+  bool importSwappedVector(const std::string& itemFileName, const std::string& indexFileName);
+
+  bool empty() const;
+  uint64_t size() const;
+  const_iterator begin();
+  const_iterator end();
+  const T& operator[](uint64_t index);
+  const T& front();
+  const T& back();
+  void clear();
+  void pop_back();
+  void push_back(const T& item);
+
+  // Serialized item bytes, pointing into the mapping. Valid until the next modification of the store.
+  common::ArrayView<uint8_t> blob(uint64_t index) const;
+
+  // Decodes only the leading fields of an item: U must serialize as a prefix of T.
+  // Cheaper than operator[] for callers that don't need the trailing fields of a large item.
+  // Doesn't touch the item cache, so concurrent calls are safe as long as the store isn't modified.
+  template<class U> void decodePrefix(uint64_t index, U& prefix) const;
+
+  // Decoded items held in the caches of all threads
+  size_t cachedItemCount() const;
+
+private:
+  struct ItemEntry {
+  public:
+    T item;
+    typename std::list<uint64_t>::iterator cacheIter;
+  };
+
+  struct ItemCache {
+    std::unordered_map<uint64_t, ItemEntry> items;
+    std::list<uint64_t> order;
+  };
+
+  // Shared with the exit hooks of the reading threads, which may run after the store is gone
+  struct ThreadCaches {
+    std::mutex mutex;
+    std::unordered_map<std::thread::id, ItemCache> caches;
+  };
+
+  common::FileMappedVector<uint8_t> m_itemsFile;
+  common::FileMappedVector<uint64_t> m_offsets;
+  size_t m_poolSize;
+  std::shared_ptr<ThreadCaches> m_caches;
+  std::atomic<uint64_t> m_cacheHits;
+  std::atomic<uint64_t> m_cacheMisses;
+
+  ItemCache& threadCache();
+  static void dropOnThreadExit(const std::shared_ptr<ThreadCaches>& caches);
+  void clearCaches();
+  T* prepare(ItemCache& cache, uint64_t index);
+};
+
+template<class T> MappedBlockStore<T>::MappedBlockStore() : m_poolSize(0), m_caches(std::make_shared<ThreadCaches>()), m_cacheHits(0), m_cacheMisses(0) {
+}
+
+template<class T> MappedBlockStore<T>::~MappedBlockStore() {
+  close();
+}
+
+template<class T> bool MappedBlockStore<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize) {
+  if (poolSize == 0) {
+    return false;
+  }
+
+  try {
+    m_itemsFile.open(itemFileName, common::FileMappedVectorOpenMode::OPEN_OR_CREATE);
+    m_offsets.open(indexFileName, common::FileMappedVectorOpenMode::OPEN_OR_CREATE);
+  } catch (std::exception&) {
+    return false;
+  }
+
+  // Blocks are flushed on close, msync per block would make the import disk bound
+  m_itemsFile.setAutoFlush(false);
+  m_offsets.setAutoFlush(false);
+
+  // Items file is appended before the index, drop a tail that was written but not indexed
+  uint64_t itemsSize = m_offsets.empty() ? 0 : m_offsets.back();
+  if (m_itemsFile.size() < itemsSize) {
+    return false;
+  }
+
+  if (m_itemsFile.size() > itemsSize) {
+    m_itemsFile.erase(m_itemsFile.begin() + itemsSize, m_itemsFile.end());
+  }
+
+  m_poolSize = poolSize;
+  clearCaches();
+  m_cacheHits = 0;
+  m_cacheMisses = 0;
+  return true;
+}
+
+template<class T> void MappedBlockStore<T>::close() {
+  if (m_offsets.isOpened()) {
+    uint64_t hits = m_cacheHits;
+    uint64_t misses = m_cacheMisses;
+    std::cout << "MappedBlockStore cache hits: " << hits << ", misses: " << misses << " (" << std::fixed << std::setprecision(2) << static_cast<double>(misses) / (hits + misses) * 100 << "%)" << std::endl;
+  }
+
+  std::error_code ignore;
+  if (m_itemsFile.isOpened()) {
+    m_itemsFile.close(ignore);
+  }
+
+  if (m_offsets.isOpened()) {
+    m_offsets.close(ignore);
+  }
+
+  clearCaches();
+}
+
+template<class T> bool MappedBlockStore<T>::importSwappedVector(const std::string& itemFileName, const std::string& indexFileName) {
+  if (!m_offsets.empty()) {
+    return false;
+  }
+
+  std::ifstream itemsFile(itemFileName, std::ios::in | std::ios::binary);
+  std::ifstream indexesFile(indexFileName, std::ios::in | std::ios::binary);
+  if (!itemsFile || !indexesFile) {
+    return false;
+  }
+
+  uint64_t count;
+  indexesFile.read(reinterpret_cast<char*>(&count), sizeof count);
+  if (!indexesFile) {
+    return false;
+  }
+
+  std::vector<uint64_t> offsets;
+  offsets.reserve(static_cast<size_t>(count));
+  uint64_t itemsFileSize = 0;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint32_t itemSize;
+    indexesFile.read(reinterpret_cast<char*>(&itemSize), sizeof itemSize);
+    if (!indexesFile) {
+      return false;
+    }
+
+    itemsFileSize += itemSize;
+    offsets.push_back(itemsFileSize);
+  }
+
+  m_itemsFile.reserve(itemsFileSize);
+  std::vector<char> buffer(1 << 20);
+  uint64_t copied = 0;
+  while (copied < itemsFileSize) {
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(buffer.size(), itemsFileSize - copied));
+    itemsFile.read(buffer.data(), chunk);
+    if (!itemsFile) {
+      m_itemsFile.clear();
+      return false;
+    }
+
+    m_itemsFile.insert(m_itemsFile.end(), buffer.data(), buffer.data() + chunk);
+    copied += chunk;
+  }
+
+  m_offsets.reserve(offsets.size());
+  m_offsets.insert(m_offsets.end(), offsets.begin(), offsets.end());
+  m_itemsFile.flush();
+  m_offsets.flush();
+  return true;
+}
+
+template<class T> bool MappedBlockStore<T>::empty() const {
+  return m_offsets.empty();
+}
+
+template<class T> uint64_t MappedBlockStore<T>::size() const {
+  return m_offsets.size();
+}
+
+template<class T> typename MappedBlockStore<T>::const_iterator MappedBlockStore<T>::begin() {
+  return const_iterator(this, 0);
+}
+
+template<class T> typename MappedBlockStore<T>::const_iterator MappedBlockStore<T>::end() {
+  return const_iterator(this, m_offsets.size());
+}
+
+template<class T> const T& MappedBlockStore<T>::operator[](uint64_t index) {
+  ItemCache& cache = threadCache();
+  auto itemIter = cache.items.find(index);
+  if (itemIter != cache.items.end()) {
+    if (itemIter->second.cacheIter != --cache.order.end()) {
+      cache.order.splice(cache.order.end(), cache.order, itemIter->second.cacheIter);
+    }
+
+    m_cacheHits.fetch_add(1, std::memory_order_relaxed);
+    return itemIter->second.item;
+  }
+
+  if (index >= m_offsets.size()) {
+    throw std::runtime_error("MappedBlockStore::operator[]");
+  }
+
+  T tempItem;
+  decodePrefix(index, tempItem);
+
+  T* item = prepare(cache, index);
+  std::swap(tempItem, *item);
+  m_cacheMisses.fetch_add(1, std::memory_order_relaxed);
+  return *item;
+}
+
+template<class T> const T& MappedBlockStore<T>::front() {
+  return operator[](0);
+}
+
+template<class T> const T& MappedBlockStore<T>::back() {
+  return operator[](m_offsets.size() - 1);
+}
+
+template<class T> void MappedBlockStore<T>::clear() {
+  m_offsets.clear();
+  m_itemsFile.clear();
+  clearCaches();
+}
+
+template<class T> void MappedBlockStore<T>::pop_back() {
+  if (m_offsets.empty()) {
+    throw std::runtime_error("MappedBlockStore::pop_back");
+  }
+
+  m_offsets.pop_back();
+  uint64_t itemsSize = m_offsets.empty() ? 0 : m_offsets.back();
+  m_itemsFile.erase(m_itemsFile.begin() + itemsSize, m_itemsFile.end());
+
+  std::lock_guard<std::mutex> lock(m_caches->mutex);
+  for (auto& threadCache : m_caches->caches) {
+    ItemCache& cache = threadCache.second;
+    auto itemIter = cache.items.find(m_offsets.size());
+    if (itemIter != cache.items.end()) {
+      cache.order.erase(itemIter->second.cacheIter);
+      cache.items.erase(itemIter);
+    }
+  }
+}
+
+template<class T> void MappedBlockStore<T>::push_back(const T& item) {
+  std::vector<uint8_t> blob;
+  {
+    common::VectorOutputStream stream(blob);
+    cn::BinaryOutputStreamSerializer archive(stream);
+    serialize(const_cast<T&>(item), archive);
+  }
+
+  uint64_t newItemsSize = m_itemsFile.size() + blob.size();
+  if (newItemsSize > m_itemsFile.capacity()) {
+    // Growing the mapping copies the file, so grow geometrically
+    m_itemsFile.reserve(std::max(newItemsSize, m_itemsFile.capacity() + m_itemsFile.capacity() / 2));
+  }
+
+  m_itemsFile.insert(m_itemsFile.end(), blob.begin(), blob.end());
+  m_offsets.push_back(newItemsSize);
+
+  T* newItem = prepare(threadCache(), m_offsets.size() - 1);
+  *newItem = item;
+}
+
+template<class T> common::ArrayView<uint8_t> MappedBlockStore<T>::blob(uint64_t index) const {
+  if (index >= m_offsets.size()) {
+    throw std::runtime_error("MappedBlockStore::blob");
+  }
+
+  uint64_t begin = index == 0 ? 0 : m_offsets[index - 1];
+  return common::ArrayView<uint8_t>(m_itemsFile.data() + begin, static_cast<size_t>(m_offsets[index] - begin));
+}
+
+template<class T> template<class U> void MappedBlockStore<T>::decodePrefix(uint64_t index, U& prefix) const {
+  common::ArrayView<uint8_t> itemBlob = blob(index);
+  common::MemoryInputStream stream(itemBlob.getData(), itemBlob.getSize());
+  cn::BinaryInputStreamSerializer archive(stream);
+  serialize(prefix, archive);
+}
+
+template<class T> size_t MappedBlockStore<T>::cachedItemCount() const {
+  std::lock_guard<std::mutex> lock(m_caches->mutex);
+  size_t count = 0;
+  for (const auto& threadCache : m_caches->caches) {
+    count += threadCache.second.items.size();
+  }
+
+  return count;
+}
+
+template<class T> typename MappedBlockStore<T>::ItemCache& MappedBlockStore<T>::threadCache() {
+  // Nodes of unordered_map are stable, so the reference outlives the lock; only this thread uses it
+  std::lock_guard<std::mutex> lock(m_caches->mutex);
+  auto cacheIter = m_caches->caches.find(std::this_thread::get_id());
+  if (cacheIter == m_caches->caches.end()) {
+    cacheIter = m_caches->caches.emplace(std::this_thread::get_id(), ItemCache()).first;
+    dropOnThreadExit(m_caches);
+  }
+
+  return cacheIter->second;
+}
+
+template<class T> void MappedBlockStore<T>::dropOnThreadExit(const std::shared_ptr<ThreadCaches>& caches) {
+  struct ThreadExit {
+    std::vector<std::weak_ptr<ThreadCaches>> stores;
+
+    ~ThreadExit() {
+      for (const auto& store : stores) {
+        if (std::shared_ptr<ThreadCaches> caches = store.lock()) {
+          std::lock_guard<std::mutex> lock(caches->mutex);
+          caches->caches.erase(std::this_thread::get_id());
+        }
+      }
+    }
+  };
+
+  static thread_local ThreadExit threadExit;
+  auto& stores = threadExit.stores;
+  stores.erase(std::remove_if(stores.begin(), stores.end(), [&caches](const std::weak_ptr<ThreadCaches>& store) {
+    return store.expired() || store.lock() == caches;
+  }), stores.end());
+  stores.push_back(caches);
+}
+
+template<class T> void MappedBlockStore<T>::clearCaches() {
+  std::lock_guard<std::mutex> lock(m_caches->mutex);
+  m_caches->caches.clear();
+}
+
+template<class T> T* MappedBlockStore<T>::prepare(ItemCache& cache, uint64_t index) {
+  if (cache.items.size() == m_poolSize) {
+    auto cacheIter = cache.order.begin();
+    cache.items.erase(*cacheIter);
+    cache.order.erase(cacheIter);
+  }
+
+  auto itemIter = cache.items.insert(std::make_pair(index, ItemEntry()));
+  auto cacheIter = cache.order.insert(cache.order.end(), index);
+  itemIter.first->second.cacheIter = cacheIter;
+  return &itemIter.first->second.item;
+}
@@ -27,10 +27,18 @@
 #include "Serialization/SerializationTools.h"
 
 #include "CryptoNoteFormatUtils.h"
+#include "MiningJob.h"
 #include "TransactionExtra.h"
 
 using namespace logging;
 
+namespace {
+
+// Nonces a miner thread hashes together, the interleaved slow hash keeps one scratchpad per nonce
+const size_t MINER_HASH_WAYS = 2;
+
+}
+
 namespace cn
 {
 
@@ -258,6 +266,10 @@ namespace cn
   bool miner::find_nonce_for_given_block(crypto::cn_context &context, Block& bl, const difficulty_type& diffic) {
 
     unsigned nthreads = std::thread::hardware_concurrency();
+    MiningJob job;
+    if (!job.init(bl)) {
+      return false;
+    }
 
     if (nthreads > 0 && diffic > 5) {
       std::vector<std::future<void>> threads(nthreads);
@@ -270,14 +282,11 @@ namespace cn
           crypto::cn_context localctx;
           crypto::Hash h;
 
-          Block lb(bl); // copy to local block
+          MiningJob localJob(job);
 
           for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
+            localJob.setNonce(nonce);
+            localJob.getLongHash(localctx, h);
 
             if (check_hash(h, diffic)) {
               foundNonce = nonce;
@@ -300,9 +309,8 @@ namespace cn
     } else {
       for (; bl.nonce != std::numeric_limits<uint32_t>::max(); bl.nonce++) {
         crypto::Hash h;
-        if (!get_block_longhash(context, bl, h)) {
-          return false;
-        }
+        job.setNonce(bl.nonce);
+        job.getLongHash(context, h);
 
         if (check_hash(h, diffic)) {
           return true;
@@ -347,8 +355,9 @@ namespace cn
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    crypto::cn_context context;
+    crypto::cn_context contexts[MINER_HASH_WAYS];
     Block b;
+    MiningJob job;
 
     while(!m_stop)
     {
@@ -366,6 +375,10 @@ namespace cn
 
         local_template_ver = m_template_no;
         nonce = m_starter_nonce + th_local_index;
+        if (!job.init(b)) {
+          logger(ERROR) << "Failed to get block long hash";
+          m_stop = true;
+        }
       }
 
       if(!local_template_ver)//no any set_block_template call
@@ -375,15 +388,22 @@ namespace cn
         continue;
       }
 
-      b.nonce = nonce;
-      crypto::Hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
-        logger(ERROR) << "Failed to get block long hash";
-        m_stop = true;
+      uint32_t nonces[MINER_HASH_WAYS];
+      crypto::Hash hashes[MINER_HASH_WAYS];
+      if (!m_stop) {
+        for (size_t i = 0; i < MINER_HASH_WAYS; ++i) {
+          nonces[i] = nonce + static_cast<uint32_t>(i) * m_threads_total;
+        }
+
+        job.getLongHashes(contexts, nonces, MINER_HASH_WAYS, hashes);
       }
 
-      if (!m_stop && check_hash(h, local_diff))
-      {
+      for (size_t i = 0; i < MINER_HASH_WAYS && !m_stop; ++i) {
+        if (!check_hash(hashes[i], local_diff)) {
+          continue;
+        }
+
+        b.nonce = nonces[i];
         //we lucky!
         ++m_config.current_extra_message_index;
 
@@ -395,10 +415,12 @@ namespace cn
           //success update, lets update config
           common::saveStringToFile(m_config_folder_path + "/" + cn::parameters::MINER_CONFIG_FILE_NAME, storeToJson(m_config));
         }
+
+        break;
       }
 
-      nonce += m_threads_total;
-      ++m_hashes;
+      nonce += m_threads_total * static_cast<uint32_t>(MINER_HASH_WAYS);
+      m_hashes += MINER_HASH_WAYS;
     }
     logger(INFO, YELLOW) << "Miner thread stopped ["<< th_local_index << "]";
     return true;
@@ -0,0 +1,56 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MiningJob.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "CryptoNoteFormatUtils.h"
+#include "CryptoNoteTools.h"
+
+namespace cn {
+
+MiningJob::MiningJob() : m_nonceOffset(0), m_majorVersion(0) {
+}
+
+bool MiningJob::init(const Block& blockTemplate) {
+  BinaryArray header;
+  if (!toBinaryArray(static_cast<const BlockHeader&>(blockTemplate), header) || !get_block_hashing_blob(blockTemplate, m_blob)) {
+    return false;
+  }
+
+  // the nonce is the last field of the header, written as raw bytes
+  assert(header.size() >= sizeof(blockTemplate.nonce) && header.size() <= m_blob.size());
+  m_nonceOffset = header.size() - sizeof(blockTemplate.nonce);
+  m_majorVersion = blockTemplate.majorVersion;
+  return true;
+}
+
+uint32_t MiningJob::getNonce() const {
+  uint32_t nonce;
+  memcpy(&nonce, m_blob.data() + m_nonceOffset, sizeof(nonce));
+  return nonce;
+}
+
+void MiningJob::setNonce(uint32_t nonce) {
+  memcpy(m_blob.data() + m_nonceOffset, &nonce, sizeof(nonce));
+}
+
+void MiningJob::getLongHash(crypto::cn_context& context, crypto::Hash& hash) const {
+  get_block_longhash(context, m_majorVersion, m_blob, hash);
+}
+
+void MiningJob::getLongHashes(crypto::cn_context* contexts, const uint32_t* nonces, size_t count, crypto::Hash* hashes) {
+  m_blobs.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    m_blobs[i].assign(m_blob.begin(), m_blob.end());
+    memcpy(m_blobs[i].data() + m_nonceOffset, &nonces[i], sizeof(nonces[i]));
+  }
+
+  get_block_longhashes(contexts, count, m_majorVersion, m_blobs.data(), hashes);
+}
+
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CryptoNoteBasic.h"
+#include "crypto/hash.h"
+
+namespace cn {
+
+// The hashing blob of a block template, built once. Only the nonce changes between attempts, it is
+// written straight into the blob, so the header is not serialized and the transaction tree hash
+// is not recomputed for every nonce.
+class MiningJob {
+public:
+  MiningJob();
+
+  // False if the template can't be serialized
+  bool init(const Block& blockTemplate);
+
+  uint32_t getNonce() const;
+  void setNonce(uint32_t nonce);
+
+  void getLongHash(crypto::cn_context& context, crypto::Hash& hash) const;
+  // Hashes count nonces at once with the multi-way slow hash, one context per nonce. The job's own
+  // nonce is left as it was.
+  void getLongHashes(crypto::cn_context* contexts, const uint32_t* nonces, size_t count, crypto::Hash* hashes);
+
+private:
+  BinaryArray m_blob;
+  std::vector<BinaryArray> m_blobs; // copies of m_blob patched for getLongHashes
+  size_t m_nonceOffset;
+  uint8_t m_majorVersion;
+};
+
+}
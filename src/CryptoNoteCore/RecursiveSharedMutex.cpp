@@ -0,0 +1,114 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RecursiveSharedMutex.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace cn {
+
+namespace {
+
+uint64_t microsecondsSince(std::chrono::steady_clock::time_point start) {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+}
+
+RecursiveSharedMutex::RecursiveSharedMutex() : m_ownerDepth(0), m_waitingWriters(0), m_statistics() {
+}
+
+void RecursiveSharedMutex::lock() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_ownerDepth > 0 && m_owner == self) {
+    ++m_ownerDepth;
+    return;
+  }
+
+  if (m_readers.count(self) > 0) {
+    throw std::logic_error("RecursiveSharedMutex: exclusive lock requested by a thread holding the shared lock");
+  }
+
+  ++m_statistics.exclusiveLocks;
+  if (m_ownerDepth > 0 || !m_readers.empty()) {
+    auto start = std::chrono::steady_clock::now();
+    ++m_waitingWriters;
+    m_writersCondition.wait(lock, [this] { return m_ownerDepth == 0 && m_readers.empty(); });
+    --m_waitingWriters;
+    ++m_statistics.exclusiveWaits;
+    m_statistics.exclusiveWaitMicroseconds += microsecondsSince(start);
+  }
+
+  m_owner = self;
+  m_ownerDepth = 1;
+}
+
+void RecursiveSharedMutex::unlock() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (--m_ownerDepth > 0) {
+    return;
+  }
+
+  m_owner = std::thread::id();
+  if (m_waitingWriters > 0) {
+    m_writersCondition.notify_one();
+  } else {
+    m_readersCondition.notify_all();
+  }
+}
+
+void RecursiveSharedMutex::lock_shared() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_ownerDepth > 0 && m_owner == self) {
+    ++m_ownerDepth;
+    return;
+  }
+
+  auto it = m_readers.find(self);
+  if (it != m_readers.end()) {
+    // re-entered reads are let through even past waiting writers, which wait for this thread anyway
+    ++it->second;
+    return;
+  }
+
+  ++m_statistics.sharedLocks;
+  if (m_ownerDepth > 0 || m_waitingWriters > 0) {
+    auto start = std::chrono::steady_clock::now();
+    m_readersCondition.wait(lock, [this] { return m_ownerDepth == 0 && m_waitingWriters == 0; });
+    ++m_statistics.sharedWaits;
+    m_statistics.sharedWaitMicroseconds += microsecondsSince(start);
+  }
+
+  m_readers.emplace(self, 1);
+}
+
+void RecursiveSharedMutex::unlock_shared() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::thread::id self = std::this_thread::get_id();
+  if (m_ownerDepth > 0 && m_owner == self) {
+    --m_ownerDepth;
+    return;
+  }
+
+  auto it = m_readers.find(self);
+  if (--it->second > 0) {
+    return;
+  }
+
+  m_readers.erase(it);
+  if (m_readers.empty() && m_waitingWriters > 0) {
+    m_writersCondition.notify_one();
+  }
+}
+
+RecursiveSharedMutex::Statistics RecursiveSharedMutex::statistics() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_statistics;
+}
+
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace cn {
+
+// Reader/writer lock that can be re-entered by the thread holding it, like std::recursive_mutex.
+// A thread holding the exclusive lock may also take the shared one. Taking the exclusive lock
+// while holding only the shared one would deadlock and throws std::logic_error instead.
+// Waiting writers block new readers, so block import doesn't starve behind RPC reads.
+class RecursiveSharedMutex {
+public:
+  struct Statistics {
+    uint64_t sharedLocks;
+    uint64_t sharedWaits;
+    uint64_t sharedWaitMicroseconds;
+    uint64_t exclusiveLocks;
+    uint64_t exclusiveWaits;
+    uint64_t exclusiveWaitMicroseconds;
+  };
+
+  RecursiveSharedMutex();
+  RecursiveSharedMutex(const RecursiveSharedMutex&) = delete;
+  RecursiveSharedMutex& operator=(const RecursiveSharedMutex&) = delete;
+
+  void lock();
+  void unlock();
+
+  void lock_shared();
+  void unlock_shared();
+
+  Statistics statistics() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::condition_variable m_readersCondition;
+  std::condition_variable m_writersCondition;
+  std::thread::id m_owner;
+  size_t m_ownerDepth;
+  size_t m_waitingWriters;
+  std::unordered_map<std::thread::id, size_t> m_readers;
+  Statistics m_statistics;
+};
+
+template<class Mutex>
+class SharedLockGuard {
+public:
+  explicit SharedLockGuard(Mutex& mutex) : m_mutex(mutex) {
+    m_mutex.lock_shared();
+  }
+
+  ~SharedLockGuard() {
+    m_mutex.unlock_shared();
+  }
+
+  SharedLockGuard(const SharedLockGuard&) = delete;
+  SharedLockGuard& operator=(const SharedLockGuard&) = delete;
+
+private:
+  Mutex& m_mutex;
+};
+
+}
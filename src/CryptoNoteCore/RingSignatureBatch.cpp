@@ -0,0 +1,116 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "RingSignatureBatch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+
+namespace cn {
+
+namespace {
+
+// Fewer checks than this are verified on the calling thread, starting threads would cost more
+const size_t MIN_PARALLEL_CHECKS = 4;
+
+}
+
+bool checkKeyInputSignature(const crypto::Hash& prefixHash, const crypto::KeyImage& keyImage,
+  const crypto::PublicKey* const* outputKeys, size_t outputKeyCount, const crypto::Signature* signatures) {
+  static const crypto::KeyImage I = { {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 } };
+  static const crypto::KeyImage L = { {0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 } };
+  if (!(crypto::scalarmultKey(keyImage, L) == I)) {
+    return false;
+  }
+
+  return crypto::check_ring_signature(prefixHash, keyImage, outputKeys, outputKeyCount, signatures);
+}
+
+void RingSignatureBatch::add(size_t transactionIndex, size_t inputIndex, const crypto::Hash& prefixHash, const crypto::KeyImage& keyImage,
+  const std::vector<const crypto::PublicKey*>& outputKeys, const std::vector<crypto::Signature>& signatures) {
+  Check item = { transactionIndex, inputIndex, prefixHash, keyImage, m_keys.size(), outputKeys.size(), m_signatures.size() };
+  for (const crypto::PublicKey* key : outputKeys) {
+    m_keys.push_back(*key);
+  }
+
+  m_signatures.insert(m_signatures.end(), signatures.begin(), signatures.end());
+  m_checks.push_back(item);
+}
+
+void RingSignatureBatch::clear() {
+  m_checks.clear();
+  m_keys.clear();
+  m_signatures.clear();
+}
+
+size_t RingSignatureBatch::size() const {
+  return m_checks.size();
+}
+
+bool RingSignatureBatch::empty() const {
+  return m_checks.empty();
+}
+
+bool RingSignatureBatch::verify(size_t threadCount, Failure& failure) const {
+  size_t failed = m_checks.size();
+  if (threadCount <= 1 || m_checks.size() < MIN_PARALLEL_CHECKS) {
+    for (size_t i = 0; i < m_checks.size(); ++i) {
+      if (!check(m_checks[i])) {
+        failed = i;
+        break;
+      }
+    }
+  } else {
+    // Threads take checks in order and skip the ones past a known failure, so every check before
+    // the first failed one is still verified and that failure is the one reported
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> firstFailed(m_checks.size());
+    auto worker = [&] {
+      for (size_t i = next++; i < m_checks.size(); i = next++) {
+        if (i > firstFailed.load()) {
+          break;
+        }
+
+        if (!check(m_checks[i])) {
+          size_t current = firstFailed.load();
+          while (i < current && !firstFailed.compare_exchange_weak(current, i)) {
+          }
+        }
+      }
+    };
+
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < std::min(threadCount, m_checks.size()); ++i) {
+      workers.push_back(std::async(std::launch::async, worker));
+    }
+
+    worker();
+    for (auto& w : workers) {
+      w.get();
+    }
+
+    failed = firstFailed.load();
+  }
+
+  if (failed == m_checks.size()) {
+    return true;
+  }
+
+  failure.transactionIndex = m_checks[failed].transactionIndex;
+  failure.inputIndex = m_checks[failed].inputIndex;
+  return false;
+}
+
+bool RingSignatureBatch::check(const Check& item) const {
+  std::vector<const crypto::PublicKey*> keys(item.keyCount);
+  for (size_t i = 0; i < item.keyCount; ++i) {
+    keys[i] = &m_keys[item.firstKey + i];
+  }
+
+  return checkKeyInputSignature(item.prefixHash, item.keyImage, keys.data(), keys.size(), &m_signatures[item.firstSignature]);
+}
+
+}
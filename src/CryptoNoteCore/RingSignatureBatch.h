@@ -0,0 +1,58 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace cn {
+
+// Checks that the key image lies in the prime order subgroup and verifies the ring signature.
+bool checkKeyInputSignature(const crypto::Hash& prefixHash, const crypto::KeyImage& keyImage,
+  const crypto::PublicKey* const* outputKeys, size_t outputKeyCount, const crypto::Signature* signatures);
+
+// Ring signatures of the key inputs of a block, collected while the inputs are validated against the
+// chain and checked afterwards on several threads. The signature check needs no chain state, so
+// the output keys are copied in and the checks may run after the block store cache has moved on.
+class RingSignatureBatch {
+public:
+  struct Failure {
+    size_t transactionIndex;
+    size_t inputIndex;
+  };
+
+  void add(size_t transactionIndex, size_t inputIndex, const crypto::Hash& prefixHash, const crypto::KeyImage& keyImage,
+    const std::vector<const crypto::PublicKey*>& outputKeys, const std::vector<crypto::Signature>& signatures);
+  void clear();
+
+  size_t size() const;
+  bool empty() const;
+
+  // Verifies every signature using up to threadCount threads. On failure reports the first failed
+  // input in the order the inputs were added, whatever order the threads finished in.
+  bool verify(size_t threadCount, Failure& failure) const;
+
+private:
+  struct Check {
+    size_t transactionIndex;
+    size_t inputIndex;
+    crypto::Hash prefixHash;
+    crypto::KeyImage keyImage;
+    size_t firstKey;
+    size_t keyCount;
+    size_t firstSignature;
+  };
+
+  bool check(const Check& item) const;
+
+  std::vector<Check> m_checks;
+  std::vector<crypto::PublicKey> m_keys;
+  std::vector<crypto::Signature> m_signatures;
+};
+
+}
@@ -0,0 +1,80 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "SignatureCache.h"
+
+#include <sstream>
+
+#include "crypto/hash.h"
+
+namespace cn {
+
+SignatureCache::SignatureCache(size_t capacity) : m_capacity(capacity), m_hits(0), m_misses(0) {
+}
+
+crypto::Hash SignatureCache::makeKey(const crypto::Hash& prefixHash, size_t inputIndex, const std::vector<const crypto::PublicKey*>& outputKeys,
+  const std::vector<crypto::Signature>& signatures) {
+  uint64_t index = inputIndex;
+  std::vector<uint8_t> data;
+  data.reserve(sizeof(prefixHash) + sizeof(index) + outputKeys.size() * sizeof(crypto::PublicKey) + signatures.size() * sizeof(crypto::Signature));
+  data.insert(data.end(), prefixHash.data, prefixHash.data + sizeof(prefixHash));
+  data.insert(data.end(), reinterpret_cast<const uint8_t*>(&index), reinterpret_cast<const uint8_t*>(&index) + sizeof(index));
+  for (const crypto::PublicKey* key : outputKeys) {
+    data.insert(data.end(), key->data, key->data + sizeof(*key));
+  }
+
+  for (const crypto::Signature& signature : signatures) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&signature);
+    data.insert(data.end(), bytes, bytes + sizeof(signature));
+  }
+
+  crypto::Hash key;
+  crypto::cn_fast_hash(data.data(), data.size(), key);
+  return key;
+}
+
+bool SignatureCache::contains(const crypto::Hash& key) {
+  bool found;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    found = m_keys.count(key) != 0;
+  }
+
+  ++(found ? m_hits : m_misses);
+  return found;
+}
+
+void SignatureCache::insert(const crypto::Hash& key) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_capacity == 0 || !m_keys.insert(key).second) {
+    return;
+  }
+
+  m_order.push_back(key);
+  if (m_order.size() > m_capacity) {
+    m_keys.erase(m_order.front());
+    m_order.pop_front();
+  }
+}
+
+SignatureCache::Statistics SignatureCache::getStatistics() const {
+  Statistics statistics;
+  statistics.hits = m_hits.load();
+  statistics.misses = m_misses.load();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  statistics.size = m_keys.size();
+  return statistics;
+}
+
+std::string SignatureCache::toString() const {
+  Statistics statistics = getStatistics();
+  uint64_t lookups = statistics.hits + statistics.misses;
+  std::ostringstream stream;
+  stream << "hits " << statistics.hits << ", misses " << statistics.misses << ", hit rate " <<
+    (lookups == 0 ? 0 : statistics.hits * 100 / lookups) << "%, entries " << statistics.size;
+  return stream.str();
+}
+
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/crypto.h"
+
+namespace cn {
+
+// Key inputs whose ring signature has been verified, so a transaction checked when it entered the
+// pool is not checked again when the pool revalidates it or its block arrives. The prefix hash
+// does not cover the signatures, an entry is keyed by the signatures and the ring keys as well,
+// and only the inputs that passed are kept. The oldest entries are dropped past the capacity.
+class SignatureCache {
+public:
+  struct Statistics {
+    uint64_t hits;
+    uint64_t misses;
+    size_t size;
+  };
+
+  explicit SignatureCache(size_t capacity);
+
+  static crypto::Hash makeKey(const crypto::Hash& prefixHash, size_t inputIndex, const std::vector<const crypto::PublicKey*>& outputKeys,
+    const std::vector<crypto::Signature>& signatures);
+
+  // Counts a hit or a miss
+  bool contains(const crypto::Hash& key);
+  void insert(const crypto::Hash& key);
+
+  Statistics getStatistics() const;
+  // "hits, misses, hit rate, entries" on one line
+  std::string toString() const;
+
+private:
+  const size_t m_capacity;
+  mutable std::mutex m_mutex;
+  std::unordered_set<crypto::Hash> m_keys;
+  std::deque<crypto::Hash> m_order;
+  std::atomic<uint64_t> m_hits;
+  std::atomic<uint64_t> m_misses;
+};
+
+}
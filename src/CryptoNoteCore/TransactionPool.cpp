@@ -33,6 +33,13 @@ using namespace logging;
 
 #undef ERROR
 
+namespace {
+
+// Changes kept for getChangesSince, a client further behind gets the whole ready set
+const size_t POOL_CHANGES_LOG_SIZE = 100000;
+
+}
+
 namespace cn {
 
   //---------------------------------------------------------------------------------
@@ -102,7 +109,10 @@ namespace cn {
     m_timeProvider(timeProvider),
     m_txCheckInterval(60, timeProvider),
     m_fee_index(boost::get<1>(m_transactions)),
-    logger(log, "txpool") {
+    logger(log, "txpool"),
+    // versions of an earlier run are older than the first one of this run
+    m_version(static_cast<uint64_t>(timeProvider.now()) << 32),
+    m_oldestVersion(m_version) {
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::add_tx(const Transaction &tx, /*const crypto::Hash& tx_prefix_hash,*/ const crypto::Hash &id, size_t blobSize, tx_verification_context& tvc, bool keptByBlock, uint32_t height) {
@@ -220,6 +230,8 @@ namespace cn {
       if (ttl.ttl != 0) {
         m_ttlIndex.emplace(std::make_pair(id, ttl.ttl));
       }
+
+      m_uncheckedTransactions.insert(id);
     }
 
     tvc.m_added_to_pool = true;
@@ -271,13 +283,13 @@ namespace cn {
     }
   }
   //---------------------------------------------------------------------------------
-  void tx_memory_pool::get_difference(const std::vector<crypto::Hash>& known_tx_ids, std::vector<crypto::Hash>& new_tx_ids, std::vector<crypto::Hash>& deleted_tx_ids) const {
+  void tx_memory_pool::get_difference(const std::vector<crypto::Hash>& known_tx_ids, std::vector<crypto::Hash>& new_tx_ids, std::vector<crypto::Hash>& deleted_tx_ids) {
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    updateReadiness();
     std::unordered_set<crypto::Hash> ready_tx_ids;
-    for (const auto& tx : m_transactions) {
-      TransactionCheckInfo checkInfo(tx);
-      if (is_transaction_ready_to_go(tx.tx, checkInfo)) {
-        ready_tx_ids.insert(tx.id);
+    for (const auto& tx : m_readyTransactions) {
+      if (tx.second) {
+        ready_tx_ids.insert(tx.first);
       }
     }
 
@@ -297,11 +309,95 @@ namespace cn {
     deleted_tx_ids.assign(known_set.begin(), known_set.end());
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const crypto::Hash& top_block_id) {
+  bool tx_memory_pool::getChangesSince(uint64_t version, std::vector<crypto::Hash>& added, std::vector<crypto::Hash>& deleted, uint64_t& currentVersion) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    updateReadiness();
+    currentVersion = m_version;
+
+    if (version < m_oldestVersion || version > m_version) {
+      for (const auto& tx : m_readyTransactions) {
+        if (tx.second) {
+          added.push_back(tx.first);
+        }
+      }
+
+      return false;
+    }
+
+    // first and last change of every transaction, a transaction that ended as it started is left out
+    std::unordered_map<crypto::Hash, std::pair<bool, bool>> changes;
+    auto begin = std::upper_bound(m_changes.begin(), m_changes.end(), version, [](uint64_t v, const PoolChange& change) {
+      return v < change.version;
+    });
+
+    for (auto it = begin; it != m_changes.end(); ++it) {
+      auto inserted = changes.emplace(it->id, std::make_pair(it->ready, it->ready));
+      inserted.first->second.second = it->ready;
+    }
+
+    for (const auto& change : changes) {
+      if (change.second.first == change.second.second) {
+        (change.second.second ? added : deleted).push_back(change.first);
+      }
+    }
+
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::on_blockchain_inc(uint64_t new_block_height, const crypto::Hash& top_block_id, const std::vector<Transaction>& transactions) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+
+    // the block may have made their inputs usable
+    for (const auto& tx : m_readyTransactions) {
+      if (!tx.second) {
+        m_uncheckedTransactions.insert(tx.first);
+      }
+    }
+
+    GlobalOutputsContainer spentOutputs;
+    for (const auto& tx : transactions) {
+      for (const auto& in : tx.inputs) {
+        if (in.type() == typeid(KeyInput)) {
+          auto it = m_spent_key_images.find(boost::get<KeyInput>(in).keyImage);
+          if (it != m_spent_key_images.end()) {
+            m_uncheckedTransactions.insert(it->second.begin(), it->second.end());
+          }
+        } else if (in.type() == typeid(MultisignatureInput)) {
+          const auto& msig = boost::get<MultisignatureInput>(in);
+          spentOutputs.insert(GlobalOutput(msig.amount, msig.outputIndex));
+        }
+      }
+    }
+
+    if (spentOutputs.empty()) {
+      return true;
+    }
+
+    for (const auto& tx : m_readyTransactions) {
+      auto txIt = m_transactions.find(tx.first);
+      bool spends = tx.second && txIt != m_transactions.end() && std::any_of(txIt->tx.inputs.begin(), txIt->tx.inputs.end(), [&spentOutputs](const TransactionInput& in) {
+        if (in.type() != typeid(MultisignatureInput)) {
+          return false;
+        }
+
+        const auto& msig = boost::get<MultisignatureInput>(in);
+        return spentOutputs.count(GlobalOutput(msig.amount, msig.outputIndex)) != 0;
+      });
+
+      if (spends) {
+        m_uncheckedTransactions.insert(tx.first);
+      }
+    }
+
     return true;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::on_blockchain_dec(uint64_t new_block_height, const crypto::Hash& top_block_id) {
+    std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
+    for (const auto& tx : m_transactions) {
+      m_uncheckedTransactions.insert(tx.id);
+    }
+
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -342,6 +438,50 @@ namespace cn {
     return true;
   }
   //---------------------------------------------------------------------------------
+  bool tx_memory_pool::isTransactionReady(const TransactionDetails& txd) {
+    auto it = m_readyTransactions.find(txd.id);
+    if (it != m_readyTransactions.end() && m_uncheckedTransactions.count(txd.id) == 0) {
+      return it->second;
+    }
+
+    TransactionCheckInfo checkInfo(txd);
+    bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
+
+    // keep the checked blocks so the next check after a block skips the ring signatures
+    m_transactions.modify(m_transactions.find(txd.id), [&checkInfo](TransactionDetails& details) {
+      static_cast<TransactionCheckInfo&>(details) = checkInfo;
+    });
+
+    bool wasReady = it != m_readyTransactions.end() && it->second;
+    m_readyTransactions[txd.id] = ready;
+    m_uncheckedTransactions.erase(txd.id);
+    if (ready != wasReady) {
+      addChange(txd.id, ready);
+    }
+
+    return ready;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::updateReadiness() {
+    std::vector<crypto::Hash> unchecked(m_uncheckedTransactions.begin(), m_uncheckedTransactions.end());
+    for (const auto& id : unchecked) {
+      auto it = m_transactions.find(id);
+      if (it != m_transactions.end()) {
+        isTransactionReady(*it);
+      } else {
+        m_uncheckedTransactions.erase(id);
+      }
+    }
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::addChange(const crypto::Hash& id, bool ready) {
+    m_changes.push_back({ ++m_version, id, ready });
+    if (m_changes.size() > POOL_CHANGES_LOG_SIZE) {
+      m_oldestVersion = m_changes.front().version;
+      m_changes.pop_front();
+    }
+  }
+  //---------------------------------------------------------------------------------
   std::string tx_memory_pool::print_pool(bool short_format) const {
     std::stringstream ss;
     std::lock_guard<std::recursive_mutex> lock(m_transactions_lock);
@@ -404,10 +544,7 @@ namespace cn {
         continue;
       }
 
-      TransactionCheckInfo checkInfo(txd);
-      bool ready = is_transaction_ready_to_go(txd.tx, checkInfo);
-
-      if (ready && blockTemplate.addTransaction(txd.id, txd.tx)) 
+      if (isTransactionReady(txd) && blockTemplate.addTransaction(txd.id, txd.tx)) 
       {
         total_size += txd.blobSize;
         fee += txd.fee;
@@ -438,6 +575,8 @@ namespace cn {
       m_paymentIdIndex.clear();
       m_timestampIndex.clear();
       m_ttlIndex.clear();
+      m_readyTransactions.clear();
+      m_uncheckedTransactions.clear();
     } else {
       buildIndices();
     }
@@ -496,6 +635,8 @@ namespace cn {
 
     if (s.type() == ISerializer::INPUT) {
       m_transactions.clear();
+      m_readyTransactions.clear();
+      m_uncheckedTransactions.clear();
       readSequence<TransactionDetails>(std::inserter(m_transactions, m_transactions.end()), "transactions", s);
     } else {
       writeSequence<TransactionDetails>(m_transactions.begin(), m_transactions.end(), "transactions", s);
@@ -563,6 +704,17 @@ namespace cn {
     m_paymentIdIndex.remove(i->tx);
     m_timestampIndex.remove(i->receiveTime, i->id);
     m_ttlIndex.erase(i->id);
+
+    auto ready = m_readyTransactions.find(i->id);
+    if (ready != m_readyTransactions.end()) {
+      if (ready->second) {
+        addChange(i->id, false);
+      }
+
+      m_readyTransactions.erase(ready);
+    }
+
+    m_uncheckedTransactions.erase(i->id);
     return m_transactions.erase(i);
   }
 
@@ -661,6 +813,7 @@ namespace cn {
     for (auto it = m_transactions.begin(); it != m_transactions.end(); it++) {
       m_paymentIdIndex.add(it->tx);
       m_timestampIndex.add(it->receiveTime, it->id);
+      m_uncheckedTransactions.insert(it->id);
 
       std::vector<TransactionExtraField> txExtraFields;
       parseTransactionExtra(it->tx.extra, txExtraFields);
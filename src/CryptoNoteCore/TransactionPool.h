@@ -6,10 +6,12 @@
 
 #pragma once
 
+#include <deque>
 #include <list>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <boost/utility.hpp>
 
@@ -92,7 +94,8 @@ namespace cn {
     //gets tx and remove it from pool
     bool take_tx(const crypto::Hash &id, Transaction &tx, size_t& blobSize, uint64_t& fee);
 
-    bool on_blockchain_inc(uint64_t new_block_height, const crypto::Hash& top_block_id);
+    // called by the blockchain with the transactions of the pushed block, keep ready transactions ready
+    bool on_blockchain_inc(uint64_t new_block_height, const crypto::Hash& top_block_id, const std::vector<Transaction>& transactions);
     bool on_blockchain_dec(uint64_t new_block_height, const crypto::Hash& top_block_id);
 
     void lock() const;
@@ -102,7 +105,10 @@ namespace cn {
     bool fill_block_template(Block &bl, size_t median_size, size_t maxCumulativeSize, uint64_t already_generated_coins, size_t &total_size, uint64_t &fee, uint32_t& height);
 
     void get_transactions(std::list<Transaction>& txs) const;
-    void get_difference(const std::vector<crypto::Hash>& known_tx_ids, std::vector<crypto::Hash>& new_tx_ids, std::vector<crypto::Hash>& deleted_tx_ids) const;
+    void get_difference(const std::vector<crypto::Hash>& known_tx_ids, std::vector<crypto::Hash>& new_tx_ids, std::vector<crypto::Hash>& deleted_tx_ids);
+    // Ready transactions that appeared or went away after version. Returns false when the version is
+    // not one of the kept changes, added then holds every ready transaction.
+    bool getChangesSince(uint64_t version, std::vector<crypto::Hash>& added, std::vector<crypto::Hash>& deleted, uint64_t& currentVersion);
     size_t get_transactions_count() const;
     std::string print_pool(bool short_format) const;
     void on_idle();
@@ -185,6 +191,9 @@ namespace cn {
     tx_container_t::iterator removeTransaction(tx_container_t::iterator i);
     bool removeExpiredTransactions();
     bool is_transaction_ready_to_go(const Transaction& tx, TransactionCheckInfo& txd) const;
+    bool isTransactionReady(const TransactionDetails& txd);
+    void updateReadiness();
+    void addChange(const crypto::Hash& id, bool ready);
 
     void buildIndices();
 
@@ -208,5 +217,21 @@ namespace cn {
     PaymentIdIndex m_paymentIdIndex;
     TimestampTransactionsIndex m_timestampIndex;
     std::unordered_map<crypto::Hash, uint64_t> m_ttlIndex;
+
+    struct PoolChange {
+      uint64_t version;
+      crypto::Hash id;
+      bool ready;
+    };
+
+    // Last is_transaction_ready_to_go result of every checked transaction. A pushed block marks the
+    // transactions spending its key images or multisignature outputs and the ones not ready yet as
+    // unchecked, a popped block marks all of them; they are checked again when next asked for.
+    std::unordered_map<crypto::Hash, bool> m_readyTransactions;
+    std::unordered_set<crypto::Hash> m_uncheckedTransactions;
+    // every change of m_readyTransactions, the ones after m_oldestVersion are kept
+    std::deque<PoolChange> m_changes;
+    uint64_t m_version;
+    uint64_t m_oldestVersion;
   };
 }
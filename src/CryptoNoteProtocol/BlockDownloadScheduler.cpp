@@ -0,0 +1,238 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+
+namespace cn {
+
+namespace {
+
+// A span is late once its holder took LATE_SPAN_FACTOR times longer than its throughput promises
+const double LATE_SPAN_FACTOR = 3;
+const std::chrono::seconds MIN_SPAN_TIMEOUT(10);
+const std::chrono::seconds UNKNOWN_PEER_SPAN_TIMEOUT(30);
+const std::chrono::seconds CHAIN_REQUEST_TIMEOUT(30);
+// Weight of the latest span in the throughput of a peer
+const double THROUGHPUT_SMOOTHING = 0.3;
+
+}
+
+const uint32_t BlockDownloadScheduler::NO_HEIGHT;
+
+BlockDownloadScheduler::BlockDownloadScheduler(size_t spanSize, size_t maxSpansAhead) :
+  m_spanSize(spanSize),
+  m_maxSpansAhead(maxSpansAhead),
+  m_chainRequested(false),
+  m_chainPeer(boost::uuids::uuid()) {
+}
+
+uint32_t BlockDownloadScheduler::addChain(uint32_t startHeight, const std::vector<crypto::Hash>& blockIds) {
+  if (blockIds.empty()) {
+    return NO_HEIGHT;
+  }
+
+  if (m_spans.empty()) {
+    appendSpans(startHeight, blockIds.begin(), blockIds.end());
+    return NO_HEIGHT;
+  }
+
+  uint32_t end = endHeight();
+  if (startHeight > end) {
+    return NO_HEIGHT;
+  }
+
+  for (size_t s = 0; s < m_spans.size(); ++s) {
+    const Span& span = m_spans[s].span;
+    for (size_t i = 0; i < span.blockIds.size(); ++i) {
+      uint32_t height = span.height + static_cast<uint32_t>(i);
+      if (height < startHeight) {
+        continue;
+      }
+
+      if (height - startHeight >= blockIds.size()) {
+        break;
+      }
+
+      if (span.blockIds[i] == blockIds[height - startHeight]) {
+        continue;
+      }
+
+      // The entry forks off inside this span: the span is rebuilt from its agreeing head and the entry
+      uint32_t dropped = span.height;
+      std::vector<crypto::Hash> ids(span.blockIds.begin(), span.blockIds.begin() + (std::max(startHeight, dropped) - dropped));
+      ids.insert(ids.end(), blockIds.begin() + (std::max(startHeight, dropped) - startHeight), blockIds.end());
+      m_spans.erase(m_spans.begin() + s, m_spans.end());
+      appendSpans(dropped, ids.begin(), ids.end());
+      return dropped;
+    }
+  }
+
+  if (end - startHeight < blockIds.size()) {
+    appendSpans(end, blockIds.begin() + (end - startHeight), blockIds.end());
+  }
+
+  return NO_HEIGHT;
+}
+
+bool BlockDownloadScheduler::assign(const PeerId& peer, uint32_t peerTopHeight, Clock::time_point now, Span& span) {
+  release(peer);
+
+  size_t limit = std::min(m_spans.size(), m_maxSpansAhead + 1);
+  SpanEntry* chosen = nullptr;
+  for (size_t i = 0; i < limit && chosen == nullptr; ++i) {
+    SpanEntry& entry = m_spans[i];
+    if (entry.state == SPAN_PENDING && entry.span.height + entry.span.blockIds.size() - 1 <= peerTopHeight) {
+      chosen = &entry;
+    }
+  }
+
+  double throughput = peerThroughput(peer);
+  for (size_t i = 0; i < limit && chosen == nullptr; ++i) {
+    SpanEntry& entry = m_spans[i];
+    if (entry.state == SPAN_REQUESTED && entry.peer != peer && entry.span.height + entry.span.blockIds.size() - 1 <= peerTopHeight &&
+        isLate(entry, now)) {
+      double holderThroughput = peerThroughput(entry.peer);
+      if (holderThroughput == 0 || throughput > holderThroughput) {
+        // the holder is slower than it claimed, trust it less with the next span
+        auto holder = m_peers.find(entry.peer);
+        if (holder != m_peers.end()) {
+          holder->second.blocksPerSecond /= 2;
+        }
+
+        chosen = &entry;
+      }
+    }
+  }
+
+  if (chosen == nullptr) {
+    return false;
+  }
+
+  chosen->state = SPAN_REQUESTED;
+  chosen->peer = peer;
+  chosen->requestTime = now;
+  auto& statistics = m_peers.insert(std::make_pair(peer, PeerStatistics{ 0, now })).first->second;
+  statistics.requestTime = now;
+  span = chosen->span;
+  return true;
+}
+
+bool BlockDownloadScheduler::complete(const PeerId& peer, const crypto::Hash& firstBlockId, size_t blockCount, Clock::time_point now, uint32_t& height) {
+  auto it = std::find_if(m_spans.begin(), m_spans.end(), [&firstBlockId](const SpanEntry& entry) {
+    return entry.span.blockIds.front() == firstBlockId;
+  });
+
+  if (it == m_spans.end() || it->state == SPAN_DOWNLOADED || it->span.blockIds.size() != blockCount) {
+    return false;
+  }
+
+  auto statistics = m_peers.find(peer);
+  if (statistics != m_peers.end()) {
+    std::chrono::duration<double> elapsed = now - statistics->second.requestTime;
+    double blocksPerSecond = blockCount / std::max(elapsed.count(), 0.001);
+    double& average = statistics->second.blocksPerSecond;
+    average = average == 0 ? blocksPerSecond : average + THROUGHPUT_SMOOTHING * (blocksPerSecond - average);
+  }
+
+  it->state = SPAN_DOWNLOADED;
+  height = it->span.height;
+  return true;
+}
+
+void BlockDownloadScheduler::release(const PeerId& peer) {
+  for (SpanEntry& entry : m_spans) {
+    if (entry.state == SPAN_REQUESTED && entry.peer == peer) {
+      entry.state = SPAN_PENDING;
+    }
+  }
+}
+
+void BlockDownloadScheduler::removePeer(const PeerId& peer) {
+  release(peer);
+  finishChainRequest(peer);
+  m_peers.erase(peer);
+}
+
+bool BlockDownloadScheduler::popDownloaded(uint32_t& height) {
+  if (m_spans.empty() || m_spans.front().state != SPAN_DOWNLOADED) {
+    return false;
+  }
+
+  height = m_spans.front().span.height;
+  m_spans.pop_front();
+  return true;
+}
+
+void BlockDownloadScheduler::clear() {
+  m_spans.clear();
+  m_chainRequested = false;
+}
+
+bool BlockDownloadScheduler::startChainRequest(const PeerId& peer, Clock::time_point now) {
+  if (m_chainRequested && m_chainPeer != peer && now - m_chainRequestTime < CHAIN_REQUEST_TIMEOUT) {
+    return false;
+  }
+
+  m_chainRequested = true;
+  m_chainPeer = peer;
+  m_chainRequestTime = now;
+  return true;
+}
+
+void BlockDownloadScheduler::finishChainRequest(const PeerId& peer) {
+  if (m_chainRequested && m_chainPeer == peer) {
+    m_chainRequested = false;
+  }
+}
+
+bool BlockDownloadScheduler::empty() const {
+  return m_spans.empty();
+}
+
+bool BlockDownloadScheduler::hasPendingSpans() const {
+  return std::any_of(m_spans.begin(), m_spans.end(), [](const SpanEntry& entry) { return entry.state == SPAN_PENDING; });
+}
+
+uint32_t BlockDownloadScheduler::endHeight() const {
+  if (m_spans.empty()) {
+    return NO_HEIGHT;
+  }
+
+  return m_spans.back().span.height + static_cast<uint32_t>(m_spans.back().span.blockIds.size());
+}
+
+double BlockDownloadScheduler::peerThroughput(const PeerId& peer) const {
+  auto it = m_peers.find(peer);
+  return it == m_peers.end() ? 0 : it->second.blocksPerSecond;
+}
+
+bool BlockDownloadScheduler::isLate(const SpanEntry& entry, Clock::time_point now) const {
+  double throughput = peerThroughput(entry.peer);
+  Clock::duration timeout = UNKNOWN_PEER_SPAN_TIMEOUT;
+  if (throughput != 0) {
+    timeout = std::max<Clock::duration>(MIN_SPAN_TIMEOUT,
+      std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(LATE_SPAN_FACTOR * entry.span.blockIds.size() / throughput)));
+  }
+
+  return now - entry.requestTime > timeout;
+}
+
+void BlockDownloadScheduler::appendSpans(uint32_t height, std::vector<crypto::Hash>::const_iterator begin, std::vector<crypto::Hash>::const_iterator end) {
+  while (begin != end) {
+    auto spanEnd = begin + std::min(static_cast<size_t>(end - begin), m_spanSize);
+    SpanEntry entry;
+    entry.span.height = height;
+    entry.span.blockIds.assign(begin, spanEnd);
+    entry.state = SPAN_PENDING;
+    entry.peer = boost::uuids::uuid();
+    m_spans.push_back(std::move(entry));
+    height += static_cast<uint32_t>(spanEnd - begin);
+    begin = spanEnd;
+  }
+}
+
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <map>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include "crypto/hash.h"
+
+namespace cn {
+
+// Splits the block ids learned from chain entries into spans of consecutive heights and hands them
+// out to all synchronizing peers at once. Spans are downloaded in any order and imported strictly
+// in height order, at most maxSpansAhead spans past the next one to import are handed out.
+//
+// Every peer holds at most one span. A peer asking for work while nothing is left to hand out takes
+// over a span its holder is late with, if it has been faster than the holder so far. Lateness is
+// measured against the holder's own throughput.
+class BlockDownloadScheduler {
+public:
+  typedef boost::uuids::uuid PeerId;
+  typedef std::chrono::steady_clock Clock;
+
+  struct Span {
+    uint32_t height;
+    std::vector<crypto::Hash> blockIds;
+  };
+
+  static const uint32_t NO_HEIGHT = std::numeric_limits<uint32_t>::max();
+
+  BlockDownloadScheduler(size_t spanSize, size_t maxSpansAhead);
+
+  // Adds the ids of a chain entry, blockIds[0] being at startHeight. Spans that disagree with the
+  // entry are dropped together with everything above them; returns the lowest dropped height or
+  // NO_HEIGHT. An entry that doesn't connect to the known ids is ignored.
+  uint32_t addChain(uint32_t startHeight, const std::vector<crypto::Hash>& blockIds);
+
+  // Hands a span ending at or below peerTopHeight to the peer, releasing the span it held before
+  bool assign(const PeerId& peer, uint32_t peerTopHeight, Clock::time_point now, Span& span);
+  // Marks the span starting with firstBlockId as downloaded. Returns false if it was already
+  // downloaded or isn't known, the blocks are of no use then.
+  bool complete(const PeerId& peer, const crypto::Hash& firstBlockId, size_t blockCount, Clock::time_point now, uint32_t& height);
+  // Returns the span of the peer to the pending ones
+  void release(const PeerId& peer);
+  void removePeer(const PeerId& peer);
+  // Removes the lowest span if it is downloaded, its blocks are next to import
+  bool popDownloaded(uint32_t& height);
+  void clear();
+
+  // Allows one peer at a time to fetch more block ids, until they arrive or the request times out
+  bool startChainRequest(const PeerId& peer, Clock::time_point now);
+  void finishChainRequest(const PeerId& peer);
+
+  bool empty() const;
+  bool hasPendingSpans() const;
+  // Height after the last known block id, NO_HEIGHT if no ids are known
+  uint32_t endHeight() const;
+  // Blocks per second the peer delivered so far, 0 if unknown
+  double peerThroughput(const PeerId& peer) const;
+
+private:
+  enum SpanState {
+    SPAN_PENDING,
+    SPAN_REQUESTED,
+    SPAN_DOWNLOADED
+  };
+
+  struct SpanEntry {
+    Span span;
+    SpanState state;
+    PeerId peer;
+    Clock::time_point requestTime;
+  };
+
+  struct PeerStatistics {
+    double blocksPerSecond;
+    Clock::time_point requestTime;
+  };
+
+  bool isLate(const SpanEntry& entry, Clock::time_point now) const;
+  void appendSpans(uint32_t height, std::vector<crypto::Hash>::const_iterator begin, std::vector<crypto::Hash>::const_iterator end);
+
+  size_t m_spanSize;
+  size_t m_maxSpansAhead;
+  std::deque<SpanEntry> m_spans;
+  std::map<PeerId, PeerStatistics> m_peers;
+  bool m_chainRequested;
+  PeerId m_chainPeer;
+  Clock::time_point m_chainRequestTime;
+};
+
+}
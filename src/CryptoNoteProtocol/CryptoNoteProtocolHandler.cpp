@@ -28,6 +28,10 @@ namespace cn
 namespace
 {
 
+const int SYNC_SPEED_REPORT_INTERVAL = 30; // seconds
+// Spans of BLOCKS_SYNCHRONIZING_DEFAULT_COUNT blocks downloaded past the next one to import
+const size_t DOWNLOAD_SPANS_AHEAD = 16;
+
 template <class t_parametr>
 bool post_notify(IP2pEndpoint &p2p, typename t_parametr::request &arg, const CryptoNoteConnectionContext &context)
 {
@@ -50,6 +54,9 @@ CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(const Currency &currency, p
                                                                                                                                                                                   m_stop(false),
                                                                                                                                                                                   m_observedHeight(0),
                                                                                                                                                                                   m_peersCount(0),
+                                                                                                                                                                                  m_syncReportBlocks(0),
+                                                                                                                                                                                  m_downloads(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, DOWNLOAD_SPANS_AHEAD),
+                                                                                                                                                                                  m_importing(false),
                                                                                                                                                                                   logger(log, "protocol")
 {
 
@@ -78,6 +85,8 @@ void CryptoNoteProtocolHandler::onConnectionOpened(CryptoNoteConnectionContext &
 
 void CryptoNoteProtocolHandler::onConnectionClosed(CryptoNoteConnectionContext &context)
 {
+  m_downloads.removePeer(context.m_connection_id);
+
   bool updated = false;
   {
     std::lock_guard<std::mutex> lock(m_observedHeightMutex);
@@ -113,9 +122,10 @@ bool CryptoNoteProtocolHandler::start_sync(CryptoNoteConnectionContext &context)
 
   if (context.m_state == CryptoNoteConnectionContext::state_synchronizing)
   {
-    assert(context.m_needed_objects.empty());
     assert(context.m_requested_objects.empty());
 
+    // the chain is requested even if another peer is asked already, this peer may be on another fork
+    m_downloads.startChainRequest(context.m_connection_id, std::chrono::steady_clock::now());
     NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
     r.block_ids = m_core.buildSparseChain();
     logger(logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
@@ -136,14 +146,14 @@ void CryptoNoteProtocolHandler::log_connections()
 
   ss << std::setw(25) << std::left << "Remote Host"
      << std::setw(20) << "Peer id"
-     << std::setw(25) << "Recv/Sent (inactive,sec)"
+     << std::setw(25) << "Sent msgs/writes/KB"
      << std::setw(25) << "State"
      << std::setw(20) << "Lifetime(seconds)" << ENDL;
 
   m_p2p->for_each_connection([&](const CryptoNoteConnectionContext &cntxt, PeerIdType peer_id) {
     ss << std::setw(25) << std::left << std::string(cntxt.m_is_income ? "[INC]" : "[OUT]") + common::ipAddressToString(cntxt.m_remote_ip) + ":" + std::to_string(cntxt.m_remote_port)
        << std::setw(20) << std::hex << peer_id
-       // << std::setw(25) << std::to_string(cntxt.m_recv_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_recv) + ")" + "/" + std::to_string(cntxt.m_send_cnt) + "(" + std::to_string(time(NULL) - cntxt.m_last_send) + ")"
+       << std::setw(25) << std::to_string(cntxt.m_sent_messages) + "/" + std::to_string(cntxt.m_send_calls) + "/" + std::to_string(cntxt.m_sent_bytes / 1024)
        << std::setw(25) << get_protocol_state_string(cntxt.m_state)
        << std::setw(20) << std::to_string(time(NULL) - cntxt.m_started) << ENDL;
   });
@@ -402,13 +412,11 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
 
   context.m_remote_blockchain_height = arg.current_blockchain_height;
 
-  size_t count = 0;
   std::vector<crypto::Hash> block_hashes;
   block_hashes.reserve(arg.blocks.size());
   std::vector<parsed_block_entry> parsed_blocks;
   parsed_blocks.reserve(arg.blocks.size());
   for (const block_complete_entry& block_entry : arg.blocks) {
-    ++count;
     Block b;
     BinaryArray block_blob = asBinaryArray(block_entry.block);
     if (block_blob.size() > m_currency.maxBlockBlobSize()) {
@@ -423,18 +431,7 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
       return 1;
     }
 
-    //to avoid concurrency in core between connections, suspend connections which delivered block later then first one
     auto blockHash = get_block_hash(b);
-    if (count == 2) {
-      if (m_core.have_block(blockHash)) {
-        context.m_state = CryptoNoteConnectionContext::state_idle;
-        context.m_needed_objects.clear();
-        context.m_requested_objects.clear();
-        logger(DEBUGGING) << context << "Connection set to idle state.";
-        return 1;
-      }
-    }
-
     auto req_it = context.m_requested_objects.find(blockHash);
     if (req_it == context.m_requested_objects.end()) {
       logger(logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id=" << common::podToHex(blockHash)
@@ -470,52 +467,106 @@ int CryptoNoteProtocolHandler::handle_response_get_objects(int command, NOTIFY_R
     return 1;
   }
 
-  uint32_t height;
-  crypto::Hash top;
-  {
-    m_core.pause_mining();
-
-    // we lock all the rest to avoid having multiple connections redo a lot
-    // of the same work, and one of them doing it for nothing: subsequent
-    // connections will wait until the current one's added its blocks, then
-    // will add any extra it has, if any
-    std::lock_guard<std::recursive_mutex> lk(m_sync_lock);
-
-    // dismiss what another connection might already have done (likely everything)
-    m_core.get_blockchain_top(height, top);
-    uint64_t dismiss = 1;
-    for (const auto &h : block_hashes) {
-      if (top == h) {
-        logger(DEBUGGING) << "Found current top block in synced blocks, dismissing "
-          << dismiss << "/" << arg.blocks.size() << " blocks";
-        while (dismiss--) {
-          arg.blocks.erase(arg.blocks.begin());
-          parsed_blocks.erase(parsed_blocks.begin());
-        }
-        break;
-      }
-      ++dismiss;
-    }
-
-    BOOST_SCOPE_EXIT_ALL(this) { m_core.update_block_template_and_resume_mining(); };
-
-    int result = processObjects(context, parsed_blocks);
-    if (result != 0) {
-      return result;
-    }
+  uint32_t spanHeight;
+  if (!parsed_blocks.empty() && m_downloads.complete(context.m_connection_id, block_hashes.front(), parsed_blocks.size(),
+      std::chrono::steady_clock::now(), spanHeight)) {
+    DownloadedSpan& span = m_downloadedSpans[spanHeight];
+    span.peer.m_connection_id = context.m_connection_id;
+    span.peer.m_remote_ip = context.m_remote_ip;
+    span.peer.m_remote_port = context.m_remote_port;
+    span.peer.m_is_income = context.m_is_income;
+    span.peer.m_state = context.m_state;
+    span.blocks = std::move(parsed_blocks);
+  } else {
+    logger(DEBUGGING) << context << "Blocks starting with " << common::podToHex(block_hashes.front()) << " were already downloaded, dismissing them";
   }
 
+  importDownloadedBlocks();
+
+  uint32_t height;
+  crypto::Hash top;
   m_core.get_blockchain_top(height, top);
   logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new height = " << height;
 
   if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing) {
-    request_missing_objects(context, true);
+    request_missing_objects(context);
   }
 
+  requestDownloads();
   return 1;
 }
 
+// Imports downloaded spans in height order as long as the lowest one is there. Blocks are added by one
+// connection handler at a time, spans downloaded meanwhile by other connections are picked up here.
+void CryptoNoteProtocolHandler::importDownloadedBlocks() {
+  if (m_importing) {
+    return;
+  }
+
+  m_importing = true;
+  m_core.pause_mining();
+  std::lock_guard<std::recursive_mutex> lk(m_sync_lock);
+  BOOST_SCOPE_EXIT_ALL(this) {
+    m_importing = false;
+    m_core.update_block_template_and_resume_mining();
+  };
+
+  uint32_t height;
+  while (!m_stop && m_downloads.popDownloaded(height)) {
+    auto it = m_downloadedSpans.find(height);
+    if (it == m_downloadedSpans.end()) {
+      continue;
+    }
+
+    DownloadedSpan span = std::move(it->second);
+    m_downloadedSpans.erase(it);
+    if (processObjects(span.peer, span.blocks) != 0) {
+      // Spans above a bad one are useless, start over from the chain entry of another peer
+      if (span.peer.m_state == CryptoNoteConnectionContext::state_shutdown) {
+        dropConnection(span.peer.m_connection_id);
+      }
+
+      m_downloads.clear();
+      m_downloadedSpans.clear();
+      break;
+    }
+  }
+}
+
+// Gives work to synchronizing connections that wait for some, with the spans freed by others or late ones
+void CryptoNoteProtocolHandler::requestDownloads() {
+  m_p2p->for_each_connection([this](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing && context.m_requested_objects.empty()) {
+      request_missing_objects(context);
+    }
+  });
+}
+
+void CryptoNoteProtocolHandler::dropConnection(const boost::uuids::uuid& connectionId) {
+  m_p2p->for_each_connection([&connectionId](CryptoNoteConnectionContext& context, PeerIdType peerId) {
+    if (context.m_connection_id == connectionId) {
+      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    }
+  });
+}
+
 int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks) {
+  // proof of work of the whole batch is computed on worker threads while the blocks are added in order
+  std::vector<Block> queuedBlocks;
+  queuedBlocks.reserve(blocks.size());
+  for (const parsed_block_entry& block_entry : blocks) {
+    queuedBlocks.push_back(block_entry.block);
+  }
+
+  m_core.prepareBlocks(std::move(queuedBlocks));
+
+  auto batchStart = std::chrono::steady_clock::now();
+  if (m_syncReportBlocks == 0) {
+    m_syncReportTime = batchStart;
+  }
+
+  size_t addedBlocks = 0;
+  BOOST_SCOPE_EXIT_ALL(this, &addedBlocks, &batchStart) { reportSyncSpeed(addedBlocks, batchStart); };
 
   for (const parsed_block_entry& block_entry : blocks) {
     if (m_stop) {
@@ -559,13 +610,10 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
       context.m_state = CryptoNoteConnectionContext::state_shutdown;
       return 1;
     } else if (bvc.m_already_exists) {
-      logger(DEBUGGING) << context << "Block already exists, switching to idle state";
-      context.m_state = CryptoNoteConnectionContext::state_idle;
-      context.m_needed_objects.clear();
-      context.m_requested_objects.clear();
-      return 1;
+      logger(DEBUGGING) << context << "Block already exists, skipping it";
     }
 
+    ++addedBlocks;
     m_dispatcher.yield();
   }
 
@@ -573,8 +621,24 @@ int CryptoNoteProtocolHandler::processObjects(CryptoNoteConnectionContext& conte
 
 }
 
+void CryptoNoteProtocolHandler::reportSyncSpeed(size_t addedBlocks, std::chrono::steady_clock::time_point batchStart) {
+  auto now = std::chrono::steady_clock::now();
+  std::chrono::duration<double> batchTime = now - batchStart;
+  logger(DEBUGGING) << "Added " << addedBlocks << " blocks in " << batchTime.count() << " s, " <<
+    static_cast<uint64_t>(addedBlocks / std::max(batchTime.count(), 0.001)) << " blocks/s";
+
+  m_syncReportBlocks += static_cast<uint32_t>(addedBlocks);
+  std::chrono::duration<double> interval = now - m_syncReportTime;
+  if (m_syncReportBlocks != 0 && interval >= std::chrono::seconds(SYNC_SPEED_REPORT_INTERVAL)) {
+    logger(INFO, BRIGHT_WHITE) << "Synchronizing at " << static_cast<uint64_t>(m_syncReportBlocks / interval.count()) <<
+      " blocks/s, height " << get_current_blockchain_height();
+    m_syncReportBlocks = 0;
+  }
+}
+
 bool CryptoNoteProtocolHandler::on_idle()
 {
+  requestDownloads();
   return m_core.on_idle();
 }
 
@@ -604,53 +668,48 @@ int CryptoNoteProtocolHandler::handle_request_chain(int command, NOTIFY_REQUEST_
   return 1;
 }
 
-bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext &context, bool check_having_blocks)
+bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext &context)
 {
-  if (context.m_needed_objects.size())
+  if (!context.m_requested_objects.empty())
   {
-    //we know objects that we need, request this objects
-    NOTIFY_REQUEST_GET_OBJECTS::request req;
-    size_t count = 0;
-    auto it = context.m_needed_objects.begin();
+    // the blocks requested last are still on their way
+    return true;
+  }
 
-    while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)
-    {
-      if (!(check_having_blocks && m_core.have_block(*it)))
-      {
-        req.blocks.push_back(*it);
-        ++count;
-        context.m_requested_objects.insert(*it);
-      }
-      it = context.m_needed_objects.erase(it);
-    }
-    logger(logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size() << ", txs.size()=" << req.txs.size();
+  auto now = std::chrono::steady_clock::now();
+  uint32_t peerTopHeight = context.m_remote_blockchain_height == 0 ? 0 : context.m_remote_blockchain_height - 1;
+  uint32_t knownTopHeight = get_current_blockchain_height();
+  if (!m_downloads.empty())
+  {
+    knownTopHeight = std::max(knownTopHeight, m_downloads.endHeight() - 1);
+  }
+
+  BlockDownloadScheduler::Span span;
+  if (m_downloads.assign(context.m_connection_id, peerTopHeight, now, span))
+  {
+    NOTIFY_REQUEST_GET_OBJECTS::request req;
+    req.blocks = span.blockIds;
+    context.m_requested_objects.insert(span.blockIds.begin(), span.blockIds.end());
+    logger(logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: height " << span.height << ", blocks.size()=" << req.blocks.size() <<
+      ", peer throughput " << m_downloads.peerThroughput(context.m_connection_id) << " blocks/s";
     post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
   }
-  else if (context.m_last_response_height < context.m_remote_blockchain_height - 1)
+  else if (knownTopHeight < peerTopHeight)
   { //we have to fetch more objects ids, request blockchain entry
-
-    NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
-    r.block_ids = m_core.buildSparseChain();
-    logger(logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
-    post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    if (!m_downloads.hasPendingSpans() && m_downloads.startChainRequest(context.m_connection_id, now))
+    {
+      NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
+      r.block_ids = m_core.buildSparseChain();
+      logger(logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+      post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
+    }
+  }
+  else if (!m_downloads.empty())
+  {
+    // the rest is being downloaded from other peers, this one gets a span if they are late
   }
   else
   {
-    if (!(context.m_last_response_height ==
-              context.m_remote_blockchain_height - 1 &&
-          !context.m_needed_objects.size() &&
-          !context.m_requested_objects.size()))
-    {
-      logger(logging::ERROR, logging::BRIGHT_RED)
-          << "request_missing_blocks final condition failed!"
-          << "\r\nm_last_response_height=" << context.m_last_response_height
-          << "\r\nm_remote_blockchain_height=" << context.m_remote_blockchain_height
-          << "\r\nm_needed_objects.size()=" << context.m_needed_objects.size()
-          << "\r\nm_requested_objects.size()=" << context.m_requested_objects.size()
-          << "\r\non connection [" << context << "]";
-      return false;
-    }
-
     requestMissingPoolTransactions(context);
 
     context.m_state = CryptoNoteConnectionContext::state_normal;
@@ -735,13 +794,24 @@ int CryptoNoteProtocolHandler::handle_response_chain_entry(int command, NOTIFY_R
     context.m_state = CryptoNoteConnectionContext::state_shutdown;
   }
 
-  for (auto &bl_id : arg.m_block_ids)
+  m_downloads.finishChainRequest(context.m_connection_id);
+
+  size_t known = 0;
+  while (known < arg.m_block_ids.size() && m_core.have_block(arg.m_block_ids[known]))
+  {
+    ++known;
+  }
+
+  std::vector<crypto::Hash> blockIds(arg.m_block_ids.begin() + known, arg.m_block_ids.end());
+  uint32_t droppedHeight = m_downloads.addChain(arg.start_height + static_cast<uint32_t>(known), blockIds);
+  if (droppedHeight != BlockDownloadScheduler::NO_HEIGHT)
   {
-    if (!m_core.have_block(bl_id))
-      context.m_needed_objects.push_back(bl_id);
+    logger(DEBUGGING) << context << "Chain entry forks from the downloaded blocks at height " << droppedHeight;
+    m_downloadedSpans.erase(m_downloadedSpans.lower_bound(droppedHeight), m_downloadedSpans.end());
   }
 
-  request_missing_objects(context, false);
+  request_missing_objects(context);
+  requestDownloads();
   return 1;
 }
 
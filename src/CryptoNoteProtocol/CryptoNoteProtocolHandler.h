@@ -7,11 +7,15 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <map>
 
 #include <Common/ObserverManager.h>
 
 #include "CryptoNoteCore/ICore.h"
 
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
+
 #include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandlerCommon.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolObserver.h"
@@ -89,11 +93,15 @@ namespace cn
 
     //----------------------------------------------------------------------------------
     uint32_t get_current_blockchain_height();
-    bool request_missing_objects(CryptoNoteConnectionContext& context, bool check_having_blocks);
+    bool request_missing_objects(CryptoNoteConnectionContext& context);
+    void importDownloadedBlocks();
+    void requestDownloads();
+    void dropConnection(const boost::uuids::uuid& connectionId);
     bool on_connection_synchronized();
     void updateObservedHeight(uint32_t peerHeight, const CryptoNoteConnectionContext& context);
     void recalculateMaxObservedHeight(const CryptoNoteConnectionContext& context);
     int processObjects(CryptoNoteConnectionContext& context, const std::vector<parsed_block_entry>& blocks);
+    void reportSyncSpeed(size_t addedBlocks, std::chrono::steady_clock::time_point batchStart);
     logging::LoggerRef logger;
 
   private:
@@ -111,6 +119,19 @@ namespace cn
     uint32_t m_observedHeight;
 
     std::atomic<size_t> m_peersCount;
+
+    // blocks added since m_syncReportTime, reported as sync speed every SYNC_SPEED_REPORT_INTERVAL seconds
+    std::chrono::steady_clock::time_point m_syncReportTime;
+    uint32_t m_syncReportBlocks;
+
+    struct DownloadedSpan {
+      CryptoNoteConnectionContext peer; // identity of the connection that delivered the blocks
+      std::vector<parsed_block_entry> blocks;
+    };
+
+    BlockDownloadScheduler m_downloads;
+    std::map<uint32_t, DownloadedSpan> m_downloadedSpans; // by height, waiting for the spans below them
+    bool m_importing;
     tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
   };
 }
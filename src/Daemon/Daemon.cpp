@@ -283,7 +283,7 @@ int main(int argc, char* argv[])
 
     cprotocol.set_p2p_endpoint(&p2psrv);
     ccore.set_cryptonote_protocol(&cprotocol);
-    DaemonCommandsHandler dch(ccore, p2psrv, logManager);
+    DaemonCommandsHandler dch(ccore, p2psrv, rpcServer, logManager);
 
     // initialize objects
     logger(INFO, YELLOW) << "- Daemon.cpp - " "Initializing p2p server...";
@@ -335,6 +335,7 @@ int main(int argc, char* argv[])
       }
     }
  
+    rpcServer.setWorkerThreads(rpcConfig.workerThreads);
     rpcServer.start(rpcConfig.bindIp, rpcConfig.bindPort);
     rpcServer.enableCors(command_line::get_arg(vm, arg_enable_cors));
     logger(INFO, GREEN) << "- Daemon.cpp - " "Core rpc server started ok";
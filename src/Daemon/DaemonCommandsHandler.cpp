@@ -12,6 +12,7 @@
 #include "CryptoNoteCore/Core.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
+#include "Rpc/RpcServer.h"
 #include "Serialization/SerializationTools.h"
 #include "version.h"
 
@@ -24,8 +25,8 @@ namespace {
 }
 
 
-DaemonCommandsHandler::DaemonCommandsHandler(cn::core& core, cn::NodeServer& srv, logging::LoggerManager& log) :
-  m_core(core), m_srv(srv), logger(log, "daemon"), m_logManager(log) {
+DaemonCommandsHandler::DaemonCommandsHandler(cn::core& core, cn::NodeServer& srv, cn::RpcServer& rpc, logging::LoggerManager& log) :
+  m_core(core), m_srv(srv), m_rpc(rpc), logger(log, "daemon"), m_logManager(log) {
   m_consoleHandler.setHandler("exit", boost::bind(&DaemonCommandsHandler::exit, this, _1), "Shutdown the daemon");
   m_consoleHandler.setHandler("help", boost::bind(&DaemonCommandsHandler::help, this, _1), "Show this help");
   m_consoleHandler.setHandler("save", boost::bind(&DaemonCommandsHandler::save, this, _1), "Save the Blockchain data safely");
@@ -35,6 +36,9 @@ DaemonCommandsHandler::DaemonCommandsHandler(cn::core& core, cn::NodeServer& srv
   m_consoleHandler.setHandler("print_bc", boost::bind(&DaemonCommandsHandler::print_bc, this, _1), "Print blockchain info in a given blocks range, print_bc <begin_height> [<end_height>]");
   m_consoleHandler.setHandler("print_block", boost::bind(&DaemonCommandsHandler::print_block, this, _1), "Print block, print_block <block_hash> | <block_height>");
   m_consoleHandler.setHandler("print_stat", boost::bind(&DaemonCommandsHandler::print_stat, this, _1), "Print statistics, print_stat <nothing=last> | <block_hash> | <block_height>");
+  m_consoleHandler.setHandler("print_rpc_stats", boost::bind(&DaemonCommandsHandler::print_rpc_stats, this, _1), "Print RPC request latencies per endpoint");
+  m_consoleHandler.setHandler("print_sig_cache", boost::bind(&DaemonCommandsHandler::print_sig_cache, this, _1), "Print ring signature cache hits and misses");
+  m_consoleHandler.setHandler("print_template_stats", boost::bind(&DaemonCommandsHandler::print_template_stats, this, _1), "Print block template assembly latency");
   m_consoleHandler.setHandler("print_tx", boost::bind(&DaemonCommandsHandler::print_tx, this, _1), "Print transaction, print_tx <transaction_hash>");
   m_consoleHandler.setHandler("start_mining", boost::bind(&DaemonCommandsHandler::start_mining, this, _1), "Start mining for specified address, start_mining <addr> [threads=1]");
   m_consoleHandler.setHandler("stop_mining", boost::bind(&DaemonCommandsHandler::stop_mining, this, _1), "Stop mining");
@@ -134,6 +138,24 @@ bool DaemonCommandsHandler::print_cn(const std::vector<std::string>& args)
   return true;
 }
 //--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_rpc_stats(const std::vector<std::string>& args)
+{
+  std::cout << m_rpc.getLatencyStatistics() << ENDL;
+  return true;
+}
+//--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_sig_cache(const std::vector<std::string>& args)
+{
+  std::cout << m_core.print_signature_cache() << ENDL;
+  return true;
+}
+//--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_template_stats(const std::vector<std::string>& args)
+{
+  std::cout << "get_block_template: " << m_core.print_block_template_latency() << ENDL;
+  return true;
+}
+//--------------------------------------------------------------------------------
 bool DaemonCommandsHandler::print_bc(const std::vector<std::string> &args) {
   if (!args.size()) {
     std::cout << "need block index parameter" << ENDL;
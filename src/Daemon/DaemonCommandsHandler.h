@@ -21,12 +21,13 @@ namespace cn {
 class core;
 class Currency;
 class NodeServer;
+class RpcServer;
 }
 
 class DaemonCommandsHandler
 {
 public:
-  DaemonCommandsHandler(cn::core& core, cn::NodeServer& srv, logging::LoggerManager& log);
+  DaemonCommandsHandler(cn::core& core, cn::NodeServer& srv, cn::RpcServer& rpc, logging::LoggerManager& log);
 
   bool start_handling() {
     m_consoleHandler.start();
@@ -42,6 +43,7 @@ private:
   common::ConsoleHandler m_consoleHandler;
   cn::core& m_core;
   cn::NodeServer& m_srv;
+  cn::RpcServer& m_rpc;
   logging::LoggerRef logger;
   logging::LoggerManager& m_logManager;
 
@@ -68,6 +70,9 @@ private:
   bool print_pool(const std::vector<std::string>& args);
   bool print_pool_sh(const std::vector<std::string>& args);
   bool print_stat(const std::vector<std::string>& args);
+  bool print_rpc_stats(const std::vector<std::string>& args);
+  bool print_sig_cache(const std::vector<std::string>& args);
+  bool print_template_stats(const std::vector<std::string>& args);
 
   bool start_mining(const std::vector<std::string>& args);
   bool stop_mining(const std::vector<std::string>& args);
@@ -11,6 +11,7 @@
 
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/MiningJob.h"
 
 #include <System/InterruptedException.h>
 
@@ -90,15 +91,17 @@ void miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, u
   try {
     Block block = blockTemplate;
     crypto::cn_context cryptoContext;
+    MiningJob job;
+    if (!job.init(block)) {
+      //error occured
+      m_logger(logging::DEBUGGING) << "calculating long hash error occured";
+      m_state = MiningState::MINING_STOPPED;
+      return;
+    }
 
     while (m_state == MiningState::MINING_IN_PROGRESS) {
       crypto::Hash hash;
-      if (!get_block_longhash(cryptoContext, block, hash)) {
-        //error occured
-        m_logger(logging::DEBUGGING) << "calculating long hash error occured";
-        m_state = MiningState::MINING_STOPPED;
-        return;
-      }
+      job.getLongHash(cryptoContext, hash);
 
       if (check_hash(hash, difficulty)) {
         m_logger(logging::INFO) << "Found block for difficulty " << difficulty;
@@ -108,11 +111,12 @@ void miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, u
           return;
         }
 
+        block.nonce = job.getNonce();
         m_block = block;
         return;
       }
 
-      block.nonce += nonceStep;
+      job.setNonce(job.getNonce() + nonceStep);
     }
   } catch (std::exception& e) {
     m_logger(logging::ERROR) << "Miner got error: " << e.what();
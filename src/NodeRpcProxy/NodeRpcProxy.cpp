@@ -72,6 +72,7 @@ void NodeRpcProxy::resetInternalState() {
   m_networkHeight.store(0, std::memory_order_relaxed);
   m_lastKnowHash = cn::NULL_HASH;
   m_knownTxs.clear();
+  m_batchedOutsGlobalIndicesMissing = false;
 }
 
 void NodeRpcProxy::init(const INode::Callback& callback) {
@@ -349,6 +350,18 @@ void NodeRpcProxy::getTransactionOutsGlobalIndices(const crypto::Hash& transacti
     std::ref(outsGlobalIndices)), callback);
 }
 
+void NodeRpcProxy::getTransactionsOutsGlobalIndices(const std::vector<crypto::Hash>& transactionHashes,
+                                                    std::vector<std::vector<uint32_t>>& outsGlobalIndices, const Callback& callback) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_state != STATE_INITIALIZED) {
+    callback(make_error_code(error::NOT_INITIALIZED));
+    return;
+  }
+
+  scheduleRequest(std::bind(&NodeRpcProxy::doGetTransactionsOutsGlobalIndices, this, transactionHashes,
+    std::ref(outsGlobalIndices)), callback);
+}
+
 void NodeRpcProxy::queryBlocks(std::vector<crypto::Hash>&& knownBlockIds, uint64_t timestamp, std::vector<BlockShortEntry>& newBlocks,
   uint32_t& startHeight, const Callback& callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
@@ -535,6 +548,67 @@ std::error_code NodeRpcProxy::doGetTransactionOutsGlobalIndices(const crypto::Ha
   return ec;
 }
 
+std::error_code NodeRpcProxy::doGetTransactionsOutsGlobalIndices(const std::vector<crypto::Hash>& transactionHashes,
+                                                                 std::vector<std::vector<uint32_t>>& outsGlobalIndices) {
+  cn::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request req = AUTO_VAL_INIT(req);
+  cn::COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response rsp = AUTO_VAL_INIT(rsp);
+  req.txids = transactionHashes;
+
+  outsGlobalIndices.clear();
+  std::error_code ec;
+  if (!m_batchedOutsGlobalIndicesMissing) {
+    // the status is checked here, only a daemon without the batched request answers 404
+    ec = make_error_code(error::NETWORK_ERROR);
+    try {
+      EventLock eventLock(*m_httpEvent);
+
+      HttpRequest httpReq;
+      HttpResponse httpRes;
+
+      httpReq.setUrl("/get_txs_o_indexes.bin");
+      httpReq.setBody(storeToBinaryKeyValue(req));
+
+      m_httpClient->request(httpReq, httpRes);
+
+      if (httpRes.getStatus() == HttpResponse::STATUS_404) {
+        m_batchedOutsGlobalIndicesMissing = true;
+      } else if (httpRes.getStatus() == HttpResponse::STATUS_200 && loadFromBinaryKeyValue(rsp, httpRes.getBody())) {
+        ec = interpretResponseStatus(rsp.status);
+      }
+    } catch (const ConnectException&) {
+      ec = make_error_code(error::CONNECT_ERROR);
+    } catch (const std::exception&) {
+      ec = make_error_code(error::NETWORK_ERROR);
+    }
+  }
+
+  if (m_batchedOutsGlobalIndicesMissing) {
+    // ask for one transaction at a time
+    outsGlobalIndices.resize(transactionHashes.size());
+    for (size_t i = 0; i < transactionHashes.size(); ++i) {
+      ec = doGetTransactionOutsGlobalIndices(transactionHashes[i], outsGlobalIndices[i]);
+      if (ec) {
+        break;
+      }
+    }
+
+    return ec;
+  }
+
+  if (!ec && rsp.transactions.size() != transactionHashes.size()) {
+    ec = make_error_code(error::INTERNAL_NODE_ERROR);
+  }
+
+  if (!ec) {
+    outsGlobalIndices.reserve(rsp.transactions.size());
+    for (const auto& transaction : rsp.transactions) {
+      outsGlobalIndices.emplace_back(transaction.o_indexes.begin(), transaction.o_indexes.end());
+    }
+  }
+
+  return ec;
+}
+
 std::error_code NodeRpcProxy::doQueryBlocksLite(const std::vector<crypto::Hash>& knownBlockIds, uint64_t timestamp,
         std::vector<cn::BlockShortEntry>& newBlocks, uint32_t& startHeight) {
   cn::COMMAND_RPC_QUERY_BLOCKS_LITE::request req = AUTO_VAL_INIT(req);
@@ -6,7 +6,6 @@
 
 #pragma once
 
-#include <list>
 #include <ostream>
 #include <unordered_set>
 
@@ -35,10 +34,12 @@ struct CryptoNoteConnectionContext {
   };
 
   state m_state = state_befor_handshake;
-  std::list<crypto::Hash> m_needed_objects;
   std::unordered_set<crypto::Hash> m_requested_objects;
   uint32_t m_remote_blockchain_height = 0;
   uint32_t m_last_response_height = 0;
+  uint64_t m_sent_messages = 0;
+  uint64_t m_sent_bytes = 0;
+  uint64_t m_send_calls = 0;
 };
 
 inline std::string get_protocol_state_string(CryptoNoteConnectionContext::state s) {
@@ -41,6 +41,12 @@ LevinProtocol::LevinProtocol(platform_system::TcpConnection& connection)
   : m_conn(connection) {}
 
 void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool needResponse) {
+  // write header and body in one operation
+  queueMessage(command, out, needResponse);
+  flush();
+}
+
+size_t LevinProtocol::queueMessage(uint32_t command, const BinaryArray& out, bool needResponse) {
   bucket_head2 head = { 0 };
   head.m_signature = LEVIN_SIGNATURE;
   head.m_cb = out.size();
@@ -49,15 +55,7 @@ void LevinProtocol::sendMessage(uint32_t command, const BinaryArray& out, bool n
   head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
   head.m_flags = LEVIN_PACKET_REQUEST;
 
-  // write header and body in one operation
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
-
-  common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
-
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+  return queue(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out);
 }
 
 bool LevinProtocol::readCommand(Command& cmd) {
@@ -93,6 +91,11 @@ bool LevinProtocol::readCommand(Command& cmd) {
 }
 
 void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t returnCode) {
+  queueReply(command, out, returnCode);
+  flush();
+}
+
+size_t LevinProtocol::queueReply(uint32_t command, const BinaryArray& out, int32_t returnCode) {
   bucket_head2 head = { 0 };
   head.m_signature = LEVIN_SIGNATURE;
   head.m_cb = out.size();
@@ -102,21 +105,44 @@ void LevinProtocol::sendReply(uint32_t command, const BinaryArray& out, int32_t
   head.m_flags = LEVIN_PACKET_RESPONSE;
   head.m_return_code = returnCode;
 
-  BinaryArray writeBuffer;
-  writeBuffer.reserve(sizeof(head) + out.size());
+  return queue(reinterpret_cast<const uint8_t*>(&head), sizeof(head), out);
+}
+
+size_t LevinProtocol::flush() {
+  // bodies are sent straight from the message buffers, they may be shared by many connections
+  std::vector<platform_system::TcpConnection::ConstBuffer> buffers;
+  buffers.reserve(2 * m_queuedBodies.size());
+  for (size_t i = 0; i < m_queuedBodies.size(); ++i) {
+    buffers.push_back({ m_queuedHeads.data() + i * sizeof(bucket_head2), sizeof(bucket_head2) });
+    buffers.push_back({ m_queuedBodies[i]->data(), m_queuedBodies[i]->size() });
+  }
 
-  common::VectorOutputStream stream(writeBuffer);
-  stream.writeSome(&head, sizeof(head));
-  stream.writeSome(out.data(), out.size());
+  m_queuedHeads.clear();
+  m_queuedBodies.clear();
+
+  size_t writes = 0;
+  size_t first = 0;
+  while (first < buffers.size()) {
+    size_t written = m_conn.writeGathered(buffers.data() + first, buffers.size() - first);
+    ++writes;
+    while (first < buffers.size() && written >= buffers[first].size) {
+      written -= buffers[first].size;
+      ++first;
+    }
 
-  writeStrict(writeBuffer.data(), writeBuffer.size());
+    if (first < buffers.size()) {
+      buffers[first].data += written;
+      buffers[first].size -= written;
+    }
+  }
+
+  return writes;
 }
 
-void LevinProtocol::writeStrict(const uint8_t* ptr, size_t size) {
-  size_t offset = 0;
-  while (offset < size) {
-    offset += m_conn.write(ptr + offset, size - offset);
-  }
+size_t LevinProtocol::queue(const uint8_t* head, size_t headSize, const BinaryArray& body) {
+  m_queuedHeads.insert(m_queuedHeads.end(), head, head + headSize);
+  m_queuedBodies.push_back(&body);
+  return headSize + body.size();
 }
 
 bool LevinProtocol::readStrict(uint8_t* ptr, size_t size) {
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "CryptoNote.h"
 #include <Common/MemoryInputStream.h>
 #include <Common/VectorOutputStream.h>
@@ -69,6 +71,13 @@ public:
   void sendMessage(uint32_t command, const BinaryArray& out, bool needResponse);
   void sendReply(uint32_t command, const BinaryArray& out, int32_t returnCode);
 
+  // Frame a message for the next flush and return its size on the wire. The body isn't copied,
+  // it has to stay alive until the flush.
+  size_t queueMessage(uint32_t command, const BinaryArray& out, bool needResponse);
+  size_t queueReply(uint32_t command, const BinaryArray& out, int32_t returnCode);
+  // Sends all queued messages with as few gathered writes as possible, returns the number of writes
+  size_t flush();
+
   template <typename T>
   static bool decode(const BinaryArray& buf, T& value) {
     try {
@@ -95,8 +104,10 @@ public:
 private:
 
   bool readStrict(uint8_t* ptr, size_t size);
-  void writeStrict(const uint8_t* ptr, size_t size);
+  size_t queue(const uint8_t* head, size_t headSize, const BinaryArray& body);
   platform_system::TcpConnection& m_conn;
+  std::vector<uint8_t> m_queuedHeads;
+  std::vector<const BinaryArray*> m_queuedBodies;
 };
 
 }
@@ -14,7 +14,7 @@ namespace cn {
   struct CryptoNoteConnectionContext;
 
   struct IP2pEndpoint {
-    virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) = 0;
+    virtual void relay_notify_to_all(int command, BinaryArray data_buff, const net_connection_id* excludeConnection) = 0;
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const cn::CryptoNoteConnectionContext& context) = 0;
     virtual uint64_t get_connections_count()=0;
     virtual void for_each_connection(std::function<void(cn::CryptoNoteConnectionContext&, PeerIdType)> f) = 0;
@@ -23,7 +23,7 @@ namespace cn {
   };
 
   struct p2p_endpoint_stub: public IP2pEndpoint {
-    virtual void relay_notify_to_all(int command, const BinaryArray& data_buff, const net_connection_id* excludeConnection) override {}
+    virtual void relay_notify_to_all(int command, BinaryArray data_buff, const net_connection_id* excludeConnection) override {}
     virtual bool invoke_notify_to_peer(int command, const BinaryArray& req_buff, const cn::CryptoNoteConnectionContext& context) override { return true; }
     virtual void for_each_connection(std::function<void(cn::CryptoNoteConnectionContext&, PeerIdType)> f) override {}
     virtual uint64_t get_connections_count() override { return 0; }   
@@ -21,13 +21,16 @@
 
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/mman.h>
 #include <sys/timerfd.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <string.h>
-#include <ucontext.h>
 #include <unistd.h>
+#include <algorithm>
 #include <stdexcept>
 #include "ErrorMessage.h"
+#include "MachineContext.h"
 
 namespace platform_system {
 
@@ -35,7 +38,7 @@ namespace {
 
 struct ContextMakingData {
   Dispatcher* dispatcher;
-  void* ucontext;
+  MachineContext* machineContext;
 };
 
 class MutextGuard {
@@ -59,6 +62,24 @@ static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "in
 
 //const size_t STACK_SIZE = 64 * 1024;
 const size_t STACK_SIZE = 64 * 1024;
+// Stacks are mapped this many at a time, each one above an inaccessible page that turns an overflow into a fault
+const size_t STACKS_PER_ARENA = 16;
+// Ready events taken from the kernel by one epoll_wait
+const int MAX_EPOLL_EVENTS = 128;
+// The timer wheel counts whole milliseconds, each level has 2^TIMER_WHEEL_BITS slots
+const uint64_t NANOSECONDS_PER_TICK = 1000000;
+const size_t TIMER_WHEEL_BITS = 6;
+// Longer sleeps are capped at about seventy years
+const uint64_t MAX_TIMER_DELAY = UINT64_C(1) << 61;
+
+uint64_t monotonicNanoseconds() {
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+    throw std::runtime_error("clock_gettime failed, " + lastErrorMessage());
+  }
+
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
 
 };
 
@@ -68,48 +89,70 @@ Dispatcher::Dispatcher() {
   if (epoll == -1) {
     message = "epoll_create1 failed, " + lastErrorMessage();
   } else {
-    mainContext.ucontext = new ucontext_t;
-    if (getcontext(reinterpret_cast<ucontext_t*>(mainContext.ucontext)) == -1) {
-      message = "getcontext failed, " + lastErrorMessage();
+    mainContext.machineContext = new MachineContext;
+    remoteSpawnEvent = eventfd(0, O_NONBLOCK);
+    if(remoteSpawnEvent == -1) {
+      message = "eventfd failed, " + lastErrorMessage();
     } else {
-      remoteSpawnEvent = eventfd(0, O_NONBLOCK);
-      if(remoteSpawnEvent == -1) {
-        message = "eventfd failed, " + lastErrorMessage();
-      } else {
-        remoteSpawnEventContext.writeContext = nullptr;
-        remoteSpawnEventContext.readContext = nullptr;
+      remoteSpawnEventContext.writeContext = nullptr;
+      remoteSpawnEventContext.readContext = nullptr;
 
-        epoll_event remoteSpawnEventEpollEvent;
-        remoteSpawnEventEpollEvent.events = EPOLLIN;
-        remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
+      epoll_event remoteSpawnEventEpollEvent;
+      remoteSpawnEventEpollEvent.events = EPOLLIN;
+      remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
 
-        if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
-          message = "epoll_ctl failed, " + lastErrorMessage();
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
+        message = "epoll_ctl failed, " + lastErrorMessage();
+      } else {
+        timerEvent = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (timerEvent == -1) {
+          message = "timerfd_create failed, " + lastErrorMessage();
         } else {
-          *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
-
-          mainContext.interrupted = false;
-          mainContext.group = &contextGroup;
-          mainContext.groupPrev = nullptr;
-          mainContext.groupNext = nullptr;
-          mainContext.inExecutionQueue = false;
-          contextGroup.firstContext = nullptr;
-          contextGroup.lastContext = nullptr;
-          contextGroup.firstWaiter = nullptr;
-          contextGroup.lastWaiter = nullptr;
-          currentContext = &mainContext;
-          firstResumingContext = nullptr;
-          firstReusableContext = nullptr;
-          runningContextCount = 0;
-          return;
-        }
+          timerEventContext.writeContext = nullptr;
+          timerEventContext.readContext = nullptr;
+
+          epoll_event timerEpollEvent;
+          timerEpollEvent.events = EPOLLIN;
+          timerEpollEvent.data.ptr = &timerEventContext;
+
+          if (epoll_ctl(epoll, EPOLL_CTL_ADD, timerEvent, &timerEpollEvent) == -1) {
+            message = "epoll_ctl failed, " + lastErrorMessage();
+          } else {
+            *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
+
+            mainContext.interrupted = false;
+            mainContext.group = &contextGroup;
+            mainContext.groupPrev = nullptr;
+            mainContext.groupNext = nullptr;
+            mainContext.inExecutionQueue = false;
+            contextGroup.firstContext = nullptr;
+            contextGroup.lastContext = nullptr;
+            contextGroup.firstWaiter = nullptr;
+            contextGroup.lastWaiter = nullptr;
+            currentContext = &mainContext;
+            firstResumingContext = nullptr;
+            firstReusableContext = nullptr;
+            runningContextCount = 0;
+            memset(timerSlots, 0, sizeof timerSlots);
+            memset(timerSlotMasks, 0, sizeof timerSlotMasks);
+            timerWheelTime = 0;
+            timerArmedTime = UINT64_MAX;
+            timerCount = 0;
+            return;
+          }
 
-        auto result = close(remoteSpawnEvent);
-        assert(result == 0);
-        std::ignore = result;
+          auto result = close(timerEvent);
+          assert(result == 0);
+          std::ignore = result;
+        }
       }
+
+      auto result = close(remoteSpawnEvent);
+      assert(result == 0);
+      std::ignore = result;
     }
 
+    delete mainContext.machineContext;
     auto result = close(epoll);
     assert(result == 0);
     std::ignore = result;
@@ -128,23 +171,15 @@ Dispatcher::~Dispatcher() {
   assert(contextGroup.firstWaiter == nullptr);
   assert(firstResumingContext == nullptr);
   assert(runningContextCount == 0);
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    assert(result == 0);
-    std::ignore = result;
-    timers.pop();
-  }
+  deleteReusableContexts();
+  releaseStackArenas();
+  delete mainContext.machineContext;
 
+  assert(timerCount == 0);
   auto result = close(epoll);
   assert(result == 0);
+  result = close(timerEvent);
+  assert(result == 0);
   result = close(remoteSpawnEvent);
   assert(result == 0);
   result = pthread_mutex_destroy(reinterpret_cast<pthread_mutex_t*>(this->mutex));
@@ -153,21 +188,9 @@ Dispatcher::~Dispatcher() {
 }
 
 void Dispatcher::clear() {
-  while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
-    firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    if (result == -1) {
-      throw std::runtime_error("Dispatcher::clear, close failed, "  + lastErrorMessage());
-    }
-
-    timers.pop();
+  deleteReusableContexts();
+  if (freeStacks.size() == stackArenas.size() * STACKS_PER_ARENA) {
+    releaseStackArenas();
   }
 }
 
@@ -182,52 +205,20 @@ void Dispatcher::dispatch() {
       break;
     }
 
-    epoll_event event;
-    int count = epoll_wait(epoll, &event, 1, -1);
-    if (count == 1) {
-      ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
-      if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-        uint64_t buf;
-        auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-        if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-        }
-
-        MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-        while (!remoteSpawningProcedures.empty()) {
-          spawn(std::move(remoteSpawningProcedures.front()));
-          remoteSpawningProcedures.pop();
-        }
-
-        continue;
-      }
-
-      if ((event.events & EPOLLOUT) != 0) {
-        context = contextPair->writeContext->context;
-        contextPair->writeContext->events = event.events;
-      } else if ((event.events & EPOLLIN) != 0) {
-        context = contextPair->readContext->context;
-        contextPair->readContext->events = event.events;
-      } else {
-        continue;
+    epoll_event events[MAX_EPOLL_EVENTS];
+    int count = epoll_wait(epoll, events, MAX_EPOLL_EVENTS, -1);
+    if (count == -1) {
+      if (errno != EINTR) {
+        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
       }
 
-      assert(context != nullptr);
-      break;
+      continue;
     }
 
-    if (errno != EINTR) {
-      throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
-    }
+    resumeEventContexts(events, count);
   }
 
-  if (context != currentContext) {
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    currentContext = context;
-    if (swapcontext(oldContext, static_cast<ucontext_t *>(context->ucontext)) == -1) {
-      throw std::runtime_error("Dispatcher::dispatch, swapcontext failed, " + lastErrorMessage());
-    }
-  }
+  switchTo(context);
 }
 
 NativeContext* Dispatcher::getCurrentContext() const {
@@ -311,60 +302,20 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 
 void Dispatcher::yield() {
   for(;;){
-    epoll_event events[16];
-    int count = epoll_wait(epoll, events, 16, 0);
+    epoll_event events[MAX_EPOLL_EVENTS];
+    int count = epoll_wait(epoll, events, MAX_EPOLL_EVENTS, 0);
     if (count == 0) {
       break;
     }
 
     if(count > 0) {
-      for(int i = 0; i < count; ++i) {
-        ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
-        if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-          uint64_t buf;
-          auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-          if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-          }
-
-          MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-          while (!remoteSpawningProcedures.empty()) {
-            spawn(std::move(remoteSpawningProcedures.front()));
-            remoteSpawningProcedures.pop();
-          }
-
-          continue;
-        }
-
-        if ((events[i].events & EPOLLOUT) != 0) {
-          if (contextPair->writeContext != nullptr) {
-            if (contextPair->writeContext->context != nullptr) {
-              contextPair->writeContext->context->interruptProcedure = nullptr;
-            }
-            pushContext(contextPair->writeContext->context);
-            contextPair->writeContext->events = events[i].events;
-          }
-          pushContext(contextPair->writeContext->context);
-          contextPair->writeContext->events = events[i].events;
-        } else if ((events[i].events & EPOLLIN) != 0) {
-          if (contextPair->readContext != nullptr) {
-            if (contextPair->readContext->context != nullptr) {
-              contextPair->readContext->context->interruptProcedure = nullptr;
-            }
-            pushContext(contextPair->readContext->context);
-            contextPair->readContext->events = events[i].events;
-          }
-          pushContext(contextPair->readContext->context);
-          contextPair->readContext->events = events[i].events;
-        } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
-          throw std::runtime_error("Dispatcher::dispatch, events & (EPOLLERR | EPOLLHUP) != 0");
-        } else {
-          continue;
-        }
+      resumeEventContexts(events, count);
+      if (count < MAX_EPOLL_EVENTS) {
+        break;
       }
     } else {
       if (errno != EINTR) {
-        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, " + lastErrorMessage());
+        throw std::runtime_error("Dispatcher::yield, epoll_wait failed, " + lastErrorMessage());
       }
     }
   }
@@ -381,25 +332,21 @@ int Dispatcher::getEpoll() const {
 
 NativeContext& Dispatcher::getReusableContext() {
   if(firstReusableContext == nullptr) {
-    ucontext_t* newlyCreatedContext = new ucontext_t;
-    if (getcontext(newlyCreatedContext) == -1) { //makecontext precondition
-      throw std::runtime_error("Dispatcher::getReusableContext, getcontext failed, " + lastErrorMessage());
+    MachineContext* newlyCreatedContext = new MachineContext;
+    uint8_t* stackPointer;
+    try {
+      stackPointer = allocateStack();
+    } catch (...) {
+      delete newlyCreatedContext;
+      throw;
     }
 
-    auto stackPointer = new uint8_t[STACK_SIZE];
-    newlyCreatedContext->uc_stack.ss_sp = stackPointer;
-    newlyCreatedContext->uc_stack.ss_size = STACK_SIZE;
-
     ContextMakingData makingContextData {this, newlyCreatedContext};
-    makecontext(newlyCreatedContext, (void(*)())contextProcedureStatic, 1, reinterpret_cast<int*>(&makingContextData));
-
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
-      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
-    }
+    makeMachineContext(*newlyCreatedContext, stackPointer, STACK_SIZE, contextProcedureStatic, &makingContextData);
+    switchMachineContext(*currentContext->machineContext, *newlyCreatedContext);
 
     assert(firstReusableContext != nullptr);
-    assert(firstReusableContext->ucontext == newlyCreatedContext);
+    assert(firstReusableContext->machineContext == newlyCreatedContext);
     firstReusableContext->stackPtr = stackPointer;
   };
 
@@ -414,41 +361,38 @@ void Dispatcher::pushReusableContext(NativeContext& context) {
   --runningContextCount;
 }
 
-int Dispatcher::getTimer() {
-  int timer;
-  if (timers.empty()) {
-    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    epoll_event timerEvent;
-    timerEvent.events = EPOLLONESHOT;
-    timerEvent.data.ptr = nullptr;
-
-    if (epoll_ctl(getEpoll(), EPOLL_CTL_ADD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Dispatcher::getTimer, epoll_ctl failed, "  + lastErrorMessage());
-    }
-  } else {
-    timer = timers.top();
-    timers.pop();
+void Dispatcher::addTimer(TimerContext& timer, std::chrono::nanoseconds duration) {
+  uint64_t now = monotonicNanoseconds();
+  uint64_t delay = static_cast<uint64_t>(std::max(duration.count(), static_cast<std::chrono::nanoseconds::rep>(0)));
+  // rounded up, so a timer never fires before the whole duration has passed
+  timer.deadline = (now + std::min(delay, MAX_TIMER_DELAY) + NANOSECONDS_PER_TICK - 1) / NANOSECONDS_PER_TICK;
+  if (timerCount == 0) {
+    timerWheelTime = now / NANOSECONDS_PER_TICK;
   }
 
-  return timer;
+  insertTimer(timer);
+  timer.pending = true;
+  ++timerCount;
+  armTimerEvent();
 }
 
-void Dispatcher::pushTimer(int timer) {
-  timers.push(timer);
+void Dispatcher::removeTimer(TimerContext& timer) {
+  assert(timer.pending);
+  unlinkTimer(timer);
+  timer.pending = false;
+  --timerCount;
+  // the timerfd may stay armed for this timer, an expiry with nothing due is ignored
 }
 
-void Dispatcher::contextProcedure(void* ucontext) {
+void Dispatcher::contextProcedure(MachineContext* machineContext) {
   assert(firstReusableContext == nullptr);
   NativeContext context;
-  context.ucontext = ucontext;
+  context.machineContext = machineContext;
   context.interrupted = false;
   context.next = nullptr;
   context.inExecutionQueue = false;
   firstReusableContext = &context;
-  ucontext_t* oldContext = static_cast<ucontext_t*>(context.ucontext);
-  if (swapcontext(oldContext, static_cast<ucontext_t*>(currentContext->ucontext)) == -1) {
-    throw std::runtime_error("Dispatcher::contextProcedure, swapcontext failed, " + lastErrorMessage());
-  }
+  switchMachineContext(*context.machineContext, *currentContext->machineContext);
 
   for (;;) {
     ++runningContextCount;
@@ -499,7 +443,262 @@ void Dispatcher::contextProcedure(void* ucontext) {
 
 void Dispatcher::contextProcedureStatic(void *context) {
   ContextMakingData* makingContextData = reinterpret_cast<ContextMakingData*>(context);
-  makingContextData->dispatcher->contextProcedure(makingContextData->ucontext);
+  makingContextData->dispatcher->contextProcedure(makingContextData->machineContext);
+}
+
+void Dispatcher::resumeEventContexts(const epoll_event* events, int count) {
+  for (int i = 0; i < count; ++i) {
+    ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+    if (contextPair == &remoteSpawnEventContext) {
+      uint64_t buf;
+      auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
+      if(transferred == -1) {
+        throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
+      }
+
+      MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
+      while (!remoteSpawningProcedures.empty()) {
+        spawn(std::move(remoteSpawningProcedures.front()));
+        remoteSpawningProcedures.pop();
+      }
+
+      continue;
+    }
+
+    if (contextPair == &timerEventContext) {
+      uint64_t expirations;
+      if (read(timerEvent, &expirations, sizeof expirations) == -1 && errno != EAGAIN) {
+        throw std::runtime_error("Dispatcher::dispatch, read(timerEvent) failed, " + lastErrorMessage());
+      }
+
+      timerArmedTime = UINT64_MAX;
+      expireTimers();
+      armTimerEvent();
+      continue;
+    }
+
+    if (contextPair == nullptr) {
+      continue;
+    }
+
+    OperationContext* operation = nullptr;
+    if ((events[i].events & EPOLLOUT) != 0 && contextPair->writeContext != nullptr) {
+      operation = contextPair->writeContext;
+    } else if ((events[i].events & EPOLLIN) != 0 && contextPair->readContext != nullptr) {
+      operation = contextPair->readContext;
+    } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
+      // the waiting operation sees the error in its events
+      operation = contextPair->readContext != nullptr ? contextPair->readContext : contextPair->writeContext;
+    }
+
+    if (operation == nullptr || operation->context == nullptr) {
+      continue;
+    }
+
+    // the operation completed, an interrupt arriving before the context runs is left to its next operation
+    operation->events = events[i].events;
+    operation->context->interruptProcedure = nullptr;
+    pushContext(operation->context);
+  }
+}
+
+void Dispatcher::insertTimer(TimerContext& timer) {
+  static_assert(UINT64_C(1) << TIMER_WHEEL_BITS == TIMER_WHEEL_SLOTS, "timer wheel slots must match TIMER_WHEEL_BITS");
+  const uint64_t range = UINT64_C(1) << TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS;
+  uint64_t expires = std::max(timer.deadline, timerWheelTime);
+  uint64_t delta = expires - timerWheelTime;
+  size_t level = 0;
+  while (level + 1 < TIMER_WHEEL_LEVELS && delta >= UINT64_C(1) << TIMER_WHEEL_BITS * (level + 1)) {
+    ++level;
+  }
+
+  if (delta >= range) {
+    // parked in the farthest slot and reinserted when it comes due
+    expires = timerWheelTime + range - 1;
+  }
+
+  size_t slot = (expires >> TIMER_WHEEL_BITS * level) & (TIMER_WHEEL_SLOTS - 1);
+  timer.level = static_cast<uint8_t>(level);
+  timer.slot = static_cast<uint8_t>(slot);
+  timer.prev = nullptr;
+  timer.next = timerSlots[level][slot];
+  if (timer.next != nullptr) {
+    timer.next->prev = &timer;
+  }
+
+  timerSlots[level][slot] = &timer;
+  timerSlotMasks[level] |= UINT64_C(1) << slot;
+}
+
+void Dispatcher::unlinkTimer(TimerContext& timer) {
+  if (timer.prev != nullptr) {
+    timer.prev->next = timer.next;
+  } else {
+    timerSlots[timer.level][timer.slot] = timer.next;
+    if (timer.next == nullptr) {
+      timerSlotMasks[timer.level] &= ~(UINT64_C(1) << timer.slot);
+    }
+  }
+
+  if (timer.next != nullptr) {
+    timer.next->prev = timer.prev;
+  }
+}
+
+void Dispatcher::expireTimers() {
+  uint64_t now = monotonicNanoseconds() / NANOSECONDS_PER_TICK;
+  while (timerWheelTime <= now && timerCount != 0) {
+    if ((timerWheelTime & (TIMER_WHEEL_SLOTS - 1)) == 0) {
+      // a new period of a level begins, spread its slot over the levels below
+      for (size_t level = 1; level < TIMER_WHEEL_LEVELS; ++level) {
+        size_t slot = (timerWheelTime >> TIMER_WHEEL_BITS * level) & (TIMER_WHEEL_SLOTS - 1);
+        TimerContext* timer = timerSlots[level][slot];
+        timerSlots[level][slot] = nullptr;
+        timerSlotMasks[level] &= ~(UINT64_C(1) << slot);
+        while (timer != nullptr) {
+          TimerContext* next = timer->next;
+          insertTimer(*timer);
+          timer = next;
+        }
+
+        if (slot != 0) {
+          break;
+        }
+      }
+    }
+
+    size_t slot = timerWheelTime & (TIMER_WHEEL_SLOTS - 1);
+    TimerContext* timer = timerSlots[0][slot];
+    timerSlots[0][slot] = nullptr;
+    timerSlotMasks[0] &= ~(UINT64_C(1) << slot);
+    while (timer != nullptr) {
+      TimerContext* next = timer->next;
+      if (timer->deadline > timerWheelTime) {
+        insertTimer(*timer);
+      } else {
+        timer->pending = false;
+        --timerCount;
+        timer->context->interruptProcedure = nullptr;
+        pushContext(timer->context);
+      }
+
+      timer = next;
+    }
+
+    ++timerWheelTime;
+    if (timerSlotMasks[0] == 0) {
+      // nothing left in this period of level 0, skip to the next cascade
+      timerWheelTime = std::min((timerWheelTime + TIMER_WHEEL_SLOTS - 1) & ~static_cast<uint64_t>(TIMER_WHEEL_SLOTS - 1), now + 1);
+    }
+  }
+}
+
+uint64_t Dispatcher::nextTimerTime() const {
+  uint64_t next = UINT64_MAX;
+  if (timerCount == 0) {
+    return next;
+  }
+
+  for (size_t level = 0; level < TIMER_WHEEL_LEVELS; ++level) {
+    if (timerSlotMasks[level] == 0) {
+      continue;
+    }
+
+    // slots are visited from the one the wheel is at, wrapping into the next period
+    unsigned shift = static_cast<unsigned>(TIMER_WHEEL_BITS * level);
+    uint64_t base = (timerWheelTime + (UINT64_C(1) << shift) - 1) >> shift;
+    unsigned offset = base & (TIMER_WHEEL_SLOTS - 1);
+    uint64_t mask = timerSlotMasks[level];
+    uint64_t rotated = offset == 0 ? mask : mask >> offset | mask << (TIMER_WHEEL_SLOTS - offset);
+    next = std::min(next, (base + __builtin_ctzll(rotated)) << shift);
+  }
+
+  return next;
+}
+
+void Dispatcher::armTimerEvent() {
+  uint64_t next = nextTimerTime();
+  if (next >= timerArmedTime) {
+    return;
+  }
+
+  itimerspec expires;
+  expires.it_interval.tv_sec = 0;
+  expires.it_interval.tv_nsec = 0;
+  expires.it_value.tv_sec = next / 1000;
+  expires.it_value.tv_nsec = next % 1000 * NANOSECONDS_PER_TICK;
+  if (expires.it_value.tv_sec == 0 && expires.it_value.tv_nsec == 0) {
+    // a zero value disarms the timerfd
+    expires.it_value.tv_nsec = 1;
+  }
+
+  if (timerfd_settime(timerEvent, TFD_TIMER_ABSTIME, &expires, nullptr) == -1) {
+    throw std::runtime_error("Dispatcher::armTimerEvent, timerfd_settime failed, " + lastErrorMessage());
+  }
+
+  timerArmedTime = next;
+}
+
+void Dispatcher::switchTo(NativeContext* context) {
+  if (context != currentContext) {
+    MachineContext* oldContext = currentContext->machineContext;
+    currentContext = context;
+    switchMachineContext(*oldContext, *context->machineContext);
+  }
+}
+
+void Dispatcher::deleteReusableContexts() {
+  // the NativeContext lives on its own stack, so it is read before the stack goes back to the pool
+  while (firstReusableContext != nullptr) {
+    MachineContext* machineContext = firstReusableContext->machineContext;
+    uint8_t* stackPtr = firstReusableContext->stackPtr;
+    firstReusableContext = firstReusableContext->next;
+    releaseStack(stackPtr);
+    delete machineContext;
+  }
+}
+
+uint8_t* Dispatcher::allocateStack() {
+  if (freeStacks.empty()) {
+    size_t guardSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t slotSize = guardSize + STACK_SIZE;
+    size_t arenaSize = slotSize * STACKS_PER_ARENA;
+    void* arena = mmap(nullptr, arenaSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    if (arena == MAP_FAILED) {
+      throw std::runtime_error("Dispatcher::allocateStack, mmap failed, " + lastErrorMessage());
+    }
+
+    stackArenas.emplace_back(static_cast<uint8_t*>(arena), arenaSize);
+    freeStacks.reserve(stackArenas.size() * STACKS_PER_ARENA);
+    // stacks grow down, the guard page sits below each stack
+    for (size_t i = STACKS_PER_ARENA; i-- > 0;) {
+      uint8_t* slot = static_cast<uint8_t*>(arena) + i * slotSize;
+      if (mprotect(slot, guardSize, PROT_NONE) == -1) {
+        throw std::runtime_error("Dispatcher::allocateStack, mprotect failed, " + lastErrorMessage());
+      }
+
+      freeStacks.push_back(slot + guardSize);
+    }
+  }
+
+  uint8_t* stack = freeStacks.back();
+  freeStacks.pop_back();
+  return stack;
+}
+
+void Dispatcher::releaseStack(uint8_t* stack) {
+  freeStacks.push_back(stack);
+}
+
+void Dispatcher::releaseStackArenas() {
+  for (auto& arena : stackArenas) {
+    int result = munmap(arena.first, arena.second);
+    assert(result == 0);
+    std::ignore = result;
+  }
+
+  stackArenas.clear();
+  freeStacks.clear();
 }
 
 }
@@ -18,22 +18,26 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstddef>
 #include <cinttypes>
 #include <functional>
 #include <queue>
-#include <stack>
+#include <vector>
 #ifndef __GLIBC__
 #include <bits/reg.h>
 #endif
 
+struct epoll_event;
+
 namespace platform_system {
 
+struct MachineContext;
 struct NativeContextGroup;
 
 struct NativeContext {
-  void* ucontext;
-  void* stackPtr;
+  MachineContext* machineContext;
+  uint8_t* stackPtr;
   bool interrupted;
   bool inExecutionQueue;
   NativeContext* next;
@@ -63,6 +67,18 @@ struct ContextPair {
   OperationContext *writeContext;
 };
 
+// A pending sleep, linked into a slot of the dispatcher timer wheel. Deadlines are whole
+// milliseconds of CLOCK_MONOTONIC.
+struct TimerContext {
+  uint64_t deadline;
+  NativeContext* context;
+  TimerContext* prev;
+  TimerContext* next;
+  uint8_t level;
+  uint8_t slot;
+  bool pending;
+};
+
 class Dispatcher {
 public:
   Dispatcher();
@@ -83,8 +99,8 @@ public:
   int getEpoll() const;
   NativeContext& getReusableContext();
   void pushReusableContext(NativeContext&);
-  int getTimer();
-  void pushTimer(int timer);
+  void addTimer(TimerContext& timer, std::chrono::nanoseconds duration);
+  void removeTimer(TimerContext& timer);
 
 #ifdef __x86_64__
 # if __WORDSIZE == 64
@@ -103,7 +119,18 @@ private:
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
   std::queue<std::function<void()>> remoteSpawningProcedures;
-  std::stack<int> timers;
+
+  // Hierarchical timer wheel: slot s of level l holds timers due in the 64^l ticks starting at
+  // tick s * 64^l of the current level period, one timerfd is armed for the earliest occupied slot
+  static const size_t TIMER_WHEEL_LEVELS = 5;
+  static const size_t TIMER_WHEEL_SLOTS = 64;
+  int timerEvent;
+  ContextPair timerEventContext;
+  TimerContext* timerSlots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+  uint64_t timerSlotMasks[TIMER_WHEEL_LEVELS];
+  uint64_t timerWheelTime;
+  uint64_t timerArmedTime;
+  size_t timerCount;
 
   NativeContext mainContext;
   NativeContextGroup contextGroup;
@@ -112,8 +139,21 @@ private:
   NativeContext* lastResumingContext;
   NativeContext* firstReusableContext;
   size_t runningContextCount;
+  std::vector<std::pair<uint8_t*, size_t>> stackArenas;
+  std::vector<uint8_t*> freeStacks;
 
-  void contextProcedure(void* ucontext);
+  void resumeEventContexts(const epoll_event* events, int count);
+  void insertTimer(TimerContext& timer);
+  void unlinkTimer(TimerContext& timer);
+  void expireTimers();
+  uint64_t nextTimerTime() const;
+  void armTimerEvent();
+  void switchTo(NativeContext* context);
+  void deleteReusableContexts();
+  uint8_t* allocateStack();
+  void releaseStack(uint8_t* stack);
+  void releaseStackArenas();
+  void contextProcedure(MachineContext* machineContext);
   static void contextProcedureStatic(void* context);
 };
 
@@ -0,0 +1,134 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "MachineContext.h"
+
+#include <stdexcept>
+#include "ErrorMessage.h"
+
+#if defined(__x86_64__)
+
+extern "C" void platform_system_switch_context(void** from, void* to);
+extern "C" void platform_system_start_context();
+
+// The saved frame, from the stack pointer up: MXCSR and x87 control word, r15, r14, r13, r12, rbx,
+// rbp, return address. A new context "returns" into platform_system_start_context, which calls
+// r13 with r12 as the argument.
+asm(R"(
+  .text
+  .globl platform_system_switch_context
+  .type platform_system_switch_context, @function
+  .align 16
+platform_system_switch_context:
+  .cfi_startproc
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  subq $8, %rsp
+  stmxcsr (%rsp)
+  fnstcw 4(%rsp)
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  ldmxcsr (%rsp)
+  fldcw 4(%rsp)
+  addq $8, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .cfi_endproc
+  .size platform_system_switch_context, .-platform_system_switch_context
+
+  .globl platform_system_start_context
+  .type platform_system_start_context, @function
+  .align 16
+platform_system_start_context:
+  .cfi_startproc
+  .cfi_undefined rip
+  movq %r12, %rdi
+  callq *%r13
+  ud2
+  .cfi_endproc
+  .size platform_system_start_context, .-platform_system_start_context
+)");
+
+namespace platform_system {
+
+namespace {
+
+const uint32_t DEFAULT_MXCSR = 0x1f80;
+const uint16_t DEFAULT_FPU_CONTROL_WORD = 0x037f;
+
+}
+
+void makeMachineContext(MachineContext& context, uint8_t* stack, std::size_t stackSize, void (*entry)(void*), void* argument) {
+  // the entry is called with a 16 byte aligned stack, like any function
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + stackSize) & ~static_cast<uintptr_t>(15);
+  uint64_t* frame = reinterpret_cast<uint64_t*>(top - 16) - 8;
+  frame[0] = DEFAULT_MXCSR | static_cast<uint64_t>(DEFAULT_FPU_CONTROL_WORD) << 32;
+  frame[1] = 0; // r15
+  frame[2] = 0; // r14
+  frame[3] = reinterpret_cast<uint64_t>(entry); // r13
+  frame[4] = reinterpret_cast<uint64_t>(argument); // r12
+  frame[5] = 0; // rbx
+  frame[6] = 0; // rbp
+  frame[7] = reinterpret_cast<uint64_t>(&platform_system_start_context);
+  context.stackPointer = frame;
+}
+
+void switchMachineContext(MachineContext& from, MachineContext& to) {
+  platform_system_switch_context(&from.stackPointer, to.stackPointer);
+}
+
+}
+
+#else
+
+namespace platform_system {
+
+namespace {
+
+struct ContextEntry {
+  void (*entry)(void*);
+  void* argument;
+};
+
+void startContext(unsigned int high, unsigned int low) {
+  ContextEntry* contextEntry = reinterpret_cast<ContextEntry*>(static_cast<uintptr_t>(high) << 16 << 16 | low);
+  ContextEntry copy = *contextEntry;
+  delete contextEntry;
+  copy.entry(copy.argument);
+}
+
+}
+
+void makeMachineContext(MachineContext& context, uint8_t* stack, std::size_t stackSize, void (*entry)(void*), void* argument) {
+  if (getcontext(&context.context) == -1) {
+    throw std::runtime_error("makeMachineContext, getcontext failed, " + lastErrorMessage());
+  }
+
+  context.context.uc_stack.ss_sp = stack;
+  context.context.uc_stack.ss_size = stackSize;
+  context.context.uc_link = nullptr;
+  uintptr_t contextEntry = reinterpret_cast<uintptr_t>(new ContextEntry{ entry, argument });
+  makecontext(&context.context, reinterpret_cast<void(*)()>(startContext), 2,
+    static_cast<unsigned int>(contextEntry >> 16 >> 16), static_cast<unsigned int>(contextEntry));
+}
+
+void switchMachineContext(MachineContext& from, MachineContext& to) {
+  if (swapcontext(&from.context, &to.context) == -1) {
+    throw std::runtime_error("switchMachineContext, swapcontext failed, " + lastErrorMessage());
+  }
+}
+
+}
+
+#endif
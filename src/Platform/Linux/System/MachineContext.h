@@ -0,0 +1,32 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+namespace platform_system {
+
+// Execution state of a dispatcher context. On x86-64 a switch only saves the callee-saved registers
+// on the stack being left, unlike swapcontext it makes no sigprocmask call. Other architectures
+// fall back to ucontext.
+struct MachineContext {
+#if defined(__x86_64__)
+  void* stackPointer;
+#else
+  ucontext_t context;
+#endif
+};
+
+// Prepares context to call entry(argument) on the given stack once it is switched to. entry must not return.
+void makeMachineContext(MachineContext& context, uint8_t* stack, std::size_t stackSize, void (*entry)(void*), void* argument);
+// Saves the running state into from and resumes to
+void switchMachineContext(MachineContext& from, MachineContext& to);
+
+}
@@ -21,6 +21,8 @@
 #include <arpa/inet.h>
 #include <cassert>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <stdexcept>
 
@@ -30,6 +32,13 @@
 
 namespace platform_system {
 
+namespace {
+
+// Buffers gathered by one send, the rest is left to the next write; keeps the iovec array small on context stacks
+const size_t MAX_WRITE_BUFFERS = 64;
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -169,7 +178,6 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if(size == 0) {
     if(shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -178,7 +186,32 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+  ConstBuffer buffer = { data, size };
+  return writeGathered(&buffer, 1);
+}
+
+std::size_t TcpConnection::writeGathered(const ConstBuffer* buffers, std::size_t count) {
+  assert(dispatcher != nullptr);
+  assert(contextPair.writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  iovec vectors[MAX_WRITE_BUFFERS];
+  msghdr header = {};
+  header.msg_iov = vectors;
+  size_t size = 0;
+  for (size_t i = 0; i < count && header.msg_iovlen < MAX_WRITE_BUFFERS; ++i) {
+    if (buffers[i].size != 0) {
+      vectors[header.msg_iovlen].iov_base = const_cast<uint8_t*>(buffers[i].data);
+      vectors[header.msg_iovlen].iov_len = buffers[i].size;
+      ++header.msg_iovlen;
+      size += buffers[i].size;
+    }
+  }
+
+  std::string message;
+  ssize_t transferred = ::sendmsg(connection, &header, MSG_NOSIGNAL);
   if (transferred == -1) {
     if (errno != EAGAIN) {
       message = "send failed, " + lastErrorMessage();
@@ -241,7 +274,7 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::sendmsg(connection, &header, MSG_NOSIGNAL);
         if (transferred == -1) {
           message = "send failed, "  + lastErrorMessage();
         } else {
@@ -11,6 +11,7 @@
 #include <sys/event.h>
 #include <sys/errno.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "Dispatcher.h"
@@ -20,6 +21,13 @@
 
 namespace platform_system {
 
+namespace {
+
+// Buffers gathered by one send, the rest is left to the next write; keeps the iovec array small on context stacks
+const size_t MAX_WRITE_BUFFERS = 64;
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -139,7 +147,6 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     throw InterruptedException();
   }
 
-  std::string message;
   if (size == 0) {
     if (shutdown(connection, SHUT_WR) == -1) {
       throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -148,7 +155,36 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  ssize_t transferred = ::send(connection, (void *)data, size, 0);
+  ConstBuffer buffer = { data, size };
+  return writeGathered(&buffer, 1);
+}
+
+size_t TcpConnection::writeGathered(const ConstBuffer* buffers, size_t count) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  iovec vectors[MAX_WRITE_BUFFERS];
+  msghdr header = {};
+  header.msg_iov = vectors;
+  size_t size = 0;
+  for (size_t i = 0; i < count && header.msg_iovlen < static_cast<int>(MAX_WRITE_BUFFERS); ++i) {
+    if (buffers[i].size != 0) {
+      vectors[header.msg_iovlen].iov_base = const_cast<uint8_t*>(buffers[i].data);
+      vectors[header.msg_iovlen].iov_len = buffers[i].size;
+      ++header.msg_iovlen;
+      size += buffers[i].size;
+    }
+  }
+
+  if (header.msg_iovlen == 0) {
+    return 0;
+  }
+
+  std::string message;
+  ssize_t transferred = ::sendmsg(connection, &header, 0);
   if (transferred == -1) {
     if (errno != EAGAIN  && errno != EWOULDBLOCK) {
       message = "send failed, " + lastErrorMessage();
@@ -190,7 +226,7 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
           throw InterruptedException();
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, 0);
+        ssize_t transferred = ::sendmsg(connection, &header, 0);
         if (transferred == -1) {
           message = "send failed, " + lastErrorMessage();
         } else {
@@ -26,6 +26,9 @@ struct TcpConnectionContext : public OVERLAPPED {
   bool interrupted;
 };
 
+// Buffers gathered by one send, the rest is left to the next write; keeps the WSABUF array small on context stacks
+const size_t MAX_WRITE_BUFFERS = 64;
+
 }
 
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
@@ -150,10 +153,36 @@ size_t TcpConnection::write(const uint8_t* data, size_t size) {
     return 0;
   }
 
-  WSABUF buf{static_cast<ULONG>(size), reinterpret_cast<char*>(const_cast<uint8_t*>(data))};
+  ConstBuffer buffer = { data, size };
+  return writeGathered(&buffer, 1);
+}
+
+size_t TcpConnection::writeGathered(const ConstBuffer* buffers, size_t count) {
+  assert(dispatcher != nullptr);
+  assert(writeContext == nullptr);
+  if (dispatcher->interrupted()) {
+    throw InterruptedException();
+  }
+
+  WSABUF bufs[MAX_WRITE_BUFFERS];
+  DWORD bufCount = 0;
+  size_t size = 0;
+  for (size_t i = 0; i < count && bufCount < MAX_WRITE_BUFFERS; ++i) {
+    if (buffers[i].size != 0) {
+      bufs[bufCount].len = static_cast<ULONG>(buffers[i].size);
+      bufs[bufCount].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(buffers[i].data));
+      ++bufCount;
+      size += buffers[i].size;
+    }
+  }
+
+  if (bufCount == 0) {
+    return 0;
+  }
+
   TcpConnectionContext context;
   context.hEvent = NULL;
-  if (WSASend(connection, &buf, 1, NULL, 0, &context, NULL) != 0) {
+  if (WSASend(connection, bufs, bufCount, NULL, 0, &context, NULL) != 0) {
     int lastError = WSAGetLastError();
     if (lastError != WSA_IO_PENDING) {
       throw std::runtime_error("TcpConnection::write, WSASend failed, " + errorMessage(lastError));
@@ -16,6 +16,11 @@ class Ipv4Address;
 
 class TcpConnection {
 public:
+  struct ConstBuffer {
+    const uint8_t* data;
+    size_t size;
+  };
+
   TcpConnection();
   TcpConnection(const TcpConnection&) = delete;
   TcpConnection(TcpConnection&& other);
@@ -24,6 +29,8 @@ public:
   TcpConnection& operator=(TcpConnection&& other);
   size_t read(uint8_t* data, size_t size);
   size_t write(const uint8_t* data, size_t size);
+  // Gathers the buffers into a single send, returns the number of bytes sent from their concatenation
+  size_t writeGathered(const ConstBuffer* buffers, size_t count);
   std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
 private:
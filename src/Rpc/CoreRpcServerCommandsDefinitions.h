@@ -145,6 +145,36 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   };
 };
 
+struct COMMAND_RPC_GET_POOL_CHANGES_SINCE {
+  struct request {
+    crypto::Hash tailBlockId;
+    uint64_t poolVersion; // from the previous response, 0 for the whole pool
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(poolVersion)
+    }
+  };
+
+  struct response {
+    bool isTailBlockActual;
+    bool isFullPool;                                // addedTxs is the whole pool, forget the transactions known before
+    uint64_t poolVersion;
+    std::vector<TransactionPrefixInfo> addedTxs;
+    std::vector<crypto::Hash> deletedTxsIds;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(isTailBlockActual)
+      KV_MEMBER(isFullPool)
+      KV_MEMBER(poolVersion)
+      KV_MEMBER(addedTxs)
+      serializeAsBinary(deletedTxsIds, "deletedTxsIds", s);
+      KV_MEMBER(status)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
 
@@ -166,6 +196,36 @@ struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
     }
   };
 };
+
+struct COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES {
+
+  struct request {
+    std::vector<crypto::Hash> txids;
+
+    void serialize(ISerializer &s) {
+      serializeAsBinary(txids, "txids", s);
+    }
+  };
+
+  struct transaction_indexes {
+    std::vector<uint64_t> o_indexes;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(o_indexes)
+    }
+  };
+
+  struct response {
+    // in the order of the request
+    std::vector<transaction_indexes> transactions;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(transactions)
+      KV_MEMBER(status)
+    }
+  };
+};
 //-----------------------------------------------
 struct COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_request {
   std::vector<uint64_t> amounts;
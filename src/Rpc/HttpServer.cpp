@@ -18,6 +18,7 @@
 // along with Karbo.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "HttpServer.h"
+#include <cassert>
 #include <boost/scope_exit.hpp>
 
 #include <Common/Base64.h>
@@ -40,11 +41,34 @@ namespace {
 namespace cn {
 
 HttpServer::HttpServer(platform_system::Dispatcher& dispatcher, logging::ILogger& log)
-  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer") {
+  : m_dispatcher(dispatcher), workingContextGroup(dispatcher), logger(log, "HttpServer"), m_workerThreads(0) {
 
 }
 
+HttpServer::~HttpServer() {
+  stopWorkers();
+}
+
+void HttpServer::setWorkerThreads(size_t count) {
+  assert(m_workers.empty());
+  m_workerThreads = count;
+}
+
 void HttpServer::start(const std::string& address, uint16_t port, const std::string& user, const std::string& password) {
+  for (size_t i = 0; i < m_workerThreads; ++i) {
+    std::unique_ptr<Worker> worker(new Worker{ std::thread(), nullptr, nullptr, 0 });
+    std::promise<void> started;
+    worker->thread = std::thread(&HttpServer::workerThread, this, std::ref(*worker), std::ref(started));
+    try {
+      started.get_future().get();
+    } catch (std::exception&) {
+      worker->thread.join();
+      throw;
+    }
+
+    m_workers.push_back(std::move(worker));
+  }
+
   m_listener = platform_system::TcpListener(m_dispatcher, platform_system::Ipv4Address(address), port);
   workingContextGroup.spawn(std::bind(&HttpServer::acceptLoop, this));
   
@@ -56,6 +80,85 @@ void HttpServer::start(const std::string& address, uint16_t port, const std::str
 void HttpServer::stop() {
   workingContextGroup.interrupt();
   workingContextGroup.wait();
+  stopWorkers();
+}
+
+void HttpServer::runOnWorker(const std::function<void()>& procedure) {
+  if (m_workers.empty()) {
+    procedure();
+    return;
+  }
+
+  Worker* worker = m_workers.front().get();
+  for (auto& candidate : m_workers) {
+    if (candidate->pendingProcedures < worker->pendingProcedures) {
+      worker = candidate.get();
+    }
+  }
+
+  ++worker->pendingProcedures;
+  platform_system::Event done(m_dispatcher);
+  std::exception_ptr error;
+  platform_system::Dispatcher* dispatcher = &m_dispatcher;
+  worker->dispatcher->remoteSpawn([&procedure, &done, &error, dispatcher] {
+    try {
+      procedure();
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    platform_system::Event* doneEvent = &done;
+    dispatcher->remoteSpawn([doneEvent] { doneEvent->set(); });
+  });
+
+  // the worker uses this frame until it reports back, an interrupt is passed on after that
+  bool interrupted = false;
+  while (!done.get()) {
+    try {
+      done.wait();
+    } catch (platform_system::InterruptedException&) {
+      interrupted = true;
+    }
+  }
+
+  --worker->pendingProcedures;
+  if (interrupted) {
+    m_dispatcher.interrupt();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void HttpServer::workerThread(Worker& worker, std::promise<void>& started) {
+  std::unique_ptr<platform_system::Dispatcher> dispatcher;
+  std::unique_ptr<platform_system::Event> stopEvent;
+  try {
+    dispatcher.reset(new platform_system::Dispatcher);
+    stopEvent.reset(new platform_system::Event(*dispatcher));
+  } catch (std::exception&) {
+    started.set_exception(std::current_exception());
+    return;
+  }
+
+  worker.dispatcher = dispatcher.get();
+  worker.stopEvent = stopEvent.get();
+  started.set_value();
+  stopEvent->wait();
+}
+
+void HttpServer::stopWorkers() {
+  for (auto& worker : m_workers) {
+    platform_system::Event* stopEvent = worker->stopEvent;
+    worker->dispatcher->remoteSpawn([stopEvent] { stopEvent->set(); });
+  }
+
+  for (auto& worker : m_workers) {
+    worker->thread.join();
+  }
+
+  m_workers.clear();
 }
 
 void HttpServer::acceptLoop() {
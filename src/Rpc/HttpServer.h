@@ -18,7 +18,11 @@
 
 #pragma once 
 
+#include <future>
+#include <memory>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <HTTP/HttpRequest.h>
 #include <HTTP/HttpResponse.h>
@@ -38,7 +42,10 @@ class HttpServer {
 public:
 
   HttpServer(platform_system::Dispatcher& dispatcher, logging::ILogger& log);
+  ~HttpServer();
 
+  // Threads with their own dispatcher for requests passed to runOnWorker, set before start
+  void setWorkerThreads(size_t count);
   void start(const std::string& address, uint16_t port, const std::string& user = "", const std::string& password = "");
   void stop();
 
@@ -47,10 +54,24 @@ public:
 
 protected:
 
+  // Runs procedure on the least busy worker thread and resumes the calling context when it is done,
+  // exceptions are rethrown here. Without workers the procedure runs in place.
+  void runOnWorker(const std::function<void()>& procedure);
+
   platform_system::Dispatcher& m_dispatcher;
 
 private:
 
+  struct Worker {
+    std::thread thread;
+    platform_system::Dispatcher* dispatcher;
+    platform_system::Event* stopEvent;
+    size_t pendingProcedures;
+  };
+
+  void workerThread(Worker& worker, std::promise<void>& started);
+  void stopWorkers();
+
   void acceptLoop();
   void connectionHandler(platform_system::TcpConnection&& conn);
   bool authenticate(const HttpRequest& request) const;
@@ -60,6 +81,8 @@ private:
   platform_system::TcpListener m_listener;
   std::unordered_set<platform_system::TcpConnection*> m_connections;
   std::string m_credentials;
+  size_t m_workerThreads;
+  std::vector<std::unique_ptr<Worker>> m_workers;
 };
 
 }
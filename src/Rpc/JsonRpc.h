@@ -20,6 +20,7 @@
 #include <boost/optional.hpp>
 #include <boost/foreach.hpp>
 #include <functional>
+#include <memory>
 
 #include "CoreRpcServerCommandsDefinitions.h"
 #include <Common/JsonValue.h>
@@ -68,21 +69,22 @@ public:
   
   JsonRpcRequest() : psReq(common::JsonValue::OBJECT) {}
 
+  // The params are deserialized from the request text when the method is invoked
   bool parseRequest(const std::string& requestBody) {
+    body = requestBody;
     try {
-      psReq = common::JsonValue::fromString(requestBody);
+      reader.reset(new JsonInputBufferSerializer(body));
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
 
-    if (!psReq.contains("method")) {
+    if (!(*reader)(method, "method")) {
       throw JsonRpcError(errInvalidRequest);
     }
 
-    method = psReq("method").getString();
-
-    if (psReq.contains("id")) {
-      id = psReq("id");
+    common::JsonValue idValue;
+    if (reader->jsonValue(idValue, "id")) {
+      id = idValue;
     }
 
     return true;
@@ -90,8 +92,28 @@ public:
 
   template <typename T>
   bool loadParams(T& v) const {
-    loadFromJsonValue(v, psReq.contains("params") ? 
-      psReq("params") : common::JsonValue(common::JsonValue::NIL));
+    if (!reader->beginObject("params")) {
+      return false;
+    }
+
+    serialize(v, *reader);
+    reader->endObject();
+    return true;
+  }
+
+  template <typename T>
+  bool loadParams(std::vector<T>& v) const {
+    size_t size;
+    if (!reader->beginArray(size, "params")) {
+      return false;
+    }
+
+    v.resize(size);
+    for (auto& item : v) {
+      (*reader)(item, "");
+    }
+
+    reader->endArray();
     return true;
   }
 
@@ -122,6 +144,8 @@ public:
 private:
 
   common::JsonValue psReq;
+  std::string body;
+  std::unique_ptr<JsonInputBufferSerializer> reader;
   OptionalId id;
   std::string method;
 };
@@ -161,12 +185,22 @@ public:
 
   std::string getBody() {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string body = psResp.toString();
+    if (!result.empty()) {
+      // "result" sorts last among the members, as JsonValue would have put it
+      body.pop_back();
+      body += ",\"result\":";
+      body += result;
+      body += '}';
+    }
+
+    return body;
   }
 
+  // The result is serialized to text right away and spliced into the body
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    result = storeToJson(v);
     return true;
   }
 
@@ -182,6 +216,7 @@ public:
 
 private:
   common::JsonValue psResp;
+  std::string result;
 };
 
 
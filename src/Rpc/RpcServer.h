@@ -8,9 +8,13 @@
 #include "HttpServer.h"
 
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include <Logging/LoggerRef.h>
+#include "Common/LatencyHistogram.h"
 #include "Common/Math.h"
 #include "CoreRpcServerCommandsDefinitions.h"
 
@@ -32,6 +36,8 @@ public:
   bool enableCors(const std::vector<std::string> domains);
   std::vector<std::string> getCorsDomains();
   bool remotenode_check_incoming_tx(const BinaryArray& tx_blob);
+  // One line per endpoint and json rpc method served so far, with the latency of its requests
+  std::string getLatencyStatistics() const;
 
 private:
 
@@ -39,6 +45,8 @@ private:
   struct RpcHandler {
     const Handler handler;
     const bool allowBusyCore;
+    // only reads the core under its own locks, so it may run on an RPC worker thread
+    const bool concurrent;
   };
 
   typedef void (RpcServer::*HandlerPtr)(const HttpRequest& request, HttpResponse& response);
@@ -47,15 +55,18 @@ private:
   virtual void processRequest(const HttpRequest& request, HttpResponse& response) override;
   bool processJsonRpcRequest(const HttpRequest& request, HttpResponse& response);
   bool isCoreReady();
+  void addLatency(const std::string& name, std::chrono::steady_clock::time_point start);
 
   // binary handlers
   bool on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res);
   bool on_query_blocks(const COMMAND_RPC_QUERY_BLOCKS::request& req, COMMAND_RPC_QUERY_BLOCKS::response& res);
   bool on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::request& req, COMMAND_RPC_QUERY_BLOCKS_LITE::response& res);
   bool on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::response& res);
+  bool on_get_txs_indexes(const COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::request& req, COMMAND_RPC_GET_TXS_GLOBAL_OUTPUTS_INDEXES::response& res);
   bool on_get_random_outs_bin(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res);
   bool onGetPoolChanges(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp);
   bool onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp);
+  bool onGetPoolChangesSince(const COMMAND_RPC_GET_POOL_CHANGES_SINCE::request& req, COMMAND_RPC_GET_POOL_CHANGES_SINCE::response& rsp);
 
   // json handlers
   bool on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res);
@@ -100,6 +111,8 @@ private:
   std::string m_fee_address;
   crypto::SecretKey m_view_key = NULL_SECRET_KEY;
   AccountPublicAddress m_fee_acc; 
+  mutable std::mutex m_latencyMutex;
+  std::map<std::string, std::unique_ptr<common::LatencyHistogram>> m_latencies;
 };
 
 }
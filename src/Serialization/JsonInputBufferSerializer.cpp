@@ -0,0 +1,507 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonInputBufferSerializer.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "Common/StringTools.h"
+
+using namespace cn;
+
+namespace {
+
+char peekNonWsChar(const std::string& json, size_t& position) {
+  while (position < json.size() && (json[position] == ' ' || json[position] == '\n' || json[position] == '\r' || json[position] == '\t')) {
+    ++position;
+  }
+
+  if (position == json.size()) {
+    throw std::runtime_error("Unable to parse: unexpected end of stream");
+  }
+
+  return json[position];
+}
+
+bool isDigit(const std::string& json, size_t position) {
+  return position < json.size() && json[position] >= '0' && json[position] <= '9';
+}
+
+uint32_t readHexCode(const std::string& json, size_t position, size_t end) {
+  if (position + 4 > end) {
+    throw std::runtime_error("Unable to parse: bad escape sequence");
+  }
+
+  uint32_t code = 0;
+  for (size_t i = position; i < position + 4; ++i) {
+    code = code << 4 | common::fromHex(json[i]);
+  }
+
+  return code;
+}
+
+void appendUtf8(std::string& text, uint32_t code) {
+  if (code < 0x80) {
+    text += static_cast<char>(code);
+  } else if (code < 0x800) {
+    text += static_cast<char>(0xc0 | code >> 6);
+    text += static_cast<char>(0x80 | (code & 0x3f));
+  } else if (code < 0x10000) {
+    text += static_cast<char>(0xe0 | code >> 12);
+    text += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+    text += static_cast<char>(0x80 | (code & 0x3f));
+  } else {
+    text += static_cast<char>(0xf0 | code >> 18);
+    text += static_cast<char>(0x80 | (code >> 12 & 0x3f));
+    text += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+    text += static_cast<char>(0x80 | (code & 0x3f));
+  }
+}
+
+}
+
+JsonInputBufferSerializer::JsonInputBufferSerializer(const std::string& json) : json(json) {
+  tokenize();
+  if (tokens[0].type != OBJECT) {
+    throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+  }
+
+  levels.push_back(Level{ 0, 1 });
+}
+
+JsonInputBufferSerializer::~JsonInputBufferSerializer() {
+}
+
+ISerializer::SerializerType JsonInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+// Iterative, so that deeply nested input cannot exhaust the small stacks of dispatcher contexts
+void JsonInputBufferSerializer::tokenize() {
+  if (json.size() >= std::numeric_limits<uint32_t>::max()) {
+    throw std::runtime_error("Unable to parse: text is too long");
+  }
+
+  tokens.reserve(json.size() / 16 + 1);
+  std::vector<uint32_t> open;
+  bool afterValue = false;
+  size_t position = 0;
+
+  for (;;) {
+    char c = peekNonWsChar(json, position);
+    if (!open.empty()) {
+      uint32_t container = open.back();
+      bool isObject = tokens[container].type == OBJECT;
+      if (c == (isObject ? '}' : ']') && (afterValue || tokens[container].count == 0)) {
+        ++position;
+        tokens[container].end = static_cast<uint32_t>(position);
+        tokens[container].next = static_cast<uint32_t>(tokens.size());
+        open.pop_back();
+        if (open.empty()) {
+          break;
+        }
+
+        afterValue = true;
+        continue;
+      }
+
+      if (afterValue) {
+        if (c != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        ++position;
+        c = peekNonWsChar(json, position);
+        afterValue = false;
+      }
+
+      if (isObject) {
+        if (c != '"') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        readString(position);
+        if (peekNonWsChar(json, position) != ':') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        ++position;
+        c = peekNonWsChar(json, position);
+      }
+
+      ++tokens[container].count;
+    }
+
+    if (c == '{' || c == '[') {
+      open.push_back(static_cast<uint32_t>(tokens.size()));
+      tokens.push_back(Token{ static_cast<uint32_t>(position), 0, 0, 0, c == '{' ? OBJECT : ARRAY, false });
+      ++position;
+      afterValue = false;
+      continue;
+    }
+
+    if (c == '"') {
+      readString(position);
+    } else if (c == '-' || (c >= '0' && c <= '9')) {
+      readNumber(position);
+    } else if (c == 't') {
+      readLiteral(position, "true", TRUE_VALUE);
+    } else if (c == 'f') {
+      readLiteral(position, "false", FALSE_VALUE);
+    } else if (c == 'n') {
+      readLiteral(position, "null", NIL);
+    } else {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    if (open.empty()) {
+      break;
+    }
+
+    afterValue = true;
+  }
+}
+
+void JsonInputBufferSerializer::readString(size_t& position) {
+  size_t begin = position++;
+  bool escaped = false;
+  for (;;) {
+    if (position >= json.size()) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    char c = json[position++];
+    if (c == '"') {
+      break;
+    }
+
+    if (c == '\\') {
+      escaped = true;
+      ++position;
+    }
+  }
+
+  uint32_t next = static_cast<uint32_t>(tokens.size() + 1);
+  tokens.push_back(Token{ static_cast<uint32_t>(begin), static_cast<uint32_t>(position), next, 0, STRING, escaped });
+}
+
+void JsonInputBufferSerializer::readNumber(size_t& position) {
+  size_t begin = position;
+  if (json[position] == '-') {
+    ++position;
+  }
+
+  size_t digits = position;
+  while (isDigit(json, position)) {
+    ++position;
+  }
+
+  if (position == digits || (json[digits] == '0' && position - digits > 1)) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  bool real = false;
+  if (position < json.size() && json[position] == '.') {
+    real = true;
+    if (!isDigit(json, ++position)) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    while (isDigit(json, position)) {
+      ++position;
+    }
+  }
+
+  if (position < json.size() && (json[position] == 'e' || json[position] == 'E')) {
+    real = true;
+    ++position;
+    if (position < json.size() && (json[position] == '+' || json[position] == '-')) {
+      ++position;
+    }
+
+    if (!isDigit(json, position)) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    while (isDigit(json, position)) {
+      ++position;
+    }
+  }
+
+  uint32_t next = static_cast<uint32_t>(tokens.size() + 1);
+  tokens.push_back(Token{ static_cast<uint32_t>(begin), static_cast<uint32_t>(position), next, 0, NUMBER, real });
+}
+
+void JsonInputBufferSerializer::readLiteral(size_t& position, const char* literal, TokenType type) {
+  size_t size = strlen(literal);
+  if (json.compare(position, size, literal) != 0) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  uint32_t next = static_cast<uint32_t>(tokens.size() + 1);
+  tokens.push_back(Token{ static_cast<uint32_t>(position), static_cast<uint32_t>(position + size), next, 0, type, false });
+  position += size;
+}
+
+bool JsonInputBufferSerializer::beginObject(common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != OBJECT) {
+    throw std::runtime_error("JsonValue type is not OBJECT");
+  }
+
+  uint32_t index = static_cast<uint32_t>(token - tokens.data());
+  levels.push_back(Level{ index, index + 1 });
+  return true;
+}
+
+void JsonInputBufferSerializer::endObject() {
+  assert(levels.size() > 1);
+  levels.pop_back();
+}
+
+bool JsonInputBufferSerializer::beginArray(size_t& size, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (token->type != ARRAY) {
+    throw std::runtime_error("JsonValue type is not ARRAY");
+  }
+
+  uint32_t index = static_cast<uint32_t>(token - tokens.data());
+  levels.push_back(Level{ index, index + 1 });
+  size = token->count;
+  return true;
+}
+
+void JsonInputBufferSerializer::endArray() {
+  assert(levels.size() > 1);
+  levels.pop_back();
+}
+
+bool JsonInputBufferSerializer::operator()(uint16_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int16_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint32_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int32_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int64_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint64_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint8_t& value, common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(double& value, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != NUMBER) {
+    throw std::runtime_error("JsonValue type is not REAL");
+  }
+
+  value = std::strtod(json.substr(token->begin, token->end - token->begin).c_str(), nullptr);
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(bool& value, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != TRUE_VALUE && token->type != FALSE_VALUE) {
+    throw std::runtime_error("JsonValue type is not BOOL");
+  }
+
+  value = token->type == TRUE_VALUE;
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(std::string& value, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  value = getString(*token);
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(void* value, size_t size, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  common::fromHex(getString(*token), value, size);
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(std::string& value, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  value = common::asString(common::fromHex(getString(*token)));
+  return true;
+}
+
+bool JsonInputBufferSerializer::jsonValue(common::JsonValue& value, common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  value = common::JsonValue::fromString(json.substr(token->begin, token->end - token->begin));
+  return true;
+}
+
+const JsonInputBufferSerializer::Token* JsonInputBufferSerializer::getValue(common::StringView name) {
+  Level& level = levels.back();
+  const Token& parent = tokens[level.token];
+  if (parent.type == ARRAY) {
+    if (level.cursor == parent.next) {
+      throw std::runtime_error("Unable to read past the end of an array");
+    }
+
+    const Token* token = &tokens[level.cursor];
+    level.cursor = token->next;
+    return token;
+  }
+
+  uint32_t key = level.cursor;
+  for (uint32_t i = 0; i < parent.count; ++i) {
+    if (key == parent.next) {
+      key = level.token + 1;
+    }
+
+    const Token& value = tokens[key + 1];
+    if (keyEquals(tokens[key], name)) {
+      level.cursor = value.next;
+      return &value;
+    }
+
+    key = value.next;
+  }
+
+  return nullptr;
+}
+
+bool JsonInputBufferSerializer::keyEquals(const Token& key, common::StringView name) const {
+  if (key.special) {
+    return getString(key) == std::string(name.getData(), name.getSize());
+  }
+
+  return key.end - key.begin - 2 == name.getSize() && memcmp(json.data() + key.begin + 1, name.getData(), name.getSize()) == 0;
+}
+
+std::string JsonInputBufferSerializer::getString(const Token& token) const {
+  if (token.type != STRING) {
+    throw std::runtime_error("JsonValue type is not STRING");
+  }
+
+  size_t end = token.end - 1;
+  if (!token.special) {
+    return json.substr(token.begin + 1, end - token.begin - 1);
+  }
+
+  std::string value;
+  value.reserve(end - token.begin - 1);
+  for (size_t i = token.begin + 1; i < end; ++i) {
+    char c = json[i];
+    if (c != '\\') {
+      value += c;
+      continue;
+    }
+
+    c = json[++i];
+    switch (c) {
+    case 'b': value += '\b'; break;
+    case 'f': value += '\f'; break;
+    case 'n': value += '\n'; break;
+    case 'r': value += '\r'; break;
+    case 't': value += '\t'; break;
+    case 'u': {
+      uint32_t code = readHexCode(json, i + 1, end);
+      i += 4;
+      if (code >= 0xd800 && code < 0xdc00 && i + 6 < end && json[i + 1] == '\\' && json[i + 2] == 'u') {
+        uint32_t low = readHexCode(json, i + 3, end);
+        if (low >= 0xdc00 && low < 0xe000) {
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          i += 6;
+        }
+      }
+
+      appendUtf8(value, code);
+      break;
+    }
+    // quotes, slashes and the escaped line feeds written by JsonValue
+    default: value += c; break;
+    }
+  }
+
+  return value;
+}
+
+uint64_t JsonInputBufferSerializer::getInteger(const Token& token) const {
+  if (token.type != NUMBER || token.special) {
+    throw std::runtime_error("JsonValue type is not INTEGER");
+  }
+
+  size_t i = token.begin;
+  bool negative = json[i] == '-';
+  if (negative) {
+    ++i;
+  }
+
+  uint64_t value = 0;
+  for (; i < token.end; ++i) {
+    unsigned digit = json[i] - '0';
+    if (value > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+      throw std::runtime_error("Unable to parse: integer out of range");
+    }
+
+    value = value * 10 + digit;
+  }
+
+  if (negative) {
+    if (value > static_cast<uint64_t>(1) << 63) {
+      throw std::runtime_error("Unable to parse: integer out of range");
+    }
+
+    value = 0 - value;
+  }
+
+  return value;
+}
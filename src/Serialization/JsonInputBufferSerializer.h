@@ -0,0 +1,112 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Common/JsonValue.h"
+#include "ISerializer.h"
+
+namespace cn {
+
+// Deserializes straight from a JSON text without building a JsonValue tree. The text is scanned
+// once into a flat array of tokens which point back into it, strings are only copied and
+// unescaped when a field asks for them. Members are looked up from where the previous lookup
+// stopped, so fields read in the order they were written cost one comparison each. With
+// duplicate keys the first one wins.
+class JsonInputBufferSerializer : public ISerializer {
+public:
+  // json must outlive the serializer, its top level value has to be an object
+  JsonInputBufferSerializer(const std::string& json);
+  JsonInputBufferSerializer(std::string&& json) = delete;
+  virtual ~JsonInputBufferSerializer();
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, common::StringView name) override;
+  virtual bool operator()(int16_t& value, common::StringView name) override;
+  virtual bool operator()(uint16_t& value, common::StringView name) override;
+  virtual bool operator()(int32_t& value, common::StringView name) override;
+  virtual bool operator()(uint32_t& value, common::StringView name) override;
+  virtual bool operator()(int64_t& value, common::StringView name) override;
+  virtual bool operator()(uint64_t& value, common::StringView name) override;
+  virtual bool operator()(double& value, common::StringView name) override;
+  virtual bool operator()(bool& value, common::StringView name) override;
+  virtual bool operator()(std::string& value, common::StringView name) override;
+  virtual bool binary(void* value, size_t size, common::StringView name) override;
+  virtual bool binary(std::string& value, common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // Parses a single member of any type into a JsonValue, for the few places that pass JSON through
+  bool jsonValue(common::JsonValue& value, common::StringView name);
+
+private:
+  enum TokenType : uint8_t {
+    OBJECT,
+    ARRAY,
+    STRING,
+    NUMBER,
+    TRUE_VALUE,
+    FALSE_VALUE,
+    NIL
+  };
+
+  struct Token {
+    // [begin, end) spans the whole value in the text, quotes and brackets included
+    uint32_t begin;
+    uint32_t end;
+    // index of the token following this value and everything inside it
+    uint32_t next;
+    // members of an object or elements of an array
+    uint32_t count;
+    TokenType type;
+    // a string containing escape sequences, a number with a fraction or exponent
+    bool special;
+  };
+
+  struct Level {
+    uint32_t token;
+    // next element of an array, or the key of an object to start the next lookup from
+    uint32_t cursor;
+  };
+
+  const std::string& json;
+  std::vector<Token> tokens;
+  std::vector<Level> levels;
+
+  void tokenize();
+  void readString(size_t& position);
+  void readNumber(size_t& position);
+  void readLiteral(size_t& position, const char* literal, TokenType type);
+
+  const Token* getValue(common::StringView name);
+  bool keyEquals(const Token& key, common::StringView name) const;
+  std::string getString(const Token& token) const;
+  uint64_t getInteger(const Token& token) const;
+
+  template <typename T>
+  bool getNumber(common::StringView name, T& v) {
+    const Token* token = getValue(name);
+    if (token == nullptr) {
+      return false;
+    }
+
+    v = static_cast<T>(getInteger(*token));
+    return true;
+  }
+};
+
+}
@@ -0,0 +1,217 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonOutputBufferSerializer.h"
+
+#include <cassert>
+#include <cstdio>
+
+#include "Common/StringTools.h"
+
+using namespace cn;
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+bool needsEscape(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+}
+
+JsonOutputBufferSerializer::JsonOutputBufferSerializer(std::string& buffer) : buffer(buffer) {
+  buffer += '{';
+  levels.push_back(Level{ false, true });
+}
+
+JsonOutputBufferSerializer::~JsonOutputBufferSerializer() {
+}
+
+ISerializer::SerializerType JsonOutputBufferSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+void JsonOutputBufferSerializer::finish() {
+  assert(levels.size() == 1);
+  buffer += '}';
+  levels.pop_back();
+}
+
+bool JsonOutputBufferSerializer::beginObject(common::StringView name) {
+  writeName(name);
+  buffer += '{';
+  levels.push_back(Level{ false, true });
+  return true;
+}
+
+void JsonOutputBufferSerializer::endObject() {
+  assert(levels.size() > 1 && !levels.back().isArray);
+  buffer += '}';
+  levels.pop_back();
+}
+
+bool JsonOutputBufferSerializer::beginArray(size_t& size, common::StringView name) {
+  writeName(name);
+  buffer += '[';
+  levels.push_back(Level{ true, true });
+  return true;
+}
+
+void JsonOutputBufferSerializer::endArray() {
+  assert(levels.size() > 1 && levels.back().isArray);
+  buffer += ']';
+  levels.pop_back();
+}
+
+bool JsonOutputBufferSerializer::operator()(uint8_t& value, common::StringView name) {
+  writeName(name);
+  writeUnsigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int16_t& value, common::StringView name) {
+  writeName(name);
+  writeSigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint16_t& value, common::StringView name) {
+  writeName(name);
+  writeUnsigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int32_t& value, common::StringView name) {
+  writeName(name);
+  writeSigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint32_t& value, common::StringView name) {
+  writeName(name);
+  writeUnsigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(int64_t& value, common::StringView name) {
+  writeName(name);
+  writeSigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(uint64_t& value, common::StringView name) {
+  writeName(name);
+  writeUnsigned(value);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(double& value, common::StringView name) {
+  writeName(name);
+  char text[512];
+  int size = snprintf(text, sizeof(text), "%.11f", value);
+  if (size < 0 || static_cast<size_t>(size) >= sizeof(text)) {
+    buffer += std::to_string(value);
+    return true;
+  }
+
+  while (size > 1 && text[size - 2] != '.' && text[size - 1] == '0') {
+    --size;
+  }
+
+  buffer.append(text, size);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(bool& value, common::StringView name) {
+  writeName(name);
+  buffer += value ? "true" : "false";
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(std::string& value, common::StringView name) {
+  writeName(name);
+  writeString(value.data(), value.size());
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(void* value, size_t size, common::StringView name) {
+  writeName(name);
+  buffer += '"';
+  common::toHex(value, size, buffer);
+  buffer += '"';
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(std::string& value, common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void JsonOutputBufferSerializer::writeName(common::StringView name) {
+  assert(!levels.empty());
+  Level& level = levels.back();
+  if (!level.isEmpty) {
+    buffer += ',';
+  }
+
+  level.isEmpty = false;
+  if (!level.isArray) {
+    writeString(name.getData(), name.getSize());
+    buffer += ':';
+  }
+}
+
+void JsonOutputBufferSerializer::writeString(const char* data, size_t size) {
+  buffer += '"';
+  size_t start = 0;
+  for (size_t i = 0; i < size; ++i) {
+    char c = data[i];
+    if (!needsEscape(c)) {
+      continue;
+    }
+
+    buffer.append(data + start, i - start);
+    start = i + 1;
+    buffer += '\\';
+    switch (c) {
+    case '"': buffer += '"'; break;
+    case '\\': buffer += '\\'; break;
+    case '\b': buffer += 'b'; break;
+    case '\f': buffer += 'f'; break;
+    case '\n': buffer += 'n'; break;
+    case '\r': buffer += 'r'; break;
+    case '\t': buffer += 't'; break;
+    default:
+      buffer += "u00";
+      buffer += HEX_DIGITS[static_cast<unsigned char>(c) >> 4];
+      buffer += HEX_DIGITS[c & 0xf];
+      break;
+    }
+  }
+
+  buffer.append(data + start, size - start);
+  buffer += '"';
+}
+
+void JsonOutputBufferSerializer::writeUnsigned(uint64_t value) {
+  char text[20];
+  char* end = text + sizeof(text);
+  char* begin = end;
+  do {
+    *--begin = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  buffer.append(begin, end);
+}
+
+void JsonOutputBufferSerializer::writeSigned(int64_t value) {
+  if (value < 0) {
+    buffer += '-';
+    writeUnsigned(0 - static_cast<uint64_t>(value));
+  } else {
+    writeUnsigned(static_cast<uint64_t>(value));
+  }
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "ISerializer.h"
+
+namespace cn {
+
+// Serializes straight into a JSON text, without building a JsonValue tree first. Members come out
+// in the order they are serialized rather than sorted by name. Numbers and doubles are formatted
+// as JsonValue does, except that uint64_t values are not wrapped into negative numbers, and strings
+// are escaped as the JSON standard requires.
+class JsonOutputBufferSerializer : public ISerializer {
+public:
+  // Opens the top level object, the text is appended to buffer
+  JsonOutputBufferSerializer(std::string& buffer);
+  virtual ~JsonOutputBufferSerializer();
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, common::StringView name) override;
+  virtual bool operator()(int16_t& value, common::StringView name) override;
+  virtual bool operator()(uint16_t& value, common::StringView name) override;
+  virtual bool operator()(int32_t& value, common::StringView name) override;
+  virtual bool operator()(uint32_t& value, common::StringView name) override;
+  virtual bool operator()(int64_t& value, common::StringView name) override;
+  virtual bool operator()(uint64_t& value, common::StringView name) override;
+  virtual bool operator()(double& value, common::StringView name) override;
+  virtual bool operator()(bool& value, common::StringView name) override;
+  virtual bool operator()(std::string& value, common::StringView name) override;
+  virtual bool binary(void* value, size_t size, common::StringView name) override;
+  virtual bool binary(std::string& value, common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // Closes the top level object, once everything has been serialized into it
+  void finish();
+
+private:
+  struct Level {
+    bool isArray;
+    bool isEmpty;
+  };
+
+  std::string& buffer;
+  std::vector<Level> levels;
+
+  void writeName(common::StringView name);
+  void writeString(const char* data, size_t size);
+  void writeUnsigned(uint64_t value);
+  void writeSigned(int64_t value);
+};
+
+}
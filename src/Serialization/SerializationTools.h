@@ -10,7 +10,9 @@
 #include <vector>
 #include <Common/MemoryInputStream.h>
 #include <Common/StringOutputStream.h>
+#include "JsonInputBufferSerializer.h"
 #include "JsonInputStreamSerializer.h"
+#include "JsonOutputBufferSerializer.h"
 #include "JsonOutputStreamSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
@@ -80,17 +82,55 @@ void loadFromJsonValue(std::list<T>& v, const common::JsonValue& js) {
 
 template <typename T>
 std::string storeToJson(const T& v) {
-  return storeToJsonValue(v).toString();
+  std::string json;
+  JsonOutputBufferSerializer s(json);
+  serialize(const_cast<T&>(v), s);
+  s.finish();
+  return json;
 }
 
+template <typename T>
+std::string storeToJson(const std::vector<T>& v) { return storeToJsonValue(v).toString(); }
+
+template <typename T>
+std::string storeToJson(const std::list<T>& v) { return storeToJsonValue(v).toString(); }
+
+inline std::string storeToJson(const std::string& v) { return storeToJsonValue(v).toString(); }
+
 template <typename T>
 bool loadFromJson(T& v, const std::string& buf) {
   try {
     if (buf.empty()) {
       return true;
     }
-    auto js = common::JsonValue::fromString(buf);
-    loadFromJsonValue(v, js);
+    JsonInputBufferSerializer s(buf);
+    serialize(v, s);
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool loadFromJson(std::vector<T>& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    loadFromJsonValue(v, common::JsonValue::fromString(buf));
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool loadFromJson(std::list<T>& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    loadFromJsonValue(v, common::JsonValue::fromString(buf));
   } catch (std::exception&) {
     return false;
   }
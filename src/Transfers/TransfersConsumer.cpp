@@ -12,7 +12,6 @@
 
 #include "CommonTypes.h"
 #include "Common/StringTools.h"
-#include "Common/BlockingQueue.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/TransactionApi.h"
 #include "CryptoNoteCore/TransactionExtra.h"
@@ -33,64 +32,6 @@ namespace {
 
 using namespace cn;
 
-void checkOutputKey(
-  const KeyDerivation& derivation,
-  const PublicKey& key,
-  size_t keyIndex,
-  size_t outputIndex,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
-
-  PublicKey spendKey;
-  underive_public_key(derivation, keyIndex, key, spendKey);
-
-  if (spendKeys.find(spendKey) != spendKeys.end()) {
-    outputs[spendKey].push_back(static_cast<uint32_t>(outputIndex));
-  }
-
-}
-
-void findMyOutputs(
-  const ITransactionReader& tx,
-  const SecretKey& viewSecretKey,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
-
-  auto txPublicKey = tx.getTransactionPublicKey();
-  KeyDerivation derivation;
-
-  if (!generate_key_derivation( txPublicKey, viewSecretKey, derivation)) {
-    return;
-  }
-
-  size_t keyIndex = 0;
-  size_t outputCount = tx.getOutputCount();
-
-  for (size_t idx = 0; idx < outputCount; ++idx) {
-
-    auto outType = tx.getOutputType(size_t(idx));
-
-    if (outType == transaction_types::OutputType::Key) {
-
-      uint64_t amount;
-      KeyOutput out;
-      tx.getOutput(idx, out, amount);
-      checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
-      ++keyIndex;
-
-    } else if (outType == transaction_types::OutputType::Multisignature) {
-
-      uint64_t amount;
-      MultisignatureOutput out;
-      tx.getOutput(idx, out, amount);
-      for (const auto& key : out.keys) {
-        checkOutputKey(derivation, key, idx, idx, spendKeys, outputs);
-        ++keyIndex;
-     }
-    }
-  }
-}
-
 std::vector<crypto::Hash> getBlockHashes(const cn::CompleteBlock* blocks, size_t count) {
   std::vector<crypto::Hash> result;
   result.reserve(count);
@@ -106,11 +47,17 @@ std::vector<crypto::Hash> getBlockHashes(const cn::CompleteBlock* blocks, size_t
 
 namespace cn {
 
-TransfersConsumer::TransfersConsumer(const cn::Currency& currency, INode& node, logging::ILogger& logger, const SecretKey& viewSecret) :
-  m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer") {
+TransfersConsumer::TransfersConsumer(const cn::Currency& currency, INode& node, logging::ILogger& logger, const SecretKey& viewSecret,
+  TransfersScanner* scanner) :
+  m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer"),
+  m_ownScanner(scanner == nullptr ? new TransfersScanner(logger) : nullptr), m_scanner(scanner == nullptr ? *m_ownScanner : *scanner) {
   updateSyncStart();
 }
 
+TransfersConsumer::~TransfersConsumer() {
+  m_scanner.removeAccount(m_viewSecret);
+}
+
 ITransfersSubscription& TransfersConsumer::addSubscription(const AccountSubscription& subscription) {
   if (subscription.keys.viewSecretKey != m_viewSecret) {
     throw std::runtime_error("TransfersConsumer: view secret key mismatch");
@@ -171,6 +118,7 @@ void TransfersConsumer::updateSyncStart() {
   }
 
   m_syncStart = start;
+  m_scanner.setAccount(m_viewSecret, m_spendKeys, m_syncStart.timestamp);
 }
 
 SynchronizationStart TransfersConsumer::getSyncStart() {
@@ -189,106 +137,91 @@ bool TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t startH
   assert(blocks);
   assert(count > 0);
 
-  struct Tx {
+  struct PreprocessedTx : PreprocessInfo {
     TransactionBlockInfo blockInfo;
     const ITransactionReader* tx;
+    TransfersScanner::OutputsBySpendKey ownOutputs;
   };
 
-  struct PreprocessedTx : Tx, PreprocessInfo {};
-
+  // in chain order: by block height and transaction index in block
   std::vector<PreprocessedTx> preprocessedTransactions;
-  std::mutex preprocessedTransactionsMutex;
-
-  size_t workers = std::thread::hardware_concurrency();
-  if (workers == 0) {
-    workers = 2;
-  }
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
+  for (uint32_t i = 0; i < count; ++i) {
+    const auto& block = blocks[i].block;
 
-  std::atomic<bool> stopProcessing(false);
+    if (!block.is_initialized()) {
+      continue;
+    }
 
-  auto pushingThread = std::async(std::launch::async, [&] {
-    for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
-      const auto& block = blocks[i].block;
+    // filter by syncStartTimestamp
+    if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+      continue;
+    }
 
-      if (!block.is_initialized()) {
-        continue;
-      }
+    TransactionBlockInfo blockInfo;
+    blockInfo.height = startHeight + i;
+    blockInfo.timestamp = block->timestamp;
+    blockInfo.transactionIndex = 0; // position in block
 
-      // filter by syncStartTimestamp
-      if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp) {
+    for (const auto& tx : blocks[i].transactions) {
+      auto pubKey = tx->getTransactionPublicKey();
+      if (pubKey == NULL_PUBLIC_KEY) {
+        ++blockInfo.transactionIndex;
         continue;
       }
 
-      TransactionBlockInfo blockInfo;
-      blockInfo.height = startHeight + i;
-      blockInfo.timestamp = block->timestamp;
-      blockInfo.transactionIndex = 0; // position in block
-
-      for (const auto& tx : blocks[i].transactions) {
-        auto pubKey = tx->getTransactionPublicKey();
-        if (pubKey == NULL_PUBLIC_KEY) {
-          ++blockInfo.transactionIndex;
-          continue;
-        }
-
-        Tx item = { blockInfo, tx.get() };
-        inputQueue.push(item);
-        ++blockInfo.transactionIndex;
-      }
+      preprocessedTransactions.emplace_back();
+      preprocessedTransactions.back().blockInfo = blockInfo;
+      preprocessedTransactions.back().tx = tx.get();
+      ++blockInfo.transactionIndex;
     }
+  }
 
-    inputQueue.close();
-  });
+  std::error_code processingError;
+  try {
+    // the scan covers the filtered blocks too, they are left out for this view key
+    auto it = preprocessedTransactions.begin();
+    for (auto& found : m_scanner.scanBlocks(m_viewSecret, blocks, startHeight, count)) {
+      uint32_t height = startHeight + found.blockOffset;
+      while (it != preprocessedTransactions.end() &&
+        std::tie(it->blockInfo.height, it->blockInfo.transactionIndex) < std::tie(height, found.transactionIndex)) {
+        ++it;
+      }
 
-  auto processingFunction = [&] {
-    Tx item;
-    std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
-
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
-      if (ec) {
-        stopProcessing = true;
-        break;
+      if (it != preprocessedTransactions.end() && it->blockInfo.height == height && it->blockInfo.transactionIndex == found.transactionIndex) {
+        it->ownOutputs = std::move(found.outputs);
       }
+    }
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to scan blocks: " << e.what();
+    processingError = std::make_error_code(std::errc::operation_canceled);
+  }
 
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
+  // one request for the global indices of every transaction that pays us
+  std::vector<PreprocessedTx*> ownTransactions;
+  std::vector<crypto::Hash> ownTransactionHashes;
+  for (auto& tx : preprocessedTransactions) {
+    if (!tx.ownOutputs.empty()) {
+      ownTransactions.push_back(&tx);
+      ownTransactionHashes.push_back(tx.tx->getTransactionHash());
     }
-    return ec;
-  };
+  }
 
-  std::vector<std::future<std::error_code>> processingThreads;
-  for (size_t i = 0; i < workers; ++i) {
-    processingThreads.push_back(std::async(std::launch::async, processingFunction));
+  std::vector<std::vector<uint32_t>> globalIndices;
+  if (!processingError && !ownTransactionHashes.empty()) {
+    processingError = getGlobalIndices(ownTransactionHashes, globalIndices);
   }
 
-  std::error_code processingError;
-  for (auto& f : processingThreads) {
-    try {
-      std::error_code ec = f.get();
-      if (!processingError && ec) {
-        processingError = ec;
-      }
-    } catch (const std::system_error& e) {
-      processingError = e.code();
-    } catch (const std::exception&) {
-      processingError = std::make_error_code(std::errc::operation_canceled);
-    }
+  for (size_t i = 0; i < ownTransactions.size() && !processingError; ++i) {
+    PreprocessedTx& tx = *ownTransactions[i];
+    tx.globalIdxs = std::move(globalIndices[i]);
+    processingError = createSubscriptionTransfers(tx.blockInfo, *tx.tx, tx.ownOutputs, tx);
   }
 
   std::vector<crypto::Hash> blockHashes = getBlockHashes(blocks, count);
   if (!processingError) {
     m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-    // sort by block height and transaction index in block
-    std::sort(preprocessedTransactions.begin(), preprocessedTransactions.end(), [](const PreprocessedTx& a, const PreprocessedTx& b) {
-      return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex) < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-    });
-
     for (const auto& tx : preprocessedTransactions) {
       processTransaction(tx.blockInfo, *tx.tx, tx);
     }
@@ -467,47 +400,47 @@ std::error_code createTransfers(
   return std::error_code();
 }
 
-std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
-  std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
-   try {
-    findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
-  }
-  catch (const std::exception& e) {
-    m_logger(ERROR, BRIGHT_RED) << "Failed to process transaction: " << e.what() << ", transaction hash " << common::podToHex(tx.getTransactionHash());
-    return std::error_code();
+std::error_code TransfersConsumer::createSubscriptionTransfers(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const TransfersScanner::OutputsBySpendKey& outputs, PreprocessInfo& info) {
+  std::error_code errorCode;
+  for (const auto& kv : outputs) {
+    auto it = m_subscriptions.find(kv.first);
+    if (it != m_subscriptions.end()) {
+      auto& transfers = info.outputs[kv.first];
+      try {
+        errorCode = createTransfers(it->second->getKeys(), blockInfo, tx, kv.second, info.globalIdxs, transfers);
+        if (errorCode) {
+          return errorCode;
+        }
+      }
+      catch (const std::exception& e) {
+        m_logger(ERROR, BRIGHT_RED) << "Failed to process transaction: " << e.what() << ", transaction hash " << common::podToHex(tx.getTransactionHash());
+        return std::error_code();
+      }
+    }
   }
-	
+
+  return std::error_code();
+}
+
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info) {
+  TransfersScanner::OutputsBySpendKey outputs;
+  m_scanner.findOutputs(tx, m_viewSecret, m_spendKeys, outputs);
   if (outputs.empty()) {
     return std::error_code();
   }
 
-  std::error_code errorCode;
-  auto txHash = tx.getTransactionHash();
   if (blockInfo.height != WALLET_UNCONFIRMED_TRANSACTION_HEIGHT) {
-    errorCode = getGlobalIndices(reinterpret_cast<const Hash&>(txHash), info.globalIdxs);
+    std::vector<std::vector<uint32_t>> globalIndices;
+    std::error_code errorCode = getGlobalIndices({ tx.getTransactionHash() }, globalIndices);
     if (errorCode) {
       return errorCode;
     }
-  }
 
-  for (const auto& kv : outputs) {
-    auto it = m_subscriptions.find(kv.first);
-    if (it != m_subscriptions.end()) {
-      auto& transfers = info.outputs[kv.first];
-       try {
-		  errorCode = createTransfers(it->second->getKeys(), blockInfo, tx, kv.second, info.globalIdxs, transfers);
-		  if (errorCode) {
-			  return errorCode;
-		  }
-	  }
-	  catch (const std::exception& e) {
-	    m_logger(ERROR, BRIGHT_RED) << "Failed to process transaction: " << e.what() << ", transaction hash " << common::podToHex(tx.getTransactionHash());
-		  return std::error_code();
-	  }
-    }
+    info.globalIdxs = std::move(globalIndices.front());
   }
 
-  return std::error_code();
+  return createSubscriptionTransfers(blockInfo, tx, outputs, info);
 }
 
 std::error_code TransfersConsumer::processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx) {
@@ -565,7 +498,7 @@ void TransfersConsumer::processOutputs(const TransactionBlockInfo& blockInfo, Tr
   }
 }
 
-std::error_code TransfersConsumer::getGlobalIndices(const Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices) {  
+std::error_code TransfersConsumer::getGlobalIndices(const std::vector<Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices) {
   std::promise<std::error_code> prom;
   std::future<std::error_code> f = prom.get_future();
 
@@ -575,9 +508,14 @@ std::error_code TransfersConsumer::getGlobalIndices(const Hash& transactionHash,
   };
 
   outsGlobalIndices.clear();
-  m_node.getTransactionOutsGlobalIndices(transactionHash, outsGlobalIndices, cb);
+  m_node.getTransactionsOutsGlobalIndices(transactionHashes, outsGlobalIndices, cb);
 
-  return f.get();
+  std::error_code ec = f.get();
+  if (!ec && outsGlobalIndices.size() != transactionHashes.size()) {
+    ec = std::make_error_code(std::errc::bad_message);
+  }
+
+  return ec;
 }
 
-}
\ No newline at end of file
+}
@@ -8,6 +8,7 @@
 
 #include "IBlockchainSynchronizer.h"
 #include "ITransfersSynchronizer.h"
+#include "TransfersScanner.h"
 #include "TransfersSubscription.h"
 #include "TypeHelpers.h"
 
@@ -16,6 +17,7 @@
 
 #include "IObservableImpl.h"
 
+#include <memory>
 #include <unordered_set>
 
 namespace cn {
@@ -25,7 +27,10 @@ class INode;
 class TransfersConsumer: public IObservableImpl<IBlockchainConsumerObserver, IBlockchainConsumer> {
 public:
 
-  TransfersConsumer(const cn::Currency& currency, INode& node, logging::ILogger& logger, const crypto::SecretKey& viewSecret);
+  // Without a scanner shared with other consumers the consumer scans the blocks on its own
+  TransfersConsumer(const cn::Currency& currency, INode& node, logging::ILogger& logger, const crypto::SecretKey& viewSecret,
+    TransfersScanner* scanner = nullptr);
+  virtual ~TransfersConsumer();
 
   ITransfersSubscription& addSubscription(const AccountSubscription& subscription);
   // returns true if no subscribers left
@@ -60,13 +65,15 @@ private:
     std::vector<uint32_t> globalIdxs;
   };
 
+  std::error_code createSubscriptionTransfers(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+    const TransfersScanner::OutputsBySpendKey& outputs, PreprocessInfo& info);
   std::error_code preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, PreprocessInfo& info);
   std::error_code processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx);
   void processTransaction(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx, const PreprocessInfo& info);
   void processOutputs(const TransactionBlockInfo& blockInfo, TransfersSubscription& sub, const ITransactionReader& tx,
     const std::vector<TransactionOutputInformationIn>& outputs, const std::vector<uint32_t>& globalIdxs, bool& contains, bool& updated);
 
-  std::error_code getGlobalIndices(const crypto::Hash& transactionHash, std::vector<uint32_t>& outsGlobalIndices);
+  std::error_code getGlobalIndices(const std::vector<crypto::Hash>& transactionHashes, std::vector<std::vector<uint32_t>>& outsGlobalIndices);
 
   void updateSyncStart();
 
@@ -80,6 +87,8 @@ private:
   INode& m_node;
   const cn::Currency& m_currency;
   logging::LoggerRef m_logger;
+  std::unique_ptr<TransfersScanner> m_ownScanner;
+  TransfersScanner& m_scanner;
 };
 
 }
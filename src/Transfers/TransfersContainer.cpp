@@ -181,6 +181,8 @@ size_t SpentOutputDescriptor::hash() const {
 
 
 TransfersContainer::TransfersContainer(const Currency& currency, size_t transactionSpendableAge) :
+  m_lockedDepositsBalance(0),
+  m_unlockedDepositsBalance(0),
   m_currentHeight(0),
   m_currency(currency),
   m_transactionSpendableAge(transactionSpendableAge) {
@@ -273,8 +275,8 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
 
     if (transferIsUnconfirmed) {
       auto result = m_unconfirmedTransfers.emplace(std::move(info));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addDeposit(*result.first);
     } else {
       if (info.type == transaction_types::OutputType::Multisignature) {
         SpentOutputDescriptor descriptor(transfer);
@@ -287,8 +289,8 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
       addUnlockJob(info);
 
       auto result = m_availableTransfers.emplace(std::move(info));
-      (void)result; // Disable unused warning
       assert(result.second);
+      addDeposit(*result.first);
     }
 
     if (info.type == transaction_types::OutputType::Key) {
@@ -361,6 +363,7 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       auto availableOutputIt = outputDescriptorIndex.find(SpentOutputDescriptor(input.amount, input.outputIndex));
       if (availableOutputIt != outputDescriptorIndex.end()) {
         deleteUnlockJob(*availableOutputIt);
+        deleteDeposit(*availableOutputIt);
         copyToSpent(block, tx, i, *availableOutputIt);
         // erase from available outputs
         outputDescriptorIndex.erase(availableOutputIt);
@@ -421,6 +424,7 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
       throw std::invalid_argument("Not enough elements in globalIndices");
     }
 
+    deleteDeposit(*transferIt);
     transfer.blockHeight = block.height;
     transfer.transactionIndex = block.transactionIndex;
     transfer.globalOutputIndex = globalIndices[transfer.outputInTransaction];
@@ -437,8 +441,8 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     addUnlockJob(transfer);
 
     auto result = m_availableTransfers.emplace(std::move(transfer));
-    (void)result; // Disable unused warning
     assert(result.second);
+    addDeposit(*result.first);
 
     transferIt = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(transferIt);
 
@@ -475,6 +479,7 @@ void TransfersContainer::deleteTransactionTransfers(const crypto::Hash& transact
     addUnlockJob(unspendingTransfer);
     auto result = m_availableTransfers.emplace(unspendingTransfer);
     assert(result.second);
+    addDeposit(*result.first);
     it = spendingTransactionIndex.erase(it);
 
     if (result.first->type == transaction_types::OutputType::Key) {
@@ -484,6 +489,7 @@ void TransfersContainer::deleteTransactionTransfers(const crypto::Hash& transact
 
   auto unconfirmedTransfersRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
   for (auto it = unconfirmedTransfersRange.first; it != unconfirmedTransfersRange.second;) {
+    deleteDeposit(*it);
     if (it->type == transaction_types::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
       it = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(it);
@@ -497,6 +503,7 @@ void TransfersContainer::deleteTransactionTransfers(const crypto::Hash& transact
   auto transactionTransfersRange = transactionTransfersIndex.equal_range(transactionHash);
   for (auto it = transactionTransfersRange.first; it != transactionTransfersRange.second;) {
     deleteUnlockJob(*it);
+    deleteDeposit(*it);
 
     if (it->type == transaction_types::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
@@ -564,6 +571,7 @@ void TransfersContainer::detach(uint32_t height, std::vector<crypto::Hash>& dele
 
   // TODO: notification on detach
   m_currentHeight = height == 0 ? 0 : height - 1;
+  updateDepositsState(prevHeight, m_currentHeight);
 
   getLockingTransfers(prevHeight, m_currentHeight, deletedTransactions, lockedTransfers);
 }
@@ -632,6 +640,7 @@ std::vector<TransactionOutputInformation> TransfersContainer::doAdvanceHeight(ui
 
   uint32_t prevHeight = m_currentHeight;
   m_currentHeight = height;
+  updateDepositsState(prevHeight, m_currentHeight);
 
   return getUnlockingTransfers(prevHeight, m_currentHeight);
 }
@@ -667,6 +676,16 @@ uint64_t TransfersContainer::balance(uint32_t flags) const {
   return amount;
 }
 
+uint64_t TransfersContainer::lockedDepositsBalance() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_lockedDepositsBalance;
+}
+
+uint64_t TransfersContainer::unlockedDepositsBalance() const {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_unlockedDepositsBalance;
+}
+
 void TransfersContainer::getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags) const {
   std::lock_guard<std::mutex> lk(m_mutex);
   for (const auto& t : m_availableTransfers) {
@@ -904,6 +923,7 @@ void TransfersContainer::load(std::istream& in) {
   m_availableTransfers = std::move(availableTransfers);
   m_spentTransfers = std::move(spentTransfers);
   m_transfersUnlockJobs = std::move(transfersUnlockJobs);
+  rebuildDeposits();
 }
 
 void TransfersContainer::rebuildTransfersUnlockJobs(TransfersUnlockMultiIndex& transfersUnlockJobs, const AvailableTransfersMultiIndex& availableTransfers,
@@ -1041,6 +1061,104 @@ void TransfersContainer::getLockingTransfers(uint32_t prevHeight, uint32_t curre
   }
 }
 
+/**
+ *  \pre m_mutex is locked
+ */
+uint64_t TransfersContainer::getDepositAmount(const TransactionOutputInformationEx& output) const {
+  return output.amount + m_currency.calculateInterest(output.amount, output.term, output.blockHeight);
+}
+
+/**
+ *  A deposit is unlocked from the height its unlock job fires, unconfirmed deposits are locked.
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::addDeposit(const TransactionOutputInformationEx& output) {
+  if (output.type != transaction_types::OutputType::Multisignature || output.term == 0) {
+    return;
+  }
+
+  uint64_t amount = getDepositAmount(output);
+  if (output.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
+    m_lockedDepositsBalance += amount;
+    return;
+  }
+
+  uint32_t unlockHeight = makeTransferUnlockJob(output, static_cast<uint32_t>(m_transactionSpendableAge)).unlockHeight;
+  m_depositUnlockHeights.emplace(unlockHeight, amount);
+  if (unlockHeight <= m_currentHeight + 1) {
+    m_unlockedDepositsBalance += amount;
+  } else {
+    m_lockedDepositsBalance += amount;
+  }
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::deleteDeposit(const TransactionOutputInformationEx& output) {
+  if (output.type != transaction_types::OutputType::Multisignature || output.term == 0) {
+    return;
+  }
+
+  uint64_t amount = getDepositAmount(output);
+  if (output.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
+    m_lockedDepositsBalance -= amount;
+    return;
+  }
+
+  uint32_t unlockHeight = makeTransferUnlockJob(output, static_cast<uint32_t>(m_transactionSpendableAge)).unlockHeight;
+  auto range = m_depositUnlockHeights.equal_range(unlockHeight);
+  auto it = std::find_if(range.first, range.second, [amount](const std::pair<const uint32_t, uint64_t>& deposit) {
+    return deposit.second == amount;
+  });
+
+  assert(it != range.second);
+  m_depositUnlockHeights.erase(it);
+  if (unlockHeight <= m_currentHeight + 1) {
+    m_unlockedDepositsBalance -= amount;
+  } else {
+    m_lockedDepositsBalance -= amount;
+  }
+}
+
+/**
+ *  Moves the deposits whose unlock height was passed in either direction
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::updateDepositsState(uint32_t prevHeight, uint32_t currentHeight) {
+  auto begin = m_depositUnlockHeights.upper_bound(std::min(prevHeight, currentHeight) + 1);
+  auto end = m_depositUnlockHeights.upper_bound(std::max(prevHeight, currentHeight) + 1);
+  uint64_t amount = 0;
+  for (auto it = begin; it != end; ++it) {
+    amount += it->second;
+  }
+
+  if (currentHeight > prevHeight) {
+    m_lockedDepositsBalance -= amount;
+    m_unlockedDepositsBalance += amount;
+  } else {
+    m_unlockedDepositsBalance -= amount;
+    m_lockedDepositsBalance += amount;
+  }
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::rebuildDeposits() {
+  m_depositUnlockHeights.clear();
+  m_lockedDepositsBalance = 0;
+  m_unlockedDepositsBalance = 0;
+
+  for (const auto& output : m_unconfirmedTransfers) {
+    addDeposit(output);
+  }
+
+  for (const auto& output : m_availableTransfers) {
+    addDeposit(output);
+  }
+}
+
 /**
  *  \pre m_mutex is locked
  *  \pre requested output must exist
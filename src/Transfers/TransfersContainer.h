@@ -7,6 +7,7 @@
 #pragma once
 
 #include <cstdint>
+#include <map>
 #include <unordered_map>
 #include <mutex>
 
@@ -201,6 +202,8 @@ public:
   virtual size_t transfersCount() const override;
   virtual size_t transactionsCount() const override;
   virtual uint64_t balance(uint32_t flags) const override;
+  virtual uint64_t lockedDepositsBalance() const override;
+  virtual uint64_t unlockedDepositsBalance() const override;
   virtual void getOutputs(std::vector<TransactionOutputInformation>& transfers, uint32_t flags) const override;
   virtual bool getTransactionInformation(const crypto::Hash& transactionHash, TransactionInformation& info,
     uint64_t* amountIn = nullptr, uint64_t* amountOut = nullptr) const override;
@@ -362,12 +365,22 @@ private:
                                   const SpentTransfersMultiIndex& spentTransfers);
   std::vector<TransactionOutputInformation> doAdvanceHeight(uint32_t height);
 
+  uint64_t getDepositAmount(const TransactionOutputInformationEx& output) const;
+  void addDeposit(const TransactionOutputInformationEx& output);
+  void deleteDeposit(const TransactionOutputInformationEx& output);
+  void updateDepositsState(uint32_t prevHeight, uint32_t currentHeight);
+  void rebuildDeposits();
+
 private:
   TransactionMultiIndex m_transactions;
   UnconfirmedTransfersMultiIndex m_unconfirmedTransfers;
   AvailableTransfersMultiIndex m_availableTransfers;
   SpentTransfersMultiIndex m_spentTransfers;
   TransfersUnlockMultiIndex m_transfersUnlockJobs;
+  // unlock height -> amount with interest, for every available deposit
+  std::multimap<uint32_t, uint64_t> m_depositUnlockHeights;
+  uint64_t m_lockedDepositsBalance;
+  uint64_t m_unlockedDepositsBalance;
   //std::unordered_map<KeyImage, KeyOutputInfo, boost::hash<KeyImage>> m_keyImages;
 
   uint32_t m_currentHeight; // current height is needed to check if a transfer is unlocked
@@ -0,0 +1,302 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "TransfersScanner.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "CommonTypes.h"
+#include "Common/StringTools.h"
+#include "Common/ThreadPool.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+
+using namespace crypto;
+using namespace logging;
+
+namespace {
+
+// One work item checks a transaction against this many accounts
+const size_t ACCOUNTS_PER_ITEM = 64;
+
+// Output scanning is pure CPU work, one pool serves every scanner in the process. The thread that
+// asks for the scan takes part in the job, so it is one thread less than the cores.
+common::ThreadPool& getScanPool() {
+  static common::ThreadPool pool(std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+  return pool;
+}
+
+}
+
+namespace cn {
+
+TransfersScanner::TransfersScanner(logging::ILogger& logger) : m_logger(logger, "TransfersScanner"), m_scannedHeight(0) {
+}
+
+void TransfersScanner::setAccount(const SecretKey& viewSecret, const std::unordered_set<PublicKey>& spendKeys, uint64_t syncStartTimestamp) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = findAccount(viewSecret);
+  if (it == m_accounts.end()) {
+    it = m_accounts.insert(m_accounts.end(), Account());
+    it->viewSecret = viewSecret;
+    // until the consumer asks, it is taken to need every block
+    it->nextHeight = 0;
+  }
+
+  it->spendKeys = spendKeys;
+  it->syncStartTimestamp = syncStartTimestamp;
+  m_scannedBlocks.clear();
+}
+
+void TransfersScanner::removeAccount(const SecretKey& viewSecret) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = findAccount(viewSecret);
+  if (it != m_accounts.end()) {
+    m_accounts.erase(it);
+    m_scannedBlocks.clear();
+  }
+}
+
+std::vector<TransfersScanner::TransactionOutputs> TransfersScanner::scanBlocks(const SecretKey& viewSecret, const CompleteBlock* blocks,
+  uint32_t startHeight, uint32_t count) {
+  assert(count > 0);
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = findAccount(viewSecret);
+  if (it == m_accounts.end()) {
+    throw std::runtime_error("TransfersScanner: view secret key is not registered");
+  }
+
+  size_t account = static_cast<size_t>(std::distance(m_accounts.begin(), it));
+  updateScannedBlocks(blocks, startHeight, count);
+
+  if (it->scannedHeight > startHeight) {
+    // The accounts whose consumers are behind ask for these blocks next, they are checked in the
+    // same job. The ones that are further on are left out.
+    std::vector<ScanRange> ranges;
+    for (size_t i = 0; i < m_accounts.size(); ++i) {
+      uint32_t beginHeight = i == account ? startHeight : std::max(startHeight, m_accounts[i].nextHeight);
+      if (beginHeight < m_accounts[i].scannedHeight) {
+        ranges.push_back({ i, beginHeight, m_accounts[i].scannedHeight });
+      }
+    }
+
+    scan(blocks, startHeight, count, ranges);
+    for (const auto& range : ranges) {
+      m_accounts[range.account].scannedHeight = range.beginHeight;
+    }
+  }
+
+  it->nextHeight = startHeight + count;
+
+  std::vector<TransactionOutputs> result;
+  size_t firstBlock = startHeight - m_scannedHeight;
+  for (uint32_t i = 0; i < count; ++i) {
+    for (const auto& accountOutputs : m_scannedBlocks[firstBlock + i].outputs) {
+      if (accountOutputs.account == account) {
+        result.push_back({ i, accountOutputs.transactionIndex, accountOutputs.outputs });
+      }
+    }
+  }
+
+  return result;
+}
+
+void TransfersScanner::findOutputs(const ITransactionReader& tx, const SecretKey& viewSecret, const std::unordered_set<PublicKey>& spendKeys,
+  OutputsBySpendKey& outputs) const {
+  KeyDerivation derivation;
+  if (!generate_key_derivation(tx.getTransactionPublicKey(), viewSecret, derivation)) {
+    return;
+  }
+
+  std::vector<OutputKey> keys;
+  if (getOutputKeys(tx, keys)) {
+    checkOutputKeys(derivation, keys, spendKeys, outputs);
+  }
+}
+
+std::vector<TransfersScanner::Account>::iterator TransfersScanner::findAccount(const SecretKey& viewSecret) {
+  return std::find_if(m_accounts.begin(), m_accounts.end(), [&viewSecret](const Account& account) {
+    return account.viewSecret == viewSecret;
+  });
+}
+
+/// \pre m_mutex is locked
+void TransfersScanner::updateScannedBlocks(const CompleteBlock* blocks, uint32_t startHeight, uint32_t count) {
+  // The synchronizer hands each consumer a tail of the same batch, the run is extended to the
+  // front when a consumer is further behind than the ones before it
+  uint32_t endHeight = startHeight + count;
+  if (!m_scannedBlocks.empty() && m_scannedHeight + m_scannedBlocks.size() == endHeight &&
+    m_scannedBlocks.back().blockHash == blocks[count - 1].blockHash) {
+    if (m_scannedHeight <= startHeight) {
+      if (m_scannedBlocks[startHeight - m_scannedHeight].blockHash == blocks[0].blockHash) {
+        return;
+      }
+    } else {
+      uint32_t missing = m_scannedHeight - startHeight;
+      if (m_scannedBlocks.front().blockHash == blocks[missing].blockHash) {
+        std::vector<ScannedBlock> front(missing);
+        for (uint32_t i = 0; i < missing; ++i) {
+          front[i].blockHash = blocks[i].blockHash;
+        }
+
+        m_scannedBlocks.insert(m_scannedBlocks.begin(), std::make_move_iterator(front.begin()), std::make_move_iterator(front.end()));
+        m_scannedHeight = startHeight;
+        return;
+      }
+    }
+  }
+
+  m_scannedBlocks.assign(count, ScannedBlock());
+  for (uint32_t i = 0; i < count; ++i) {
+    m_scannedBlocks[i].blockHash = blocks[i].blockHash;
+  }
+
+  m_scannedHeight = startHeight;
+  for (auto& account : m_accounts) {
+    account.scannedHeight = endHeight;
+  }
+}
+
+/// \pre m_mutex is locked
+void TransfersScanner::scan(const CompleteBlock* blocks, uint32_t startHeight, uint32_t count, const std::vector<ScanRange>& ranges) {
+  struct Transaction {
+    uint32_t height;
+    uint32_t transactionIndex;
+    const ITransactionReader* tx;
+    uint64_t timestamp;
+    std::vector<OutputKey> keys;
+  };
+
+  uint32_t beginHeight = startHeight + count;
+  uint32_t endHeight = startHeight;
+  for (const auto& range : ranges) {
+    beginHeight = std::min(beginHeight, range.beginHeight);
+    endHeight = std::max(endHeight, range.endHeight);
+  }
+
+  std::vector<Transaction> transactions;
+  for (uint32_t height = beginHeight; height < endHeight; ++height) {
+    const CompleteBlock& block = blocks[height - startHeight];
+    if (!block.block.is_initialized()) {
+      continue;
+    }
+
+    uint32_t transactionIndex = 0;
+    for (const auto& tx : block.transactions) {
+      if (tx->getTransactionPublicKey() != NULL_PUBLIC_KEY) {
+        transactions.push_back({ height, transactionIndex, tx.get(), block.block->timestamp, {} });
+      }
+
+      ++transactionIndex;
+    }
+  }
+
+  common::ThreadPool& pool = getScanPool();
+  pool.parallelFor(transactions.size(), [&](size_t i) {
+    if (!getOutputKeys(*transactions[i].tx, transactions[i].keys)) {
+      transactions[i].keys.clear();
+    }
+  });
+
+  size_t chunks = (ranges.size() + ACCOUNTS_PER_ITEM - 1) / ACCOUNTS_PER_ITEM;
+  std::vector<std::vector<AccountOutputs>> found(transactions.size() * chunks);
+  pool.parallelFor(found.size(), [&](size_t item) {
+    const Transaction& transaction = transactions[item / chunks];
+    if (transaction.keys.empty()) {
+      return;
+    }
+
+    size_t accounts[ACCOUNTS_PER_ITEM];
+    SecretKey viewSecrets[ACCOUNTS_PER_ITEM];
+    size_t accountCount = 0;
+    size_t begin = item % chunks * ACCOUNTS_PER_ITEM;
+    size_t end = std::min(begin + ACCOUNTS_PER_ITEM, ranges.size());
+    for (size_t i = begin; i < end; ++i) {
+      const ScanRange& range = ranges[i];
+      const Account& keys = m_accounts[range.account];
+      if (transaction.height >= range.beginHeight && transaction.height < range.endHeight && !keys.spendKeys.empty() &&
+        (!keys.syncStartTimestamp || transaction.timestamp >= keys.syncStartTimestamp)) {
+        accounts[accountCount] = range.account;
+        viewSecrets[accountCount] = keys.viewSecret;
+        ++accountCount;
+      }
+    }
+
+    // the transaction key and each output key are decoded once for the whole chunk
+    KeyDerivation derivations[ACCOUNTS_PER_ITEM];
+    if (accountCount == 0 || !generate_key_derivations(transaction.tx->getTransactionPublicKey(), viewSecrets, accountCount, derivations)) {
+      return;
+    }
+
+    std::vector<OutputsBySpendKey> outputs(accountCount);
+    PublicKey spendKeys[ACCOUNTS_PER_ITEM];
+    for (const auto& key : transaction.keys) {
+      if (!underive_public_keys(derivations, accountCount, key.derivationIndex, key.key, spendKeys)) {
+        continue;
+      }
+
+      for (size_t i = 0; i < accountCount; ++i) {
+        if (m_accounts[accounts[i]].spendKeys.count(spendKeys[i]) != 0) {
+          outputs[i][spendKeys[i]].push_back(key.outputIndex);
+        }
+      }
+    }
+
+    for (size_t i = 0; i < accountCount; ++i) {
+      if (!outputs[i].empty()) {
+        found[item].push_back({ transaction.transactionIndex, accounts[i], std::move(outputs[i]) });
+      }
+    }
+  });
+
+  for (size_t item = 0; item < found.size(); ++item) {
+    auto& outputs = m_scannedBlocks[transactions[item / chunks].height - m_scannedHeight].outputs;
+    std::move(found[item].begin(), found[item].end(), std::back_inserter(outputs));
+  }
+}
+
+bool TransfersScanner::getOutputKeys(const ITransactionReader& tx, std::vector<OutputKey>& keys) const {
+  try {
+    size_t keyIndex = 0;
+    size_t outputCount = tx.getOutputCount();
+    for (size_t idx = 0; idx < outputCount; ++idx) {
+      auto outType = tx.getOutputType(idx);
+      if (outType == transaction_types::OutputType::Key) {
+        uint64_t amount;
+        KeyOutput out;
+        tx.getOutput(idx, out, amount);
+        keys.push_back({ keyIndex, static_cast<uint32_t>(idx), out.key });
+        ++keyIndex;
+      } else if (outType == transaction_types::OutputType::Multisignature) {
+        uint64_t amount;
+        MultisignatureOutput out;
+        tx.getOutput(idx, out, amount);
+        for (const auto& key : out.keys) {
+          keys.push_back({ idx, static_cast<uint32_t>(idx), key });
+          ++keyIndex;
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to process transaction: " << e.what() << ", transaction hash " << common::podToHex(tx.getTransactionHash());
+    return false;
+  }
+
+  return true;
+}
+
+void TransfersScanner::checkOutputKeys(const KeyDerivation& derivation, const std::vector<OutputKey>& keys,
+  const std::unordered_set<PublicKey>& spendKeys, OutputsBySpendKey& outputs) {
+  for (const auto& key : keys) {
+    PublicKey spendKey;
+    underive_public_key(derivation, key.derivationIndex, key.key, spendKey);
+    if (spendKeys.find(spendKey) != spendKeys.end()) {
+      outputs[spendKey].push_back(key.outputIndex);
+    }
+  }
+}
+
+}
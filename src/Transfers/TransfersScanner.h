@@ -0,0 +1,99 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+//
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "Logging/LoggerRef.h"
+
+namespace cn {
+
+struct CompleteBlock;
+class ITransactionReader;
+
+// Finds the outputs of many view keys in the same blocks. Every registered view key is checked
+// against every transaction of a batch in one job on the scan pool, the outputs are read from the
+// transactions once for all of them. The results of the last batch are kept, so the consumers
+// called one after another with the same blocks only pick their part. A block is checked for a
+// view key only when its consumer asks for it or is known to be behind it.
+class TransfersScanner {
+public:
+  // spend public key -> indices of its outputs in the transaction
+  typedef std::unordered_map<crypto::PublicKey, std::vector<uint32_t>> OutputsBySpendKey;
+
+  struct TransactionOutputs {
+    uint32_t blockOffset; // from the first of the scanned blocks
+    uint32_t transactionIndex; // position in block
+    OutputsBySpendKey outputs;
+  };
+
+  explicit TransfersScanner(logging::ILogger& logger);
+
+  // Registers the view key or replaces its spend keys. Blocks older than syncStartTimestamp are not
+  // checked for it, as with the consumer's own filter.
+  void setAccount(const crypto::SecretKey& viewSecret, const std::unordered_set<crypto::PublicKey>& spendKeys, uint64_t syncStartTimestamp);
+  void removeAccount(const crypto::SecretKey& viewSecret);
+
+  // The transactions of blocks [0, count) with outputs of the view key, in chain order. The first
+  // block is at startHeight.
+  std::vector<TransactionOutputs> scanBlocks(const crypto::SecretKey& viewSecret, const CompleteBlock* blocks, uint32_t startHeight, uint32_t count);
+
+  // A single transaction for a single view key, for the pool
+  void findOutputs(const ITransactionReader& tx, const crypto::SecretKey& viewSecret, const std::unordered_set<crypto::PublicKey>& spendKeys,
+    OutputsBySpendKey& outputs) const;
+
+private:
+  struct Account {
+    crypto::SecretKey viewSecret;
+    std::unordered_set<crypto::PublicKey> spendKeys;
+    uint64_t syncStartTimestamp;
+    uint32_t scannedHeight; // the scanned blocks hold the results of the account from this height on
+    uint32_t nextHeight; // the consumer asked for the blocks below this height
+  };
+
+  struct ScanRange {
+    size_t account;
+    uint32_t beginHeight;
+    uint32_t endHeight;
+  };
+
+  struct AccountOutputs {
+    uint32_t transactionIndex;
+    size_t account;
+    OutputsBySpendKey outputs;
+  };
+
+  struct ScannedBlock {
+    crypto::Hash blockHash;
+    std::vector<AccountOutputs> outputs;
+  };
+
+  struct OutputKey {
+    size_t derivationIndex;
+    uint32_t outputIndex;
+    crypto::PublicKey key;
+  };
+
+  std::vector<Account>::iterator findAccount(const crypto::SecretKey& viewSecret);
+  void updateScannedBlocks(const CompleteBlock* blocks, uint32_t startHeight, uint32_t count);
+  void scan(const CompleteBlock* blocks, uint32_t startHeight, uint32_t count, const std::vector<ScanRange>& ranges);
+  bool getOutputKeys(const ITransactionReader& tx, std::vector<OutputKey>& keys) const;
+  static void checkOutputKeys(const crypto::KeyDerivation& derivation, const std::vector<OutputKey>& keys,
+    const std::unordered_set<crypto::PublicKey>& spendKeys, OutputsBySpendKey& outputs);
+
+  logging::LoggerRef m_logger;
+  std::mutex m_mutex;
+  std::vector<Account> m_accounts;
+  // results for a run of consecutive blocks from m_scannedHeight, dropped when an account changes
+  std::vector<ScannedBlock> m_scannedBlocks;
+  uint32_t m_scannedHeight;
+};
+
+}
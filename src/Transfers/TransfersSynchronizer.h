@@ -9,6 +9,7 @@
 #include "Common/ObserverManager.h"
 #include "ITransfersSynchronizer.h"
 #include "IBlockchainSynchronizer.h"
+#include "TransfersScanner.h"
 #include "TypeHelpers.h"
 
 #include <unordered_map>
@@ -50,6 +51,8 @@ public:
 
 private:
   logging::LoggerRef m_logger;
+  // shared by the consumers, outlives them
+  TransfersScanner m_scanner;
 
   // map { view public key -> consumer }
   typedef std::unordered_map<crypto::PublicKey, std::unique_ptr<TransfersConsumer>> ConsumersContainer;
@@ -59,17 +59,6 @@ std::vector<uint64_t> split(uint64_t amount, uint64_t dustThreshold)
   return amounts;
 }
 
-uint64_t calculateDepositsAmount(
-    const std::vector<cn::TransactionOutputInformation> &transfers,
-    const cn::Currency &currency,
-    const std::vector<uint32_t> heights)
-{
-  int index = 0;
-  return std::accumulate(transfers.begin(), transfers.end(), static_cast<uint64_t>(0), [&currency, &index, heights](uint64_t sum, const cn::TransactionOutputInformation &deposit) {
-    return sum + deposit.amount + currency.calculateInterest(deposit.amount, deposit.term, heights[index++]);
-  });
-}
-
 void asyncRequestCompletion(platform_system::Event& requestFinished) {
   requestFinished.set();
 }
@@ -3401,38 +3390,11 @@ void WalletGreen::updateBalance(cn::ITransfersContainer* container) {
 
   /* Update locked deposit balance, this will cover deposits, as well 
        as investments since they are all deposits with different parameters */
-    std::vector<TransactionOutputInformation> transfers2;
-    container->getOutputs(transfers2, ITransfersContainer::IncludeTypeDeposit | ITransfersContainer::IncludeStateLocked | ITransfersContainer::IncludeStateSoftLocked);
-
-    std::vector<uint32_t> heights2;
-    for (auto transfer2 : transfers2)
-    {
-      crypto::Hash hash2 = transfer2.transactionHash;
-      TransactionInformation info2;
-      bool ok2 = container->getTransactionInformation(hash2, info2, NULL, NULL);
-      if (ok2)
-      {
-        heights2.push_back(info2.blockHeight);
-        updated = true;
-      }
-    }
-    uint64_t locked = calculateDepositsAmount(transfers2, m_currency, heights2);
+    uint64_t locked = container->lockedDepositsBalance();
 
     /* This updates the unlocked deposit balance, these are the deposits that have matured
-       and can be withdrawn */
-    std::vector<TransactionOutputInformation> transfers;
-    container->getOutputs(transfers, ITransfersContainer::IncludeTypeDeposit | ITransfersContainer::IncludeStateUnlocked);
-
-    std::vector<uint32_t> heights;
-    for (auto transfer : transfers)
-    {
-      crypto::Hash hash = transfer.transactionHash;
-      TransactionInformation info;
-      bool ok = container->getTransactionInformation(hash, info, NULL, NULL);
-      assert(ok);
-      heights.push_back(info.blockHeight);
-    }
-    uint64_t unlocked = calculateDepositsAmount(transfers, m_currency, heights);
+       and can be withdrawn. The container keeps both sums up to date as its transfers change. */
+    uint64_t unlocked = container->unlockedDepositsBalance();
 
     /* Now do the same thing for overall deposit balances */
     if (it->lockedDepositBalance < locked)
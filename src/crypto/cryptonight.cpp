@@ -5,8 +5,83 @@
 
 #include "cryptonight.hpp"
 
+#include <boost/align/aligned_alloc.hpp>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 namespace crypto {
 
+namespace {
+
+// Huge page size the scratchpad is aligned to, so the whole of it fits on one such page
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+template<cryptonight_algo ALGO, size_t N>
+void cryptonight_hash_ways(cn_context *contexts, const void *const *data, const size_t *lengths, Hash *hashes) {
+	if(hw_check_aes())
+		cryptonight_hash_multi<true, ALGO, N>(data, lengths, hashes, contexts);
+	else
+		cryptonight_hash_multi<false, ALGO, N>(data, lengths, hashes, contexts);
+}
+
+template<cryptonight_algo ALGO>
+void cryptonight_hash_batch(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes,
+	void (*single)(cn_context &, const void *, size_t, Hash &)) {
+	size_t i = 0;
+	if(ALGO == CRYPTONIGHT_FAST_V8) {
+		// too short inputs hash to zeros, the single hash takes care of them
+		for(size_t j = 0; j < count; j++) {
+			if(lengths[j] < 43) {
+				for(; i < count; i++)
+					single(contexts[i], data[i], lengths[i], hashes[i]);
+				return;
+			}
+		}
+	}
+
+	for(; i + 4 <= count; i += 4)
+		cryptonight_hash_ways<ALGO, 4>(contexts + i, data + i, lengths + i, hashes + i);
+	for(; i + 2 <= count; i += 2)
+		cryptonight_hash_ways<ALGO, 2>(contexts + i, data + i, lengths + i, hashes + i);
+	for(; i < count; i++)
+		single(contexts[i], data[i], lengths[i], hashes[i]);
+}
+
+}
+
+cn_context::cn_context()
+{
+#if defined(__linux__)
+	void *mapped = mmap(nullptr, CN_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+	if(mapped != MAP_FAILED) {
+		long_state = static_cast<uint8_t*>(mapped);
+		long_state_mapped = true;
+	} else {
+		long_state = (uint8_t*)boost::alignment::aligned_alloc(HUGE_PAGE_SIZE, CN_PAGE_SIZE);
+		if(long_state != nullptr)
+			madvise(long_state, CN_PAGE_SIZE, MADV_HUGEPAGE);
+	}
+#else
+	long_state = (uint8_t*)boost::alignment::aligned_alloc(HUGE_PAGE_SIZE, CN_PAGE_SIZE);
+#endif
+
+	hash_state = (uint8_t*)boost::alignment::aligned_alloc(4096, 4096);
+}
+
+cn_context::~cn_context()
+{
+#if defined(__linux__)
+	if(long_state_mapped)
+		munmap(long_state, CN_PAGE_SIZE);
+	else
+#endif
+	if(long_state != nullptr)
+		boost::alignment::aligned_free(long_state);
+	if(hash_state != nullptr)
+		boost::alignment::aligned_free(hash_state);
+}
 
 void cn_slow_hash(cn_context &context, const void *data, size_t length, Hash &hash) {
 	if(hw_check_aes())
@@ -28,4 +103,16 @@ void cn_conceal_slow_hash_v0(cn_context &context, const void *data, size_t lengt
 	else
 		cryptonight_hash<false, CRYPTONIGHT_CONCEAL>(data, length, reinterpret_cast<char *>(&hash), context);
 }
-}
\ No newline at end of file
+
+void cn_slow_hash(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes) {
+	cryptonight_hash_batch<CRYPTONIGHT>(contexts, count, data, lengths, hashes, cn_slow_hash);
+}
+
+void cn_fast_slow_hash_v1(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes) {
+	cryptonight_hash_batch<CRYPTONIGHT_FAST_V8>(contexts, count, data, lengths, hashes, cn_fast_slow_hash_v1);
+}
+
+void cn_conceal_slow_hash_v0(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes) {
+	cryptonight_hash_batch<CRYPTONIGHT_CONCEAL>(contexts, count, data, lengths, hashes, cn_conceal_slow_hash_v0);
+}
+}
@@ -234,6 +234,25 @@ inline __m128 _mm_set1_ps_epi32(uint32_t x)
 	return _mm_castsi128_ps(_mm_set1_epi32(x));
 }
 
+inline void cryptonight_final_hash(const uint8_t* hash_state, uint8_t* output)
+{
+	switch(hash_state[0] & 3)
+	{
+	case 0:
+		blake256_hash(hash_state, output);
+		break;
+	case 1:
+		groestl_hash(hash_state, output);
+		break;
+	case 2:
+		jh_hash(hash_state, output);
+		break;
+	case 3:
+		skein_hash(hash_state, output);
+		break;
+	}
+}
+
 template<bool SOFT_AES, cryptonight_algo ALGO>
 void cryptonight_hash(const void* input, size_t len, void* output, cn_context& ctx0)
 {
@@ -332,21 +351,117 @@ void cryptonight_hash(const void* input, size_t len, void* output, cn_context& c
 
 	keccakf((uint64_t*)ctx0.hash_state, 24);
 
-	switch(ctx0.hash_state[0] & 3)
+	cryptonight_final_hash(ctx0.hash_state, (uint8_t*)output);
+}
+
+// Hashes N inputs with their main loops interleaved. Every iteration of one hash waits on the AES
+// round and the multiply of the previous one, the other hashes' steps are issued in the meantime.
+// Gives the same result as cryptonight_hash for each input.
+template<bool SOFT_AES, cryptonight_algo ALGO, size_t N>
+void cryptonight_hash_multi(const void* const* input, const size_t* len, Hash* output, cn_context* ctx)
+{
+	constexpr size_t MEMORY = cn_select_memory<ALGO>();
+	constexpr uint32_t MASK = cn_select_mask<ALGO>();
+	constexpr uint32_t ITER = cn_select_iter<ALGO>();
+	constexpr bool MONERO_TWEAK = ALGO == CRYPTONIGHT_FAST_V8;
+	constexpr bool CONC_VARIANT = ALGO == CRYPTONIGHT_CONCEAL;
+
+	uint8_t* l[N];
+	uint64_t al[N], ah[N], idx[N], mc[N];
+	__m128i bx[N];
+	__m128 conc_var[N];
+
+	for(size_t n = 0; n < N; n++)
 	{
-	case 0:
-		blake256_hash(ctx0.hash_state, (uint8_t*)output);
-		break;
-	case 1:
-		groestl_hash(ctx0.hash_state, (uint8_t*)output);
-		break;
-	case 2:
-		jh_hash(ctx0.hash_state, (uint8_t*)output);
-		break;
-	case 3:
-		skein_hash(ctx0.hash_state, (uint8_t*)output);
-		break;
+		keccak((const uint8_t *)input[n], static_cast<uint8_t>(len[n]), ctx[n].hash_state, 200);
+
+		const uint64_t* h = (const uint64_t*)ctx[n].hash_state;
+		if(MONERO_TWEAK)
+		{
+			mc[n]  =  *reinterpret_cast<const uint64_t*>(reinterpret_cast<const uint8_t*>(input[n]) + 35);
+			mc[n] ^=  h[24];
+		}
+
+		cn_explode_scratchpad<SOFT_AES, MEMORY, ALGO>((__m128i*)ctx[n].hash_state, (__m128i*)ctx[n].long_state);
+
+		l[n] = ctx[n].long_state;
+		al[n] = h[0] ^ h[4];
+		ah[n] = h[1] ^ h[5];
+		bx[n] = _mm_set_epi64x(h[3] ^ h[7], h[2] ^ h[6]);
+		conc_var[n] = _mm_setzero_ps();
+		idx[n] = al[n];
+	}
+
+	for(size_t i = 0; i < ITER; i++)
+	{
+		__m128i cx[N];
+		for(size_t n = 0; n < N; n++)
+		{
+			cx[n] = _mm_load_si128((__m128i *)&l[n][idx[n] & MASK]);
+
+			if(CONC_VARIANT)
+			{
+				__m128 r = _mm_cvtepi32_ps(cx[n]);
+				__m128 c_old = conc_var[n];
+				r = _mm_add_ps(r, conc_var[n]);
+				r = _mm_mul_ps(r, _mm_mul_ps(r, r));
+				r = _mm_and_ps(_mm_set1_ps_epi32(0x807FFFFF), r);
+				r = _mm_or_ps(_mm_set1_ps_epi32(0x40000000), r);
+				conc_var[n] = _mm_add_ps(conc_var[n], r);
+
+				c_old = _mm_and_ps(_mm_set1_ps_epi32(0x807FFFFF), c_old);
+				c_old = _mm_or_ps(_mm_set1_ps_epi32(0x40000000), c_old);
+				__m128 nc = _mm_mul_ps(c_old, _mm_set1_ps(536870880.0f));
+				cx[n] = _mm_xor_si128(cx[n], _mm_cvttps_epi32(nc));
+			}
+
+			if(SOFT_AES)
+				cx[n] = soft_aesenc(cx[n], _mm_set_epi64x(ah[n], al[n]));
+			else
+				cx[n] = _mm_aesenc_si128(cx[n], _mm_set_epi64x(ah[n], al[n]));
+		}
+
+		for(size_t n = 0; n < N; n++)
+		{
+			if(MONERO_TWEAK)
+				cryptonight_monero_tweak((uint64_t*)&l[n][idx[n] & MASK], _mm_xor_si128(bx[n], cx[n]));
+			else
+				_mm_store_si128((__m128i *)&l[n][idx[n] & MASK], _mm_xor_si128(bx[n], cx[n]));
+
+			idx[n] = _mm_cvtsi128_si64(cx[n]);
+			bx[n] = cx[n];
+		}
+
+		for(size_t n = 0; n < N; n++)
+		{
+			uint64_t hi, lo, cl, ch;
+			uint64_t* p = (uint64_t*)&l[n][idx[n] & MASK];
+			cl = p[0];
+			ch = p[1];
+
+			lo = _umul128(idx[n], cl, &hi);
+			al[n] += hi;
+			ah[n] += lo;
+
+			p[0] = al[n];
+
+			if(MONERO_TWEAK)
+				p[1] = ah[n] ^ mc[n];
+			else
+				p[1] = ah[n];
+
+			ah[n] ^= ch;
+			al[n] ^= cl;
+			idx[n] = al[n];
+		}
+	}
+
+	for(size_t n = 0; n < N; n++)
+	{
+		cn_implode_scratchpad<SOFT_AES, MEMORY, ALGO>((__m128i*)ctx[n].long_state, (__m128i*)ctx[n].hash_state);
+		keccakf((uint64_t*)ctx[n].hash_state, 24);
+		cryptonight_final_hash(ctx[n].hash_state, reinterpret_cast<uint8_t*>(&output[n]));
 	}
 }
 
-}
\ No newline at end of file
+}
@@ -11,7 +11,6 @@
 
 #include <CryptoTypes.h>
 #include "generic-ops.h"
-#include <boost/align/aligned_alloc.hpp>
 
 /* Standard Cryptonight */
 #define CN_PAGE_SIZE                    2097152
@@ -46,27 +45,18 @@ namespace crypto {
   class cn_context {
   public:
 
-    //cn_context();
-    //~cn_context();
-    cn_context()
-    {
-        long_state = (uint8_t*)boost::alignment::aligned_alloc(4096, CN_PAGE_SIZE);
-        hash_state = (uint8_t*)boost::alignment::aligned_alloc(4096, 4096);
-    }
-
-    ~cn_context()
-    {
-        if(long_state != nullptr)
-            boost::alignment::aligned_free(long_state);
-        if(hash_state != nullptr)
-            boost::alignment::aligned_free(hash_state);
-    }
+    // The scratchpad is put on a huge page when the system has one to give, on Linux an explicit
+    // MAP_HUGETLB page first, then a 2 MiB aligned block marked for transparent huge pages. Otherwise
+    // it lives on normal pages as before.
+    cn_context();
+    ~cn_context();
 
     cn_context(const cn_context &) = delete;
     void operator=(const cn_context &) = delete;
 
      uint8_t* long_state = nullptr;
      uint8_t* hash_state = nullptr;
+     bool long_state_mapped = false; // long_state came from mmap rather than aligned_alloc
      
     void *data;
   };
@@ -75,6 +65,13 @@ namespace crypto {
   void cn_fast_slow_hash_v1(cn_context &context, const void *data, size_t length, Hash &hash);
   void cn_conceal_slow_hash_v0(cn_context &context, const void *data, size_t length, Hash &hash);  
 
+  // Hash count inputs at once, each with its own context, with the main loops of two or four of
+  // them interleaved so each hides the AES and multiply latency of the others. The results are
+  // the same as hashing the inputs one by one.
+  void cn_slow_hash(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes);
+  void cn_fast_slow_hash_v1(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes);
+  void cn_conceal_slow_hash_v0(cn_context *contexts, size_t count, const void *const *data, const size_t *lengths, Hash *hashes);
+
   inline void tree_hash(const Hash *hashes, size_t count, Hash &root_hash) {
     tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
   }
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <ios>
@@ -15,7 +16,42 @@
 using namespace std;
 typedef crypto::Hash chash;
 
+const size_t MAX_WAYS = 4;
+
 crypto::cn_context *context;
+bool laneMismatch = false;
+
+typedef void slow_hash_f(crypto::cn_context &, const void *, size_t, chash &);
+typedef void slow_hash_batch_f(crypto::cn_context *, size_t, const void *const *, const size_t *, chash *);
+
+// Hashes the input ways at a time with the other lanes on variants of it, one byte longer per lane
+// and with the first byte changed, and checks every lane against the single hash. The result is
+// the hash of the first lane.
+static void slow_hash_ways(slow_hash_batch_f *batch, slow_hash_f *single, size_t ways, const void *data, size_t length, char *hash) {
+  vector<char> inputs[MAX_WAYS];
+  const void *pointers[MAX_WAYS];
+  size_t lengths[MAX_WAYS];
+  chash hashes[MAX_WAYS];
+  for (size_t i = 0; i < ways; i++) {
+    inputs[i].assign(static_cast<const char *>(data), static_cast<const char *>(data) + length);
+    inputs[i].resize(length + i, static_cast<char>(i));
+    if (!inputs[i].empty()) {
+      inputs[i][0] ^= static_cast<char>(i);
+    }
+    pointers[i] = inputs[i].data();
+    lengths[i] = inputs[i].size();
+  }
+  batch(context, ways, pointers, lengths, hashes);
+  for (size_t i = 0; i < ways; i++) {
+    chash expected;
+    single(context[0], pointers[i], lengths[i], expected);
+    if (hashes[i] != expected) {
+      cerr << "Lane " << i << " of " << ways << " differs from the single hash for input length " << lengths[i] << endl;
+      laneMismatch = true;
+    }
+  }
+  memcpy(hash, &hashes[0], sizeof(chash));
+}
 
 extern "C" {
 #ifdef _MSC_VER
@@ -32,6 +68,38 @@ extern "C" {
   static void slow_hash(const void *data, size_t length, char *hash) {
     cn_slow_hash(*context, data, length, *reinterpret_cast<chash *>(hash));
   }
+
+  static void slow_hash_fast_v1(const void *data, size_t length, char *hash) {
+    cn_fast_slow_hash_v1(*context, data, length, *reinterpret_cast<chash *>(hash));
+  }
+
+  static void slow_hash_conceal(const void *data, size_t length, char *hash) {
+    cn_conceal_slow_hash_v0(*context, data, length, *reinterpret_cast<chash *>(hash));
+  }
+
+  static void slow_hash_2(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_slow_hash, crypto::cn_slow_hash, 2, data, length, hash);
+  }
+
+  static void slow_hash_4(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_slow_hash, crypto::cn_slow_hash, 4, data, length, hash);
+  }
+
+  static void slow_hash_fast_v1_2(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_fast_slow_hash_v1, crypto::cn_fast_slow_hash_v1, 2, data, length, hash);
+  }
+
+  static void slow_hash_fast_v1_4(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_fast_slow_hash_v1, crypto::cn_fast_slow_hash_v1, 4, data, length, hash);
+  }
+
+  static void slow_hash_conceal_2(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_conceal_slow_hash_v0, crypto::cn_conceal_slow_hash_v0, 2, data, length, hash);
+  }
+
+  static void slow_hash_conceal_4(const void *data, size_t length, char *hash) {
+    slow_hash_ways(crypto::cn_conceal_slow_hash_v0, crypto::cn_conceal_slow_hash_v0, 4, data, length, hash);
+  }
 }
 
 extern "C" typedef void hash_f(const void *, size_t, char *);
@@ -39,8 +107,9 @@ struct hash_func {
   const string name;
   hash_f &f;
 } hashes[] = {{"fast", crypto::cn_fast_hash}, {"slow", slow_hash}, {"tree", hash_tree},
-  {"extra-blake", crypto::hash_extra_blake}, {"extra-groestl", crypto::hash_extra_groestl},
-  {"extra-jh", crypto::hash_extra_jh}, {"extra-skein", crypto::hash_extra_skein}};
+  {"slow-fast-v1", slow_hash_fast_v1}, {"slow-conceal", slow_hash_conceal},
+  {"slow-2", slow_hash_2}, {"slow-4", slow_hash_4}, {"slow-fast-v1-2", slow_hash_fast_v1_2},
+  {"slow-fast-v1-4", slow_hash_fast_v1_4}, {"slow-conceal-2", slow_hash_conceal_2}, {"slow-conceal-4", slow_hash_conceal_4}};
 
 int main(int argc, char *argv[]) {
   hash_f *f;
@@ -64,8 +133,8 @@ int main(int argc, char *argv[]) {
       break;
     }
   }
-  if (f == slow_hash) {
-    context = new crypto::cn_context();
+  if (hf->name.compare(0, 4, "slow") == 0) {
+    context = new crypto::cn_context[MAX_WAYS];
   }
   input.open(argv[2], ios_base::in);
   for (;;) {
@@ -101,5 +170,5 @@ int main(int argc, char *argv[]) {
       error = true;
     }
   }
-  return error ? 1 : 0;
+  return error || laneMismatch ? 1 : 0;
 }
@@ -0,0 +1,69 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/MiningJob.h"
+
+#include <Logging/LoggerGroup.h>
+
+// One mining attempt on a block template with transaction_count transactions. With prebuilt ==
+// false the block is serialized and its transaction tree hashed for every nonce as the miners did
+// before, otherwise a MiningJob built once only has its nonce patched.
+template<size_t transaction_count, bool prebuilt>
+class test_block_longhash {
+public:
+  static const size_t loop_count = 100;
+
+  bool init() {
+    logging::LoggerGroup nullLog;
+    cn::Currency currency = cn::CurrencyBuilder(nullLog).currency();
+    cn::AccountBase account;
+    account.generate();
+
+    m_block.majorVersion = cn::BLOCK_MAJOR_VERSION_3;
+    m_block.minorVersion = 0;
+    m_block.timestamp = 1000;
+    m_block.previousBlockHash = crypto::rand<crypto::Hash>();
+    m_block.nonce = 0;
+    if (!currency.constructMinerTx(1000, 0, 0, 2, 0, account.getAccountKeys().address, m_block.baseTransaction)) {
+      return false;
+    }
+
+    for (size_t i = 0; i < transaction_count; ++i) {
+      m_block.transactionHashes.push_back(crypto::rand<crypto::Hash>());
+    }
+
+    // both ways must hash the same blob
+    crypto::Hash expected;
+    crypto::Hash actual;
+    m_block.nonce = 12345;
+    if (!m_job.init(m_block) || !cn::get_block_longhash(m_context, m_block, expected)) {
+      return false;
+    }
+
+    m_job.getLongHash(m_context, actual);
+    return actual == expected;
+  }
+
+  bool test() {
+    crypto::Hash hash;
+    ++m_block.nonce;
+    if (prebuilt) {
+      m_job.setNonce(m_block.nonce);
+      m_job.getLongHash(m_context, hash);
+      return true;
+    }
+
+    return cn::get_block_longhash(m_context, m_block, hash);
+  }
+
+private:
+  cn::Block m_block;
+  cn::MiningJob m_job;
+  crypto::cn_context m_context;
+};
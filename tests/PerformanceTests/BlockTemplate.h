@@ -0,0 +1,113 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionPool.h"
+
+#include <Logging/LoggerGroup.h>
+
+// Stands in for the blockchain, every input check costs one key derivation as a cheap ring
+// signature would
+class PoolValidator : public cn::ITransactionValidator {
+public:
+  PoolValidator() {
+    crypto::generate_keys(m_publicKey, m_secretKey);
+  }
+
+  virtual bool checkTransactionInputs(const cn::Transaction& tx, cn::BlockInfo& maxUsedBlock) override {
+    crypto::KeyDerivation derivation;
+    crypto::generate_key_derivation(m_publicKey, m_secretKey, derivation);
+    maxUsedBlock.height = 1;
+    maxUsedBlock.id = m_blockId;
+    return true;
+  }
+
+  virtual bool checkTransactionInputs(const cn::Transaction& tx, cn::BlockInfo& maxUsedBlock, cn::BlockInfo& lastFailed) override {
+    return checkTransactionInputs(tx, maxUsedBlock);
+  }
+
+  virtual bool haveSpentKeyImages(const cn::Transaction& tx) override {
+    return false;
+  }
+
+  virtual bool checkTransactionSize(size_t blobSize) override {
+    return true;
+  }
+
+private:
+  crypto::PublicKey m_publicKey;
+  crypto::SecretKey m_secretKey;
+  crypto::Hash m_blockId = crypto::rand<crypto::Hash>();
+};
+
+// Adds count transactions with one key input each to the pool
+inline bool addPoolTransactions(cn::tx_memory_pool& pool, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    cn::KeyInput input;
+    input.amount = 1000000;
+    input.outputIndexes.push_back(static_cast<uint32_t>(i));
+    input.keyImage = crypto::rand<crypto::KeyImage>();
+
+    cn::KeyOutput key;
+    key.key = crypto::rand<crypto::PublicKey>();
+    cn::TransactionOutput output;
+    output.amount = input.amount - 1000 - i % 100;
+    output.target = key;
+
+    cn::Transaction tx;
+    tx.version = 1;
+    tx.unlockTime = 0;
+    tx.inputs.push_back(input);
+    tx.outputs.push_back(output);
+    tx.signatures.push_back({ crypto::Signature() });
+
+    cn::tx_verification_context tvc = boost::value_initialized<cn::tx_verification_context>();
+    if (!pool.add_tx(tx, tvc, false, 1) || !tvc.m_added_to_pool) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// A block template out of a pool of transaction_count transactions. With cached == false a block
+// is popped before each template, so every transaction is checked again as fill_block_template
+// did for every call before.
+template<size_t transaction_count, bool cached>
+class test_fill_block_template {
+public:
+  static const size_t loop_count = cached ? 1000 : 10;
+
+  test_fill_block_template() :
+    m_currency(cn::CurrencyBuilder(m_nullLog).currency()),
+    m_pool(m_currency, m_validator, m_timeProvider, m_nullLog) {
+  }
+
+  bool init() {
+    return addPoolTransactions(m_pool, transaction_count);
+  }
+
+  bool test() {
+    if (!cached) {
+      m_pool.on_blockchain_dec(1, cn::NULL_HASH);
+    }
+
+    cn::Block block;
+    size_t totalSize;
+    uint64_t fee;
+    uint32_t height = 1;
+    m_pool.fill_block_template(block, 1000000, 1000000, 0, totalSize, fee, height);
+    return block.transactionHashes.size() == transaction_count;
+  }
+
+private:
+  logging::LoggerGroup m_nullLog;
+  cn::Currency m_currency;
+  cn::RealTimeProvider m_timeProvider;
+  PoolValidator m_validator;
+  cn::tx_memory_pool m_pool;
+};
@@ -0,0 +1,97 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CryptoNoteCore/RecursiveSharedMutex.h"
+#include "crypto/hash.h"
+
+// RPC style readers and a block importing writer on the Blockchain lock. With shared_reads == false
+// readers take the lock exclusively, which is how every Blockchain accessor behaved before the
+// reader/writer lock. Reports the average time spent waiting for the lock.
+template<bool shared_reads>
+class test_blockchain_lock_contention {
+public:
+  static const size_t loop_count = 10;
+  static const size_t reader_count = 4;
+  static const size_t reads_per_reader = 500;
+  static const size_t writes = 20;
+
+  test_blockchain_lock_contention() : m_readWaitMicroseconds(0), m_reads(0), m_writeWaitMicroseconds(0), m_writes(0) {
+  }
+
+  ~test_blockchain_lock_contention() {
+    std::cout << "  reader lock wait: " << (m_reads == 0 ? 0 : m_readWaitMicroseconds / m_reads) << " us/lock, " <<
+      "writer lock wait: " << (m_writes == 0 ? 0 : m_writeWaitMicroseconds / m_writes) << " us/lock" << std::endl;
+  }
+
+  bool init() {
+    m_data.resize(4096, 0x5a);
+    return true;
+  }
+
+  bool test() {
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < reader_count; ++i) {
+      readers.emplace_back([this] {
+        for (size_t j = 0; j < reads_per_reader; ++j) {
+          auto start = std::chrono::steady_clock::now();
+          if (shared_reads) {
+            cn::SharedLockGuard<cn::RecursiveSharedMutex> lock(m_lock);
+            addWait(m_readWaitMicroseconds, m_reads, start);
+            work(4);
+          } else {
+            std::lock_guard<cn::RecursiveSharedMutex> lock(m_lock);
+            addWait(m_readWaitMicroseconds, m_reads, start);
+            work(4);
+          }
+        }
+      });
+    }
+
+    for (size_t i = 0; i < writes; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      {
+        std::lock_guard<cn::RecursiveSharedMutex> lock(m_lock);
+        addWait(m_writeWaitMicroseconds, m_writes, start);
+        work(40);
+      }
+
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    for (auto& reader : readers) {
+      reader.join();
+    }
+
+    return true;
+  }
+
+private:
+  void work(size_t rounds) {
+    crypto::Hash hash;
+    for (size_t i = 0; i < rounds; ++i) {
+      crypto::cn_fast_hash(m_data.data(), m_data.size(), hash);
+    }
+  }
+
+  static void addWait(std::atomic<uint64_t>& total, std::atomic<uint64_t>& count, std::chrono::steady_clock::time_point start) {
+    total += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    ++count;
+  }
+
+  cn::RecursiveSharedMutex m_lock;
+  std::vector<uint8_t> m_data;
+  std::atomic<uint64_t> m_readWaitMicroseconds;
+  std::atomic<uint64_t> m_reads;
+  std::atomic<uint64_t> m_writeWaitMicroseconds;
+  std::atomic<uint64_t> m_writes;
+};
@@ -45,3 +45,68 @@ private:
   crypto::Hash m_expected_hash;
   crypto::cn_context m_context;
 };
+
+// Four block hashing blobs hashed with the algorithm of the current blocks, ways at a time. With
+// ways == 1 every blob is hashed on its own, as the daemon and the miner did before.
+template<size_t ways>
+class test_cn_slow_hash_ways {
+public:
+  static const size_t loop_count = 10;
+  static const size_t hash_count = 4;
+
+  bool init() {
+    for (size_t i = 0; i < hash_count; ++i) {
+      for (size_t j = 0; j < sizeof(m_data[i]); ++j) {
+        m_data[i][j] = static_cast<uint8_t>(i * 31 + j);
+      }
+
+      m_pointers[i] = m_data[i];
+      m_lengths[i] = sizeof(m_data[i]);
+      crypto::cn_conceal_slow_hash_v0(m_contexts[0], m_data[i], sizeof(m_data[i]), m_expected[i]);
+    }
+
+    return test() && matchesSingleHash(crypto::cn_slow_hash, crypto::cn_slow_hash) &&
+      matchesSingleHash(crypto::cn_fast_slow_hash_v1, crypto::cn_fast_slow_hash_v1);
+  }
+
+  bool test() {
+    crypto::Hash hashes[hash_count];
+    for (size_t i = 0; i < hash_count; i += ways) {
+      crypto::cn_conceal_slow_hash_v0(m_contexts, ways, m_pointers + i, m_lengths + i, hashes + i);
+    }
+
+    for (size_t i = 0; i < hash_count; ++i) {
+      if (hashes[i] != m_expected[i]) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  // The algorithms of the older blocks, hashed the same way
+  bool matchesSingleHash(void (*batch)(crypto::cn_context*, size_t, const void* const*, const size_t*, crypto::Hash*),
+    void (*single)(crypto::cn_context&, const void*, size_t, crypto::Hash&)) {
+    crypto::Hash hashes[hash_count];
+    for (size_t i = 0; i < hash_count; i += ways) {
+      batch(m_contexts, ways, m_pointers + i, m_lengths + i, hashes + i);
+    }
+
+    for (size_t i = 0; i < hash_count; ++i) {
+      crypto::Hash expected;
+      single(m_contexts[0], m_data[i], sizeof(m_data[i]), expected);
+      if (hashes[i] != expected) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  uint8_t m_data[hash_count][76];
+  const void* m_pointers[hash_count];
+  size_t m_lengths[hash_count];
+  crypto::Hash m_expected[hash_count];
+  crypto::cn_context m_contexts[ways];
+};
@@ -0,0 +1,102 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "Transfers/TransfersContainer.h"
+
+#include <Logging/LoggerGroup.h>
+
+// The deposit part of WalletGreen::updateBalance for a container holding deposit_count deposits,
+// half of them unlocked. With incremental == false the sums are recomputed from the outputs and
+// their transactions as updateBalance did before, otherwise the container's sums are read.
+template<size_t deposit_count, bool incremental>
+class test_update_balance {
+public:
+  static const size_t loop_count = incremental ? 100000 : 100;
+  static const uint64_t deposit_amount = 1000000;
+
+  test_update_balance() :
+    m_currency(cn::CurrencyBuilder(m_nullLog).currency()),
+    m_container(m_currency, 10) {
+  }
+
+  bool init() {
+    cn::AccountBase account;
+    account.generate();
+
+    uint32_t term = m_currency.depositMinTerm();
+    for (size_t i = 0; i < deposit_count; ++i) {
+      std::unique_ptr<cn::ITransaction> tx = cn::createTransaction();
+      tx->addOutput(deposit_amount, { account.getAccountKeys().address }, 1, term);
+
+      cn::TransactionOutputInformationIn transfer;
+      transfer.type = cn::transaction_types::OutputType::Multisignature;
+      transfer.amount = deposit_amount;
+      transfer.globalOutputIndex = static_cast<uint32_t>(i);
+      transfer.outputInTransaction = 0;
+      transfer.transactionPublicKey = tx->getTransactionPublicKey();
+      transfer.requiredSignatures = 1;
+      transfer.term = term;
+
+      cn::TransactionBlockInfo block{ static_cast<uint32_t>(i + 1), 1000 + i, 0 };
+      if (!m_container.addTransaction(block, *tx, { transfer }, {})) {
+        return false;
+      }
+    }
+
+    m_container.advanceHeight(static_cast<uint32_t>(deposit_count / 2 + term));
+
+    uint64_t locked;
+    uint64_t unlocked;
+    recalculate(locked, unlocked);
+    return locked == m_container.lockedDepositsBalance() && unlocked == m_container.unlockedDepositsBalance() &&
+      locked != 0 && unlocked != 0;
+  }
+
+  bool test() {
+    uint64_t locked;
+    uint64_t unlocked;
+    if (incremental) {
+      locked = m_container.lockedDepositsBalance();
+      unlocked = m_container.unlockedDepositsBalance();
+    } else {
+      recalculate(locked, unlocked);
+    }
+
+    return locked + unlocked >= deposit_count * deposit_amount;
+  }
+
+private:
+  void recalculate(uint64_t& locked, uint64_t& unlocked) const {
+    locked = sum(cn::ITransfersContainer::IncludeTypeDeposit | cn::ITransfersContainer::IncludeStateLocked |
+      cn::ITransfersContainer::IncludeStateSoftLocked);
+    unlocked = sum(cn::ITransfersContainer::IncludeTypeDeposit | cn::ITransfersContainer::IncludeStateUnlocked);
+  }
+
+  uint64_t sum(uint32_t flags) const {
+    std::vector<cn::TransactionOutputInformation> transfers;
+    m_container.getOutputs(transfers, flags);
+
+    uint64_t result = 0;
+    for (const auto& transfer : transfers) {
+      cn::TransactionInformation info;
+      if (m_container.getTransactionInformation(transfer.transactionHash, info, nullptr, nullptr)) {
+        result += transfer.amount + m_currency.calculateInterest(transfer.amount, transfer.term, info.blockHeight);
+      }
+    }
+
+    return result;
+  }
+
+  logging::LoggerGroup m_nullLog;
+  cn::Currency m_currency;
+  cn::TransfersContainer m_container;
+};
@@ -0,0 +1,124 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <map>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Blockchain.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/LoggerGroup.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+
+// Decoy selection behind the /getrandom_outs RPC, on a chain of miner transactions where every
+// request asks for the most used amounts (with a flat block reward that is a single amount). The chain sits in the checkpoint zone so that it can be
+// built without mining.
+class test_get_random_outs {
+public:
+  static const size_t loop_count = 10000;
+  static const uint32_t block_count = 20000;
+  static const size_t amount_count = 4;
+  static const uint64_t outs_count = 12;
+
+  test_get_random_outs() :
+    m_currency(cn::CurrencyBuilder(m_logger).currency()),
+    m_pool(m_currency, m_blockchain, m_timeProvider, m_logger),
+    m_blockchain(m_currency, m_pool, m_logger, false),
+    m_dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()),
+    m_outputs(0) {
+  }
+
+  ~test_get_random_outs() {
+    m_blockchain.deinit();
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_dir, ignore);
+  }
+
+  bool init() {
+    cn::Checkpoints checkpoints(m_logger);
+    checkpoints.add_checkpoint(block_count + 1, "0000000000000000000000000000000000000000000000000000000000000000");
+    m_blockchain.setCheckpoints(std::move(checkpoints));
+
+    boost::filesystem::create_directories(m_dir);
+    if (!m_blockchain.init(m_dir.string(), false)) {
+      return false;
+    }
+
+    cn::AccountBase miner;
+    miner.generate();
+
+    std::map<uint64_t, size_t> amountOutputs;
+    // blocks come twice as fast as the target, so the difficulty never rounds down to zero
+    uint64_t blockTime = m_currency.difficultyTarget() / 2;
+    uint64_t startTime = time(nullptr) - block_count * blockTime;
+    for (uint32_t height = 1; height < block_count; ++height) {
+      cn::Block block = boost::value_initialized<cn::Block>();
+      block.majorVersion = m_blockchain.get_block_major_version_for_height(height);
+      block.minorVersion = cn::BLOCK_MINOR_VERSION_0;
+      block.previousBlockHash = m_blockchain.getTailId();
+      block.timestamp = startTime + height * blockTime;
+      if (!m_currency.constructMinerTx(height, 0, m_blockchain.getCoinsInCirculation(), 0, 0, miner.getAccountKeys().address,
+        block.baseTransaction, cn::BinaryArray(), 11)) {
+        return false;
+      }
+
+      cn::block_verification_context bvc = boost::value_initialized<cn::block_verification_context>();
+      if (!m_blockchain.addNewBlock(block, bvc) || !bvc.m_added_to_main_chain) {
+        return false;
+      }
+
+      for (const auto& output : block.baseTransaction.outputs) {
+        ++amountOutputs[output.amount];
+      }
+    }
+
+    std::vector<std::pair<size_t, uint64_t>> amounts;
+    for (const auto& amount : amountOutputs) {
+      amounts.push_back(std::make_pair(amount.second, amount.first));
+    }
+
+    std::sort(amounts.rbegin(), amounts.rend());
+    for (size_t i = 0; i < amount_count && i < amounts.size() && amounts[i].first >= outs_count; ++i) {
+      m_request.amounts.push_back(amounts[i].second);
+      m_outputs += amounts[i].first;
+    }
+
+    m_request.outs_count = outs_count;
+    std::cout << "  " << m_request.amounts.size() << " amounts with " << m_outputs << " outputs" << std::endl;
+    return true;
+  }
+
+  bool test() {
+    cn::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response response;
+    if (!m_blockchain.getRandomOutsByAmount(m_request, response) || response.outs.size() != m_request.amounts.size()) {
+      return false;
+    }
+
+    for (const auto& amountOuts : response.outs) {
+      if (amountOuts.outs.size() != outs_count) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  logging::LoggerGroup m_logger;
+  cn::Currency m_currency;
+  cn::RealTimeProvider m_timeProvider;
+  cn::tx_memory_pool m_pool;
+  cn::Blockchain m_blockchain;
+  boost::filesystem::path m_dir;
+  cn::COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request m_request;
+  size_t m_outputs;
+};
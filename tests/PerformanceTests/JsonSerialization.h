@@ -0,0 +1,66 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+
+#include "Common/StringTools.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Serialization/SerializationTools.h"
+
+// Writing and reading a f_on_transactions_pool_json sized response of about 10 MB. With
+// streaming == false it goes through a JsonValue tree as storeToJson and loadFromJson did before
+// the buffer serializers, otherwise straight between the text and the structure.
+class test_json_response_base {
+public:
+  static const size_t loop_count = 10;
+  static const size_t transaction_count = 85000;
+
+  bool init() {
+    m_response.status = CORE_RPC_STATUS_OK;
+    m_response.transactions.resize(transaction_count);
+    for (size_t i = 0; i < transaction_count; ++i) {
+      cn::f_transaction_short_response& transaction = m_response.transactions[i];
+      uint64_t hash[4] = { i, i * 3, i * 7, i * 11 };
+      transaction.hash = common::toHex(hash, sizeof(hash));
+      transaction.fee = 10 + i;
+      transaction.amount_out = 1000000000 + i * 1000003;
+      transaction.size = 400 + i % 1000;
+    }
+
+    m_json = cn::storeToJson(m_response);
+    return m_json.size() > 10 * 1000 * 1000;
+  }
+
+protected:
+  cn::F_COMMAND_RPC_GET_POOL::response m_response;
+  std::string m_json;
+};
+
+template<bool streaming>
+class test_json_store : public test_json_response_base {
+public:
+  bool test() {
+    std::string json = streaming ? cn::storeToJson(m_response) : cn::storeToJsonValue(m_response).toString();
+    return json.size() == m_json.size();
+  }
+};
+
+template<bool streaming>
+class test_json_load : public test_json_response_base {
+public:
+  bool test() {
+    cn::F_COMMAND_RPC_GET_POOL::response response;
+    if (streaming) {
+      if (!cn::loadFromJson(response, m_json)) {
+        return false;
+      }
+    } else {
+      cn::loadFromJsonValue(response, common::JsonValue::fromString(m_json));
+    }
+
+    return response.transactions.size() == transaction_count && response.transactions.back().hash == m_response.transactions.back().hash;
+  }
+};
@@ -0,0 +1,62 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <vector>
+
+#include "BlockTemplate.h"
+
+// A wallet polling a pool of transaction_count transactions it already knows, one transaction
+// arrives between two polls. With versioned == false every transaction is checked again and the
+// known ids are differenced as get_difference did for every call before, otherwise the wallet
+// asks for the changes since the version of its previous poll.
+template<size_t transaction_count, bool versioned>
+class test_pool_changes {
+public:
+  static const size_t loop_count = versioned ? 1000 : 10;
+
+  test_pool_changes() :
+    m_currency(cn::CurrencyBuilder(m_nullLog).currency()),
+    m_pool(m_currency, m_validator, m_timeProvider, m_nullLog) {
+  }
+
+  bool init() {
+    std::vector<crypto::Hash> deleted;
+    if (!addPoolTransactions(m_pool, transaction_count) || m_pool.getChangesSince(0, m_knownIds, deleted, m_version)) {
+      return false;
+    }
+
+    return m_knownIds.size() == transaction_count;
+  }
+
+  bool test() {
+    if (!addPoolTransactions(m_pool, 1)) {
+      return false;
+    }
+
+    std::vector<crypto::Hash> added;
+    std::vector<crypto::Hash> deleted;
+    if (versioned) {
+      if (!m_pool.getChangesSince(m_version, added, deleted, m_version)) {
+        return false;
+      }
+    } else {
+      m_pool.on_blockchain_dec(1, cn::NULL_HASH);
+      m_pool.get_difference(m_knownIds, added, deleted);
+    }
+
+    m_knownIds.insert(m_knownIds.end(), added.begin(), added.end());
+    return added.size() == 1 && deleted.empty();
+  }
+
+private:
+  logging::LoggerGroup m_nullLog;
+  cn::Currency m_currency;
+  cn::RealTimeProvider m_timeProvider;
+  PoolValidator m_validator;
+  cn::tx_memory_pool m_pool;
+  std::vector<crypto::Hash> m_knownIds;
+  uint64_t m_version;
+};
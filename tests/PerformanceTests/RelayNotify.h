@@ -0,0 +1,84 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "CryptoNote.h"
+
+// Relaying a block sized notification to peer_count connections, from queueing the message on
+// every connection to handing header and body to the socket. With shared_buffers == false every
+// connection gets its own copy of the payload and the header is prepended into another copy, as
+// relay_notify_to_all and LevinProtocol did before sharing the payload and gathering the writes.
+template<size_t peer_count, bool shared_buffers>
+class test_relay_notify {
+public:
+  static const size_t loop_count = 100;
+  static const size_t payload_size = 512 * 1024;
+  static const size_t header_size = 33;
+
+  bool init() {
+    m_payload.resize(payload_size, 0x5a);
+    m_copyQueues.resize(peer_count);
+    m_sharedQueues.resize(peer_count);
+    return true;
+  }
+
+  bool test() {
+    uint8_t header[header_size] = { 0 };
+    // the encoded notification handed to relay_notify_to_all
+    cn::BinaryArray encoded(m_payload);
+    m_sent = 0;
+
+    if (shared_buffers) {
+      auto payload = std::make_shared<const cn::BinaryArray>(std::move(encoded));
+      for (auto& queue : m_sharedQueues) {
+        queue.push_back(payload);
+      }
+
+      for (auto& queue : m_sharedQueues) {
+        for (const auto& message : queue) {
+          send(header, header_size);
+          send(message->data(), message->size());
+        }
+
+        queue.clear();
+      }
+    } else {
+      for (auto& queue : m_copyQueues) {
+        queue.push_back(encoded);
+      }
+
+      for (auto& queue : m_copyQueues) {
+        for (const auto& message : queue) {
+          cn::BinaryArray writeBuffer;
+          writeBuffer.reserve(header_size + message.size());
+          writeBuffer.insert(writeBuffer.end(), header, header + header_size);
+          writeBuffer.insert(writeBuffer.end(), message.begin(), message.end());
+          send(writeBuffer.data(), writeBuffer.size());
+        }
+
+        queue.clear();
+      }
+    }
+
+    return m_sent == (header_size + payload_size) * peer_count;
+  }
+
+private:
+  // stands in for the socket, which reads the bytes in both cases
+  void send(const uint8_t* data, size_t size) {
+    m_sent += size;
+    m_checksum = m_checksum + data[0] + data[size - 1];
+  }
+
+  cn::BinaryArray m_payload;
+  std::vector<std::vector<cn::BinaryArray>> m_copyQueues;
+  std::vector<std::vector<std::shared_ptr<const cn::BinaryArray>>> m_sharedQueues;
+  size_t m_sent = 0;
+  volatile uint8_t m_checksum = 0;
+};
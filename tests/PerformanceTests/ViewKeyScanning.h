@@ -0,0 +1,82 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "Transfers/CommonTypes.h"
+#include "Transfers/TransfersScanner.h"
+
+#include <Logging/LoggerGroup.h>
+
+// 1000 view keys over a synthetic chain where every transaction pays one of them. With
+// shared == false every key has a scanner of its own, as every TransfersConsumer scanned the
+// blocks before, otherwise one scanner checks all keys and the keys pick their outputs.
+template<bool shared>
+class test_view_key_scanning {
+public:
+  static const size_t loop_count = 1;
+  static const size_t account_count = 1000;
+  static const size_t block_count = 10;
+  static const size_t transactions_per_block = 3;
+
+  bool init() {
+    cn::Currency currency = cn::CurrencyBuilder(m_nullLog).currency();
+    m_accounts.resize(account_count);
+    for (auto& account : m_accounts) {
+      account.generate();
+    }
+
+    m_blocks.resize(block_count);
+    for (size_t i = 0; i < block_count; ++i) {
+      cn::CompleteBlock& block = m_blocks[i];
+      block.blockHash = crypto::rand<crypto::Hash>();
+      block.block = cn::Block();
+      block.block->timestamp = 1000 + i;
+      for (size_t j = 0; j < transactions_per_block; ++j) {
+        const cn::AccountBase& receiver = m_accounts[(i * transactions_per_block + j) * 37 % account_count];
+        cn::Transaction tx;
+        if (!currency.constructMinerTx(static_cast<uint32_t>(i), 0, 0, 2, 0, receiver.getAccountKeys().address, tx)) {
+          return false;
+        }
+
+        block.transactions.emplace_back(cn::createTransactionPrefix(tx));
+      }
+    }
+
+    return true;
+  }
+
+  bool test() {
+    size_t found = 0;
+    if (shared) {
+      cn::TransfersScanner scanner(m_nullLog);
+      for (const auto& account : m_accounts) {
+        scanner.setAccount(account.getAccountKeys().viewSecretKey, { account.getAccountKeys().address.spendPublicKey }, 0);
+      }
+
+      for (const auto& account : m_accounts) {
+        found += scanner.scanBlocks(account.getAccountKeys().viewSecretKey, m_blocks.data(), 0, block_count).size();
+      }
+    } else {
+      for (const auto& account : m_accounts) {
+        cn::TransfersScanner scanner(m_nullLog);
+        scanner.setAccount(account.getAccountKeys().viewSecretKey, { account.getAccountKeys().address.spendPublicKey }, 0);
+        found += scanner.scanBlocks(account.getAccountKeys().viewSecretKey, m_blocks.data(), 0, block_count).size();
+      }
+    }
+
+    return found == block_count * transactions_per_block;
+  }
+
+private:
+  logging::LoggerGroup m_nullLog;
+  std::vector<cn::AccountBase> m_accounts;
+  std::vector<cn::CompleteBlock> m_blocks;
+};
@@ -7,15 +7,24 @@
 #include "PerformanceUtils.h"
 
 // tests
+#include "BlockchainLockContention.h"
+#include "BlockLongHash.h"
+#include "BlockTemplate.h"
 #include "ConstructTransaction.h"
 #include "CheckRingSignature.h"
 #include "CryptoNoteSlowHash.h"
+#include "DepositBalance.h"
 #include "DerivePublicKey.h"
 #include "DeriveSecretKey.h"
 #include "GenerateKeyDerivation.h"
 #include "GenerateKeyImage.h"
 #include "GenerateKeyImageHelper.h"
+#include "GetRandomOuts.h"
 #include "IsOutToAccount.h"
+#include "JsonSerialization.h"
+#include "PoolChanges.h"
+#include "RelayNotify.h"
+#include "ViewKeyScanning.h"
 
 int main(int argc, char** argv)
 {
@@ -59,6 +68,47 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE0(test_derive_secret_key);
 
   TEST_PERFORMANCE0(test_cn_slow_hash);
+  TEST_PERFORMANCE1(test_cn_slow_hash_ways, 1);
+  TEST_PERFORMANCE1(test_cn_slow_hash_ways, 2);
+  TEST_PERFORMANCE1(test_cn_slow_hash_ways, 4);
+
+  TEST_PERFORMANCE1(test_blockchain_lock_contention, false);
+  TEST_PERFORMANCE1(test_blockchain_lock_contention, true);
+
+  TEST_PERFORMANCE0(test_get_random_outs);
+
+  TEST_PERFORMANCE2(test_relay_notify, 8, false);
+  TEST_PERFORMANCE2(test_relay_notify, 8, true);
+  TEST_PERFORMANCE2(test_relay_notify, 32, false);
+  TEST_PERFORMANCE2(test_relay_notify, 32, true);
+  TEST_PERFORMANCE2(test_relay_notify, 128, false);
+  TEST_PERFORMANCE2(test_relay_notify, 128, true);
+
+  TEST_PERFORMANCE1(test_json_store, false);
+  TEST_PERFORMANCE1(test_json_store, true);
+  TEST_PERFORMANCE1(test_json_load, false);
+  TEST_PERFORMANCE1(test_json_load, true);
+
+  TEST_PERFORMANCE1(test_view_key_scanning, false);
+  TEST_PERFORMANCE1(test_view_key_scanning, true);
+
+  TEST_PERFORMANCE2(test_update_balance, 100, false);
+  TEST_PERFORMANCE2(test_update_balance, 100, true);
+  TEST_PERFORMANCE2(test_update_balance, 1000, false);
+  TEST_PERFORMANCE2(test_update_balance, 1000, true);
+  TEST_PERFORMANCE2(test_update_balance, 10000, false);
+  TEST_PERFORMANCE2(test_update_balance, 10000, true);
+
+  TEST_PERFORMANCE2(test_block_longhash, 0, false);
+  TEST_PERFORMANCE2(test_block_longhash, 0, true);
+  TEST_PERFORMANCE2(test_block_longhash, 1000, false);
+  TEST_PERFORMANCE2(test_block_longhash, 1000, true);
+
+  TEST_PERFORMANCE2(test_fill_block_template, 1000, false);
+  TEST_PERFORMANCE2(test_fill_block_template, 1000, true);
+
+  TEST_PERFORMANCE2(test_pool_changes, 1000, false);
+  TEST_PERFORMANCE2(test_pool_changes, 1000, true);
 
   std::cout << "Tests finished. Elapsed time: " << timer.elapsed_ms() / 1000 << " sec" << std::endl;
 
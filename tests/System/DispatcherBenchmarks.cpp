@@ -0,0 +1,175 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include <System/Context.h>
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/TcpListener.h>
+#include <System/Timer.h>
+#include <gtest/gtest.h>
+
+using namespace platform_system;
+
+// Rough throughput figures of the dispatcher, printed rather than asserted
+
+namespace {
+
+const Ipv4Address LISTEN_ADDRESS("127.0.0.1");
+const uint16_t LISTEN_PORT = 6668;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void readStrict(TcpConnection& connection, uint8_t* data, size_t size) {
+  while (size > 0) {
+    size_t transferred = connection.read(data, size);
+    ASSERT_NE(0, transferred);
+    data += transferred;
+    size -= transferred;
+  }
+}
+
+void writeStrict(TcpConnection& connection, const uint8_t* data, size_t size) {
+  while (size > 0) {
+    size_t transferred = connection.write(data, size);
+    data += transferred;
+    size -= transferred;
+  }
+}
+
+}
+
+TEST(DispatcherBenchmarks, contextSwitches) {
+  const size_t ROUNDS = 200000;
+  Dispatcher dispatcher;
+  Event ping(dispatcher);
+  Event pong(dispatcher);
+
+  auto start = std::chrono::steady_clock::now();
+  Context<> pinger(dispatcher, [&] {
+    for (size_t i = 0; i < ROUNDS; ++i) {
+      ping.set();
+      pong.wait();
+      pong.clear();
+    }
+  });
+
+  Context<> ponger(dispatcher, [&] {
+    for (size_t i = 0; i < ROUNDS; ++i) {
+      ping.wait();
+      ping.clear();
+      pong.set();
+    }
+  });
+
+  pinger.get();
+  ponger.get();
+  double seconds = secondsSince(start);
+
+  std::cout << "  " << static_cast<uint64_t>(2 * ROUNDS / seconds) << " context switches/s" << std::endl;
+}
+
+TEST(DispatcherBenchmarks, acceptAndEcho) {
+  const size_t CONNECTIONS = 100;
+  const size_t ROUND_TRIPS = 100;
+  const size_t MESSAGE_SIZE = 1024;
+  Dispatcher dispatcher;
+  TcpListener listener(dispatcher, LISTEN_ADDRESS, LISTEN_PORT);
+  ContextGroup server(dispatcher);
+
+  server.spawn([&] {
+    for (size_t i = 0; i < CONNECTIONS; ++i) {
+      auto connection = std::make_shared<TcpConnection>(listener.accept());
+      server.spawn([connection, MESSAGE_SIZE, ROUND_TRIPS] {
+        std::vector<uint8_t> buffer(MESSAGE_SIZE);
+        for (size_t j = 0; j < ROUND_TRIPS; ++j) {
+          readStrict(*connection, buffer.data(), buffer.size());
+          writeStrict(*connection, buffer.data(), buffer.size());
+        }
+      });
+    }
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  ContextGroup clients(dispatcher);
+  for (size_t i = 0; i < CONNECTIONS; ++i) {
+    clients.spawn([&] {
+      TcpConnection connection = TcpConnector(dispatcher).connect(LISTEN_ADDRESS, LISTEN_PORT);
+      std::vector<uint8_t> message(MESSAGE_SIZE, 0x5a);
+      std::vector<uint8_t> echo(MESSAGE_SIZE);
+      for (size_t j = 0; j < ROUND_TRIPS; ++j) {
+        writeStrict(connection, message.data(), message.size());
+        readStrict(connection, echo.data(), echo.size());
+        ASSERT_EQ(message, echo);
+      }
+    });
+  }
+
+  clients.wait();
+  double seconds = secondsSince(start);
+  server.wait();
+
+  std::cout << "  " << CONNECTIONS << " connections accepted and echoed in " << static_cast<uint64_t>(seconds * 1000) << " ms, " <<
+    static_cast<uint64_t>(CONNECTIONS * ROUND_TRIPS / seconds) << " round trips/s" << std::endl;
+}
+
+TEST(DispatcherBenchmarks, concurrentTimers) {
+  const size_t TIMERS = 10000;
+  const size_t MAX_SLEEP_MS = 100;
+  Dispatcher dispatcher;
+  ContextGroup sleepers(dispatcher);
+  uint64_t totalLateness = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < TIMERS; ++i) {
+    sleepers.spawn([&, i] {
+      auto duration = std::chrono::milliseconds(1 + i % MAX_SLEEP_MS);
+      auto sleepStart = std::chrono::steady_clock::now();
+      Timer(dispatcher).sleep(duration);
+      auto lateness = std::chrono::steady_clock::now() - sleepStart - duration;
+      ASSERT_GE(lateness.count(), 0);
+      totalLateness += std::chrono::duration_cast<std::chrono::microseconds>(lateness).count();
+    });
+  }
+
+  sleepers.wait();
+  double seconds = secondsSince(start);
+
+  std::cout << "  " << TIMERS << " concurrent sleeps of up to " << MAX_SLEEP_MS << " ms done in " << static_cast<uint64_t>(seconds * 1000) <<
+    " ms, " << totalLateness / TIMERS << " us late on average" << std::endl;
+}
+
+TEST(DispatcherBenchmarks, cancelledTimers) {
+  const size_t TIMERS = 10000;
+  const size_t ROUNDS = 10;
+  Dispatcher dispatcher;
+
+  auto start = std::chrono::steady_clock::now();
+  for (size_t round = 0; round < ROUNDS; ++round) {
+    ContextGroup sleepers(dispatcher);
+    for (size_t i = 0; i < TIMERS; ++i) {
+      sleepers.spawn([&, i] {
+        ASSERT_ANY_THROW(Timer(dispatcher).sleep(std::chrono::seconds(10 + i)));
+      });
+    }
+
+    dispatcher.yield();
+    sleepers.interrupt();
+    sleepers.wait();
+  }
+
+  double seconds = secondsSince(start);
+
+  std::cout << "  " << static_cast<uint64_t>(ROUNDS * TIMERS / seconds) << " timers armed and cancelled/s" << std::endl;
+}
@@ -263,6 +263,53 @@ TEST_F(TcpConnectionTests, sendBigChunk) {
   ASSERT_EQ(buf, incoming);
 }
 
+TEST_F(TcpConnectionTests, sendBigChunkGathered) {
+  connect();
+
+  std::vector<uint8_t> header(33);
+  std::vector<uint8_t> body(4 * 1024 * 1024);
+  fillRandomBuf(header);
+  fillRandomBuf(body);
+
+  std::vector<uint8_t> incoming;
+  Event readComplete(dispatcher);
+
+  contextGroup.spawn([&]{
+    uint8_t readBuf[1024];
+    size_t readSize;
+    while ((readSize = connection2.read(readBuf, sizeof(readBuf))) > 0) {
+      incoming.insert(incoming.end(), readBuf, readBuf + readSize);
+    }
+
+    readComplete.set();
+  });
+
+  contextGroup.spawn([&]{
+    TcpConnection::ConstBuffer buffers[2] = { { header.data(), header.size() }, { body.data(), body.size() } };
+    size_t first = 0;
+    while (first < 2) {
+      size_t transferred = connection1.writeGathered(buffers + first, 2 - first);
+      while (first < 2 && transferred >= buffers[first].size) {
+        transferred -= buffers[first].size;
+        ++first;
+      }
+
+      if (first < 2) {
+        buffers[first].data += transferred;
+        buffers[first].size -= transferred;
+      }
+    }
+
+    connection1 = TcpConnection(); // close connection
+  });
+
+  readComplete.wait();
+
+  std::vector<uint8_t> expected(header);
+  expected.insert(expected.end(), body.begin(), body.end());
+  ASSERT_EQ(expected, incoming);
+}
+
 TEST_F(TcpConnectionTests, writeWhenReadWaiting) {
   connect();
 
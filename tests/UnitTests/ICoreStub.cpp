@@ -137,6 +137,13 @@ bool ICoreStub::getPoolChangesLite(const crypto::Hash& tailBlockId, const std::v
   return returnStatus;
 }
 
+bool ICoreStub::getPoolChangesSince(const crypto::Hash& tailBlockId, uint64_t poolVersion, std::vector<cn::TransactionPrefixInfo>& addedTxs,
+                                    std::vector<crypto::Hash>& deletedTxsIds, uint64_t& currentPoolVersion, bool& isFullPool) {
+  currentPoolVersion = 0;
+  isFullPool = true;
+  return getPoolChangesLite(tailBlockId, {}, addedTxs, deletedTxsIds);
+}
+
 void ICoreStub::getPoolChanges(const std::vector<crypto::Hash>& knownTxsIds, std::vector<cn::Transaction>& addedTxs,
                                std::vector<crypto::Hash>& deletedTxsIds) {
 }
@@ -38,6 +38,8 @@ public:
                               std::vector<cn::Transaction>& addedTxs, std::vector<crypto::Hash>& deletedTxsIds) override;
   virtual bool getPoolChangesLite(const crypto::Hash& tailBlockId, const std::vector<crypto::Hash>& knownTxsIds,
           std::vector<cn::TransactionPrefixInfo>& addedTxs, std::vector<crypto::Hash>& deletedTxsIds) override;
+  virtual bool getPoolChangesSince(const crypto::Hash& tailBlockId, uint64_t poolVersion, std::vector<cn::TransactionPrefixInfo>& addedTxs,
+                                   std::vector<crypto::Hash>& deletedTxsIds, uint64_t& currentPoolVersion, bool& isFullPool) override;
   virtual void getPoolChanges(const std::vector<crypto::Hash>& knownTxsIds, std::vector<cn::Transaction>& addedTxs,
                               std::vector<crypto::Hash>& deletedTxsIds) override;
   virtual bool queryBlocks(const std::vector<crypto::Hash>& block_ids, uint64_t timestamp,
@@ -53,6 +55,7 @@ public:
   virtual void pause_mining() override {}
   virtual void update_block_template_and_resume_mining() override {}
   virtual bool handle_incoming_block_blob(const cn::BinaryArray& block_blob, cn::block_verification_context& bvc, bool control_miner, bool relay_block) override { return false; }
+  virtual void prepareBlocks(std::vector<cn::Block> blocks) override {}
   virtual bool handle_get_objects(cn::NOTIFY_REQUEST_GET_OBJECTS::request& arg, cn::NOTIFY_RESPONSE_GET_OBJECTS::request& rsp) override { return false; }
   virtual void on_synchronized() override {}
   virtual bool getOutByMSigGIndex(uint64_t amount, uint64_t gindex, cn::MultisignatureOutput& out) override { return true; }
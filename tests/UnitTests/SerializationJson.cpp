@@ -0,0 +1,184 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <limits>
+#include <sstream>
+
+#include "Serialization/JsonInputBufferSerializer.h"
+#include "Serialization/JsonOutputBufferSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "Serialization/SerializationTools.h"
+
+using namespace cn;
+
+namespace {
+
+struct JsonElement {
+  std::string name;
+  int32_t i32 = 0;
+  std::array<uint8_t, 4> blob = {{ 0 }};
+  std::vector<uint32_t> u32array;
+
+  bool operator==(const JsonElement& other) const {
+    return name == other.name && i32 == other.i32 && blob == other.blob && u32array == other.u32array;
+  }
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(name)
+    KV_MEMBER(i32)
+    s.binary(blob.data(), blob.size(), "blob");
+    KV_MEMBER(u32array)
+  }
+};
+
+struct JsonStruct {
+  uint8_t u8 = 0;
+  uint64_t u64 = 0;
+  int64_t i64 = 0;
+  double real = 0;
+  bool flag = false;
+  std::string text;
+  std::vector<JsonElement> elements;
+  std::vector<std::string> empty;
+  JsonElement root;
+
+  bool operator==(const JsonStruct& other) const {
+    return u8 == other.u8 && u64 == other.u64 && i64 == other.i64 && real == other.real && flag == other.flag &&
+      text == other.text && elements == other.elements && empty == other.empty && root == other.root;
+  }
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(u8)
+    KV_MEMBER(u64)
+    KV_MEMBER(i64)
+    KV_MEMBER(real)
+    KV_MEMBER(flag)
+    KV_MEMBER(text)
+    KV_MEMBER(elements)
+    KV_MEMBER(empty)
+    KV_MEMBER(root)
+  }
+};
+
+JsonStruct makeStruct(const std::string& text) {
+  JsonStruct value;
+  value.u8 = 200;
+  value.u64 = 1234567890123ULL;
+  value.i64 = -42;
+  value.real = 0.25;
+  value.flag = true;
+  value.text = text;
+  for (size_t i = 0; i < 3; ++i) {
+    JsonElement element;
+    element.name = "element" + std::to_string(i);
+    element.i32 = -static_cast<int32_t>(i);
+    element.blob = {{ 1, 2, 3, static_cast<uint8_t>(i) }};
+    element.u32array.assign(i, static_cast<uint32_t>(i));
+    value.elements.push_back(element);
+  }
+
+  value.root.name = "root";
+  return value;
+}
+
+}
+
+TEST(SerializationJson, roundTrip) {
+  JsonStruct value = makeStruct("quote \" slash \\ tab \t line\nend \x01");
+  value.u64 = std::numeric_limits<uint64_t>::max();
+  value.i64 = std::numeric_limits<int64_t>::min();
+
+  std::string json = storeToJson(value);
+  JsonStruct loaded;
+  ASSERT_TRUE(loadFromJson(loaded, json));
+  ASSERT_EQ(value, loaded);
+}
+
+TEST(SerializationJson, readsJsonValueOutput) {
+  JsonStruct value = makeStruct("quote \" and\nnew line");
+
+  JsonOutputStreamSerializer output;
+  serialize(value, output);
+  std::ostringstream stream;
+  stream << output;
+  std::string json = stream.str();
+
+  JsonStruct loaded;
+  JsonInputBufferSerializer input(json);
+  serialize(loaded, input);
+  ASSERT_EQ(value, loaded);
+}
+
+TEST(SerializationJson, outputIsReadByJsonValue) {
+  // JsonInputValueSerializer reads doubles with getInteger, so the struct without one
+  JsonElement value = makeStruct("").elements[2];
+
+  std::string json = storeToJson(value);
+  JsonElement loaded;
+  loadFromJsonValue(loaded, common::JsonValue::fromString(json));
+  ASSERT_EQ(value, loaded);
+}
+
+TEST(SerializationJson, membersInAnyOrder) {
+  std::string json = " { \"root\" : {\"u32array\":[], \"name\":\"r\"}, \"text\":\"\\u00e9\\ud83d\\ude00\", \"u8\":7, \"unknown\":[{}, [1, 2.5e3]], \"real\":1 } ";
+
+  JsonStruct loaded;
+  ASSERT_TRUE(loadFromJson(loaded, json));
+  ASSERT_EQ(7, loaded.u8);
+  ASSERT_EQ(1.0, loaded.real);
+  ASSERT_EQ("\xc3\xa9\xf0\x9f\x98\x80", loaded.text);
+  ASSERT_EQ("r", loaded.root.name);
+  ASSERT_EQ(0, loaded.u64);
+  ASSERT_TRUE(loaded.elements.empty());
+}
+
+TEST(SerializationJson, rejectsMalformedText) {
+  const char* texts[] = {
+    "[]",
+    "{\"u8\":1,}",
+    "{\"u8\":01}",
+    "{\"u8\":-}",
+    "{\"u8\":1.}",
+    "{\"text\":\"open}",
+    "{\"u8\":1",
+    "{\"u8\" 1}",
+    "{u8:1}",
+    "{\"u8\":tru}",
+    "{\"elements\":[1 2]}"
+  };
+
+  for (const char* text : texts) {
+    JsonStruct loaded;
+    ASSERT_FALSE(loadFromJson(loaded, text)) << text;
+  }
+}
+
+TEST(SerializationJson, rejectsWrongTypes) {
+  const char* texts[] = {
+    "{\"u8\":\"1\"}",
+    "{\"u64\":1.5}",
+    "{\"u64\":18446744073709551616}",
+    "{\"text\":1}",
+    "{\"flag\":null}",
+    "{\"root\":[]}",
+    "{\"elements\":{}}"
+  };
+
+  for (const char* text : texts) {
+    JsonStruct loaded;
+    ASSERT_FALSE(loadFromJson(loaded, text)) << text;
+  }
+}
+
+TEST(SerializationJson, deepNestingDoesNotRecurse) {
+  const size_t DEPTH = 1000000;
+  std::string json = "{\"unknown\":" + std::string(DEPTH, '[') + std::string(DEPTH, ']') + ",\"u8\":3}";
+
+  JsonStruct loaded;
+  ASSERT_TRUE(loadFromJson(loaded, json));
+  ASSERT_EQ(3, loaded.u8);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/BlockBlobCache.h"
+
+using namespace cn;
+
+namespace {
+
+crypto::Hash makeHash(uint32_t height) {
+  crypto::Hash hash = NULL_HASH;
+  hash.data[0] = static_cast<uint8_t>(height);
+  hash.data[1] = static_cast<uint8_t>(height >> 8);
+  return hash;
+}
+
+std::shared_ptr<const SerializedBlock> makeBlock(uint32_t height, size_t blobSize) {
+  std::shared_ptr<SerializedBlock> block = std::make_shared<SerializedBlock>();
+  block->blockHash = makeHash(height);
+  block->timestamp = height;
+  block->block = std::string(blobSize, 'b');
+  return block;
+}
+
+}
+
+TEST(BlockBlobCache, returnsBlockWithMatchingHash) {
+  BlockBlobCache cache(1024 * 1024);
+  cache.put(5, makeBlock(5, 100));
+
+  auto block = cache.get(5, makeHash(5));
+  ASSERT_NE(nullptr, block);
+  ASSERT_EQ(5, block->timestamp);
+  ASSERT_EQ(nullptr, cache.get(5, makeHash(6)));
+  ASSERT_EQ(nullptr, cache.get(6, makeHash(6)));
+  ASSERT_EQ(1, cache.hits());
+  ASSERT_EQ(2, cache.misses());
+}
+
+TEST(BlockBlobCache, evictsLeastRecentlyUsed) {
+  BlockBlobCache cache(3 * (sizeof(SerializedBlock) + 1000));
+  cache.put(1, makeBlock(1, 1000));
+  cache.put(2, makeBlock(2, 1000));
+  cache.put(3, makeBlock(3, 1000));
+  ASSERT_NE(nullptr, cache.get(1, makeHash(1)));
+
+  cache.put(4, makeBlock(4, 1000));
+  ASSERT_NE(nullptr, cache.get(1, makeHash(1)));
+  ASSERT_EQ(nullptr, cache.get(2, makeHash(2)));
+  ASSERT_NE(nullptr, cache.get(3, makeHash(3)));
+  ASSERT_NE(nullptr, cache.get(4, makeHash(4)));
+}
+
+TEST(BlockBlobCache, invalidateFromDropsPoppedHeights) {
+  BlockBlobCache cache(1024 * 1024);
+  for (uint32_t height = 0; height < 10; ++height) {
+    cache.put(height, makeBlock(height, 10));
+  }
+
+  cache.invalidateFrom(7);
+  ASSERT_NE(nullptr, cache.get(6, makeHash(6)));
+  ASSERT_EQ(nullptr, cache.get(7, makeHash(7)));
+  ASSERT_EQ(nullptr, cache.get(9, makeHash(9)));
+}
@@ -0,0 +1,108 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/BlockCacheJournal.h"
+#include "crypto/hash.h"
+
+using namespace cn;
+
+namespace {
+
+crypto::Hash makeHash(uint8_t seed) {
+  crypto::Hash hash;
+  std::fill(std::begin(hash.data), std::end(hash.data), seed);
+  return hash;
+}
+
+class BlockCacheJournalTest : public ::testing::Test {
+public:
+  BlockCacheJournalTest() : m_path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+  }
+
+  ~BlockCacheJournalTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove(m_path, ignore);
+  }
+
+protected:
+  boost::filesystem::path m_path;
+};
+
+}
+
+TEST_F(BlockCacheJournalTest, loadFailsWithoutHeader) {
+  BlockCacheJournal journal;
+  ASSERT_TRUE(journal.open(m_path.string()));
+
+  crypto::Hash checkpointHash;
+  std::vector<BlockCacheJournal::PopRecord> records;
+  ASSERT_FALSE(journal.load(checkpointHash, records));
+}
+
+TEST_F(BlockCacheJournalTest, recordsSurviveReopen) {
+  {
+    BlockCacheJournal journal;
+    ASSERT_TRUE(journal.open(m_path.string()));
+    ASSERT_TRUE(journal.reset(makeHash(1)));
+    uint8_t entry[] = { 1, 2, 3 };
+    ASSERT_TRUE(journal.appendPop(10, makeHash(10), entry, sizeof entry));
+    ASSERT_TRUE(journal.appendPop(9, makeHash(9), entry, 1));
+    ASSERT_EQ(2, journal.recordCount());
+  }
+
+  BlockCacheJournal journal;
+  ASSERT_TRUE(journal.open(m_path.string()));
+  crypto::Hash checkpointHash;
+  std::vector<BlockCacheJournal::PopRecord> records;
+  ASSERT_TRUE(journal.load(checkpointHash, records));
+  ASSERT_EQ(makeHash(1), checkpointHash);
+  ASSERT_EQ(2, records.size());
+  ASSERT_EQ(10, records[0].height);
+  ASSERT_EQ(makeHash(10), records[0].blockHash);
+  ASSERT_EQ(BinaryArray({ 1, 2, 3 }), records[0].entry);
+  ASSERT_EQ(9, records[1].height);
+  ASSERT_EQ(BinaryArray({ 1 }), records[1].entry);
+  ASSERT_EQ(2, journal.recordCount());
+}
+
+TEST_F(BlockCacheJournalTest, tornTailRecordIsIgnored) {
+  {
+    BlockCacheJournal journal;
+    ASSERT_TRUE(journal.open(m_path.string()));
+    ASSERT_TRUE(journal.reset(makeHash(1)));
+    uint8_t entry[] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(journal.appendPop(10, makeHash(10), entry, sizeof entry));
+    ASSERT_TRUE(journal.appendPop(9, makeHash(9), entry, sizeof entry));
+  }
+
+  boost::filesystem::resize_file(m_path, boost::filesystem::file_size(m_path) - 2);
+
+  BlockCacheJournal journal;
+  ASSERT_TRUE(journal.open(m_path.string()));
+  crypto::Hash checkpointHash;
+  std::vector<BlockCacheJournal::PopRecord> records;
+  ASSERT_TRUE(journal.load(checkpointHash, records));
+  ASSERT_EQ(1, records.size());
+  ASSERT_EQ(10, records[0].height);
+}
+
+TEST_F(BlockCacheJournalTest, resetDropsRecords) {
+  BlockCacheJournal journal;
+  ASSERT_TRUE(journal.open(m_path.string()));
+  ASSERT_TRUE(journal.reset(makeHash(1)));
+  uint8_t entry[] = { 1 };
+  ASSERT_TRUE(journal.appendPop(10, makeHash(10), entry, sizeof entry));
+  ASSERT_TRUE(journal.reset(makeHash(2)));
+  ASSERT_EQ(0, journal.recordCount());
+
+  crypto::Hash checkpointHash;
+  std::vector<BlockCacheJournal::PopRecord> records;
+  ASSERT_TRUE(journal.load(checkpointHash, records));
+  ASSERT_EQ(makeHash(2), checkpointHash);
+  ASSERT_TRUE(records.empty());
+}
@@ -0,0 +1,163 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteProtocol/BlockDownloadScheduler.h"
+#include "crypto/hash.h"
+
+using cn::BlockDownloadScheduler;
+
+namespace {
+
+crypto::Hash makeBlockId(uint32_t height, uint32_t fork = 0) {
+  uint32_t data[2] = { height, fork };
+  crypto::Hash hash;
+  crypto::cn_fast_hash(data, sizeof data, hash);
+  return hash;
+}
+
+std::vector<crypto::Hash> makeChain(uint32_t startHeight, uint32_t count, uint32_t fork = 0) {
+  std::vector<crypto::Hash> ids;
+  for (uint32_t i = 0; i < count; ++i) {
+    ids.push_back(makeBlockId(startHeight + i, fork));
+  }
+
+  return ids;
+}
+
+BlockDownloadScheduler::PeerId makePeer(uint8_t id) {
+  BlockDownloadScheduler::PeerId peer = boost::uuids::uuid();
+  peer.data[0] = id;
+  return peer;
+}
+
+}
+
+TEST(BlockDownloadScheduler, spansAreHandedOutWithinWindow) {
+  BlockDownloadScheduler scheduler(10, 2);
+  scheduler.addChain(100, makeChain(100, 45));
+  ASSERT_EQ(145, scheduler.endHeight());
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, span));
+  ASSERT_EQ(100, span.height);
+  ASSERT_EQ(10, span.blockIds.size());
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now, span));
+  ASSERT_EQ(110, span.height);
+  ASSERT_TRUE(scheduler.assign(makePeer(3), 1000, now, span));
+  ASSERT_EQ(120, span.height);
+  ASSERT_FALSE(scheduler.assign(makePeer(4), 1000, now, span));
+  ASSERT_TRUE(scheduler.hasPendingSpans());
+}
+
+TEST(BlockDownloadScheduler, peerGetsOnlySpansBelowItsTop) {
+  BlockDownloadScheduler scheduler(10, 4);
+  scheduler.addChain(100, makeChain(100, 20));
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, span));
+  ASSERT_FALSE(scheduler.assign(makePeer(2), 118, now, span));
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 119, now, span));
+  ASSERT_EQ(110, span.height);
+}
+
+TEST(BlockDownloadScheduler, downloadedSpansArePoppedInOrder) {
+  BlockDownloadScheduler scheduler(10, 4);
+  scheduler.addChain(100, makeChain(100, 20));
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span first;
+  BlockDownloadScheduler::Span second;
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, first));
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now, second));
+
+  uint32_t height;
+  ASSERT_TRUE(scheduler.complete(makePeer(2), second.blockIds.front(), second.blockIds.size(), now, height));
+  ASSERT_EQ(110, height);
+  ASSERT_FALSE(scheduler.popDownloaded(height));
+
+  ASSERT_TRUE(scheduler.complete(makePeer(1), first.blockIds.front(), first.blockIds.size(), now, height));
+  ASSERT_FALSE(scheduler.complete(makePeer(1), first.blockIds.front(), first.blockIds.size(), now, height));
+  ASSERT_TRUE(scheduler.popDownloaded(height));
+  ASSERT_EQ(100, height);
+  ASSERT_TRUE(scheduler.popDownloaded(height));
+  ASSERT_EQ(110, height);
+  ASSERT_TRUE(scheduler.empty());
+}
+
+TEST(BlockDownloadScheduler, lateSpanMovesToFasterPeer) {
+  BlockDownloadScheduler scheduler(10, 0);
+  scheduler.addChain(100, makeChain(100, 30));
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span span;
+  uint32_t height;
+
+  // peer 2 proves fast on the first span
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now, span));
+  ASSERT_TRUE(scheduler.complete(makePeer(2), span.blockIds.front(), span.blockIds.size(), now + std::chrono::milliseconds(100), height));
+  ASSERT_TRUE(scheduler.popDownloaded(height));
+
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, span));
+  ASSERT_EQ(110, span.height);
+  ASSERT_FALSE(scheduler.assign(makePeer(2), 1000, now + std::chrono::seconds(5), span));
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now + std::chrono::seconds(60), span));
+  ASSERT_EQ(110, span.height);
+
+  // whoever delivers first wins, the other copy is dismissed
+  ASSERT_TRUE(scheduler.complete(makePeer(1), span.blockIds.front(), span.blockIds.size(), now + std::chrono::seconds(61), height));
+  ASSERT_FALSE(scheduler.complete(makePeer(2), span.blockIds.front(), span.blockIds.size(), now + std::chrono::seconds(62), height));
+}
+
+TEST(BlockDownloadScheduler, releasedSpanIsHandedOutAgain) {
+  BlockDownloadScheduler scheduler(10, 0);
+  scheduler.addChain(100, makeChain(100, 10));
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, span));
+  ASSERT_FALSE(scheduler.assign(makePeer(2), 1000, now, span));
+  scheduler.removePeer(makePeer(1));
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now, span));
+  ASSERT_EQ(100, span.height);
+}
+
+TEST(BlockDownloadScheduler, chainEntriesAreMerged) {
+  BlockDownloadScheduler scheduler(10, 10);
+  ASSERT_EQ(BlockDownloadScheduler::NO_HEIGHT, scheduler.addChain(100, makeChain(100, 15)));
+  ASSERT_EQ(BlockDownloadScheduler::NO_HEIGHT, scheduler.addChain(105, makeChain(105, 20)));
+  ASSERT_EQ(125, scheduler.endHeight());
+  ASSERT_EQ(BlockDownloadScheduler::NO_HEIGHT, scheduler.addChain(200, makeChain(200, 20)));
+  ASSERT_EQ(125, scheduler.endHeight());
+
+  // spans are now 100-109, 110-114 and 115-124, a fork at 117 rebuilds the last one from its agreeing head
+  std::vector<crypto::Hash> fork = makeChain(112, 5);
+  std::vector<crypto::Hash> forkTail = makeChain(117, 3, 1);
+  fork.insert(fork.end(), forkTail.begin(), forkTail.end());
+  ASSERT_EQ(115, scheduler.addChain(112, fork));
+  ASSERT_EQ(120, scheduler.endHeight());
+
+  auto now = BlockDownloadScheduler::Clock::now();
+  BlockDownloadScheduler::Span span;
+  ASSERT_TRUE(scheduler.assign(makePeer(1), 1000, now, span));
+  ASSERT_TRUE(scheduler.assign(makePeer(2), 1000, now, span));
+  ASSERT_EQ(110, span.height);
+  ASSERT_TRUE(scheduler.assign(makePeer(3), 1000, now, span));
+  ASSERT_EQ(115, span.height);
+  ASSERT_EQ(makeBlockId(115), span.blockIds.front());
+  ASSERT_EQ(makeBlockId(119, 1), span.blockIds.back());
+}
+
+TEST(BlockDownloadScheduler, oneChainRequestAtATime) {
+  BlockDownloadScheduler scheduler(10, 10);
+  auto now = BlockDownloadScheduler::Clock::now();
+  ASSERT_TRUE(scheduler.startChainRequest(makePeer(1), now));
+  ASSERT_FALSE(scheduler.startChainRequest(makePeer(2), now));
+  ASSERT_TRUE(scheduler.startChainRequest(makePeer(2), now + std::chrono::seconds(60)));
+  scheduler.finishChainRequest(makePeer(2));
+  ASSERT_TRUE(scheduler.startChainRequest(makePeer(1), now));
+}
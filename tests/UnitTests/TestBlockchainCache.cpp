@@ -0,0 +1,148 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <ctime>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Blockchain.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "Logging/StreamLogger.h"
+
+using namespace cn;
+
+namespace {
+
+const uint32_t CHECKPOINT_ZONE_HEIGHT = 100;
+
+struct Node {
+  Node(const Currency& currency, logging::ILogger& logger) :
+    pool(currency, blockchain, timeProvider, logger),
+    blockchain(currency, pool, logger, false) {
+    // blocks below a checkpoint are accepted without proof of work
+    Checkpoints checkpoints(logger);
+    checkpoints.add_checkpoint(CHECKPOINT_ZONE_HEIGHT, "0000000000000000000000000000000000000000000000000000000000000000");
+    blockchain.setCheckpoints(std::move(checkpoints));
+  }
+
+  ~Node() {
+    blockchain.deinit();
+  }
+
+  RealTimeProvider timeProvider;
+  tx_memory_pool pool;
+  Blockchain blockchain;
+};
+
+class BlockchainCacheTest : public ::testing::Test {
+public:
+  BlockchainCacheTest() :
+    m_logger(m_log, logging::WARNING),
+    m_currency(CurrencyBuilder(m_logger).currency()),
+    m_dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()),
+    m_startTime(time(nullptr) - CHECKPOINT_ZONE_HEIGHT * m_currency.difficultyTarget()) {
+    m_miner.generate();
+  }
+
+  ~BlockchainCacheTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_dir, ignore);
+  }
+
+  // seed makes a block differ from the one it replaces after a rollback
+  void addBlock(Blockchain& blockchain, uint64_t seed = 0) {
+    uint32_t height = blockchain.getCurrentBlockchainHeight();
+    Block block = boost::value_initialized<Block>();
+    block.majorVersion = blockchain.get_block_major_version_for_height(height);
+    block.minorVersion = BLOCK_MINOR_VERSION_0;
+    block.previousBlockHash = blockchain.getTailId();
+    // blocks come twice as fast as the target, so the difficulty never rounds down to zero
+    block.timestamp = m_startTime + height * m_currency.difficultyTarget() / 2 + seed;
+    ASSERT_TRUE(m_currency.constructMinerTx(height, 0, blockchain.getCoinsInCirculation(), 0, 0, m_miner.getAccountKeys().address,
+      block.baseTransaction, BinaryArray(), 11));
+
+    block_verification_context bvc = boost::value_initialized<block_verification_context>();
+    ASSERT_TRUE(blockchain.addNewBlock(block, bvc));
+    ASSERT_TRUE(bvc.m_added_to_main_chain);
+  }
+
+  void addBlocks(Blockchain& blockchain, uint32_t count, uint64_t seed = 0) {
+    for (uint32_t i = 0; i < count; ++i) {
+      addBlock(blockchain, seed);
+    }
+  }
+
+  bool cacheRebuilt() const {
+    return m_log.str().find("rebuilding internal structures") != std::string::npos;
+  }
+
+protected:
+  std::ostringstream m_log;
+  logging::StreamLogger m_logger;
+  Currency m_currency;
+  boost::filesystem::path m_dir;
+  uint64_t m_startTime;
+  AccountBase m_miner;
+};
+
+}
+
+TEST_F(BlockchainCacheTest, reorgAboveCheckpointKeepsCache) {
+  crypto::Hash tailId;
+  {
+    Node node(m_currency, m_logger);
+    ASSERT_TRUE(node.blockchain.init(m_dir.string(), false));
+    addBlocks(node.blockchain, 12);
+    ASSERT_TRUE(node.blockchain.storeCache());
+
+    addBlocks(node.blockchain, 3);
+    ASSERT_TRUE(node.blockchain.rollbackBlockchainTo(13));
+    addBlocks(node.blockchain, 2, 1);
+    tailId = node.blockchain.getTailId();
+  }
+
+  Node node(m_currency, m_logger);
+  ASSERT_TRUE(node.blockchain.init(m_dir.string(), true));
+  ASSERT_FALSE(cacheRebuilt()) << m_log.str();
+  ASSERT_EQ(16, node.blockchain.getCurrentBlockchainHeight());
+  ASSERT_EQ(tailId, node.blockchain.getTailId());
+}
+
+TEST_F(BlockchainCacheTest, reorgBelowCheckpointReplaysJournal) {
+  crypto::Hash tailId;
+  {
+    Node node(m_currency, m_logger);
+    ASSERT_TRUE(node.blockchain.init(m_dir.string(), false));
+    addBlocks(node.blockchain, 12);
+    ASSERT_TRUE(node.blockchain.storeCache());
+
+    addBlocks(node.blockchain, 3);
+    ASSERT_TRUE(node.blockchain.rollbackBlockchainTo(10));
+    addBlocks(node.blockchain, 4, 1);
+    tailId = node.blockchain.getTailId();
+  }
+
+  Node node(m_currency, m_logger);
+  ASSERT_TRUE(node.blockchain.init(m_dir.string(), true));
+  ASSERT_FALSE(cacheRebuilt()) << m_log.str();
+  ASSERT_EQ(15, node.blockchain.getCurrentBlockchainHeight());
+  ASSERT_EQ(tailId, node.blockchain.getTailId());
+}
+
+TEST_F(BlockchainCacheTest, staleCheckpointIsSavedWithNextBlock) {
+  Node node(m_currency, m_logger);
+  ASSERT_TRUE(node.blockchain.init(m_dir.string(), false));
+  boost::filesystem::path cacheFile = m_dir / m_currency.blocksCacheFileName();
+  ASSERT_FALSE(boost::filesystem::exists(cacheFile));
+
+  // a new chain has no key image table checkpoint yet
+  addBlocks(node.blockchain, 1);
+  ASSERT_TRUE(boost::filesystem::exists(cacheFile));
+  ASSERT_FALSE(boost::filesystem::exists(cacheFile.string() + ".tmp"));
+}
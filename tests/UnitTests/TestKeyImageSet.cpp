@@ -0,0 +1,132 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/KeyImageSet.h"
+
+namespace {
+
+crypto::KeyImage makeKeyImage(uint32_t i) {
+  crypto::KeyImage keyImage;
+  crypto::Hash hash;
+  crypto::cn_fast_hash(&i, sizeof i, hash);
+  memcpy(&keyImage, &hash, sizeof keyImage);
+  return keyImage;
+}
+
+crypto::Hash makeHash(uint32_t i) {
+  crypto::Hash hash;
+  crypto::cn_fast_hash(&i, sizeof i, hash);
+  return hash;
+}
+
+class KeyImageSetTest : public ::testing::Test {
+public:
+  KeyImageSetTest() : m_dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(m_dir);
+  }
+
+  ~KeyImageSetTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_dir, ignore);
+  }
+
+  std::string path(const std::string& name) const {
+    return (m_dir / name).string();
+  }
+
+protected:
+  boost::filesystem::path m_dir;
+};
+
+}
+
+TEST_F(KeyImageSetTest, insertAndEraseBeforeAndAfterMerge) {
+  cn::KeyImageSet set;
+  ASSERT_TRUE(set.open(path("keyimages")));
+  for (uint32_t i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(set.insert(makeKeyImage(i)));
+  }
+
+  ASSERT_FALSE(set.insert(makeKeyImage(10)));
+  ASSERT_TRUE(set.erase(makeKeyImage(10)));
+  ASSERT_FALSE(set.erase(makeKeyImage(10)));
+  ASSERT_TRUE(set.merge(cn::NULL_HASH));
+  ASSERT_EQ(0, set.pendingCount());
+  ASSERT_EQ(999, set.size());
+
+  ASSERT_TRUE(set.erase(makeKeyImage(20)));
+  ASSERT_FALSE(set.contains(makeKeyImage(20)));
+  ASSERT_TRUE(set.insert(makeKeyImage(20)));
+  ASSERT_TRUE(set.erase(makeKeyImage(30)));
+  ASSERT_TRUE(set.insert(makeKeyImage(10)));
+
+  for (uint32_t i = 0; i < 1000; ++i) {
+    ASSERT_EQ(i != 30, set.contains(makeKeyImage(i))) << i;
+  }
+
+  for (uint32_t i = 1000; i < 2000; ++i) {
+    ASSERT_FALSE(set.contains(makeKeyImage(i)));
+  }
+}
+
+TEST_F(KeyImageSetTest, mergedTableSurvivesReopen) {
+  {
+    cn::KeyImageSet set;
+    ASSERT_TRUE(set.open(path("keyimages")));
+    for (uint32_t i = 0; i < 100; ++i) {
+      set.insert(makeKeyImage(i));
+    }
+
+    ASSERT_TRUE(set.merge(makeHash(1)));
+    set.erase(makeKeyImage(0));
+    set.insert(makeKeyImage(100));
+  }
+
+  cn::KeyImageSet set;
+  ASSERT_TRUE(set.open(path("keyimages")));
+  ASSERT_EQ(makeHash(1), set.checkpointHash());
+  ASSERT_EQ(100, set.size());
+  ASSERT_TRUE(set.contains(makeKeyImage(0)));
+  ASSERT_FALSE(set.contains(makeKeyImage(100)));
+}
+
+TEST_F(KeyImageSetTest, clearWritesEmptyTable) {
+  cn::KeyImageSet set;
+  ASSERT_TRUE(set.open(path("keyimages")));
+  set.insert(makeKeyImage(1));
+  ASSERT_TRUE(set.merge(makeHash(1)));
+
+  ASSERT_TRUE(set.clear());
+  ASSERT_EQ(0, set.size());
+  ASSERT_EQ(cn::NULL_HASH, set.checkpointHash());
+  ASSERT_FALSE(set.contains(makeKeyImage(1)));
+}
+
+TEST_F(KeyImageSetTest, failedMergeKeepsTableAndPendingChanges) {
+  cn::KeyImageSet set;
+  ASSERT_TRUE(set.open(path("keyimages")));
+  for (uint32_t i = 0; i < 100; ++i) {
+    set.insert(makeKeyImage(i));
+  }
+
+  ASSERT_TRUE(set.merge(makeHash(1)));
+  set.erase(makeKeyImage(0));
+  set.insert(makeKeyImage(100));
+
+  // The mapped table outlives its name, a non-empty directory in its place makes the rename fail
+  boost::filesystem::remove(path("keyimages"));
+  boost::filesystem::create_directories(path("keyimages/blocker"));
+
+  ASSERT_FALSE(set.merge(makeHash(2)));
+  ASSERT_EQ(makeHash(1), set.checkpointHash());
+  ASSERT_EQ(100, set.size());
+  ASSERT_FALSE(set.contains(makeKeyImage(0)));
+  for (uint32_t i = 1; i <= 100; ++i) {
+    ASSERT_TRUE(set.contains(makeKeyImage(i))) << i;
+  }
+}
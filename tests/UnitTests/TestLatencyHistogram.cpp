@@ -0,0 +1,48 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "Common/LatencyHistogram.h"
+
+using common::LatencyHistogram;
+
+TEST(LatencyHistogram, emptyHistogramReportsZero) {
+  LatencyHistogram histogram;
+  ASSERT_EQ(0, histogram.count());
+  ASSERT_EQ(0, histogram.percentile(0.5));
+}
+
+TEST(LatencyHistogram, durationsFallIntoPowerOfTwoBuckets) {
+  LatencyHistogram histogram;
+  histogram.add(std::chrono::nanoseconds(500));
+  histogram.add(std::chrono::microseconds(1));
+  histogram.add(std::chrono::microseconds(3));
+  histogram.add(std::chrono::microseconds(4));
+  histogram.add(std::chrono::hours(1));
+
+  ASSERT_EQ(5, histogram.count());
+  ASSERT_EQ(1, histogram.bucketCount(0));
+  ASSERT_EQ(1, histogram.bucketCount(1));
+  ASSERT_EQ(1, histogram.bucketCount(2));
+  ASSERT_EQ(1, histogram.bucketCount(3));
+  ASSERT_EQ(1, histogram.bucketCount(LatencyHistogram::BUCKET_COUNT - 1));
+  ASSERT_EQ(8 + 3600000000ull, histogram.totalMicroseconds());
+}
+
+TEST(LatencyHistogram, percentileIsUpperBoundOfBucket) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 90; ++i) {
+    histogram.add(std::chrono::microseconds(100));
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    histogram.add(std::chrono::milliseconds(10));
+  }
+
+  ASSERT_EQ(128, histogram.percentile(0.5));
+  ASSERT_EQ(128, histogram.percentile(0.9));
+  ASSERT_EQ(16384, histogram.percentile(0.91));
+  ASSERT_EQ(16384, histogram.percentile(1));
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <System/ContextGroup.h>
+#include <System/Dispatcher.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/TcpListener.h>
+
+#include "P2p/LevinProtocol.h"
+
+using namespace platform_system;
+
+namespace {
+
+const Ipv4Address LISTEN_ADDRESS("127.0.0.1");
+const uint16_t LISTEN_PORT = 6667;
+
+}
+
+TEST(LevinProtocol, queuedMessagesAreSentInOneFlush) {
+  Dispatcher dispatcher;
+  TcpListener listener(dispatcher, LISTEN_ADDRESS, LISTEN_PORT);
+  TcpConnection sender = TcpConnector(dispatcher).connect(LISTEN_ADDRESS, LISTEN_PORT);
+  TcpConnection receiver = listener.accept();
+
+  cn::BinaryArray small(10, 1);
+  cn::BinaryArray empty;
+  cn::BinaryArray big(3 * 1024 * 1024, 2);
+  std::vector<cn::LevinProtocol::Command> commands;
+
+  ContextGroup contextGroup(dispatcher);
+  contextGroup.spawn([&] {
+    cn::LevinProtocol proto(receiver);
+    cn::LevinProtocol::Command cmd;
+    while (proto.readCommand(cmd)) {
+      commands.push_back(cmd);
+    }
+  });
+
+  contextGroup.spawn([&] {
+    cn::LevinProtocol proto(sender);
+    size_t headSize = proto.queueReply(2, empty, 5);
+    ASSERT_EQ(headSize + small.size(), proto.queueMessage(1, small, false));
+    ASSERT_EQ(1, proto.flush());
+    ASSERT_EQ(0, proto.flush());
+
+    ASSERT_EQ(headSize + big.size(), proto.queueMessage(3, big, true));
+    ASSERT_LE(1, proto.flush());
+    sender = TcpConnection();
+  });
+
+  contextGroup.wait();
+
+  ASSERT_EQ(3, commands.size());
+  ASSERT_EQ(2, commands[0].command);
+  ASSERT_TRUE(commands[0].isResponse);
+  ASSERT_TRUE(commands[0].buf.empty());
+  ASSERT_EQ(1, commands[1].command);
+  ASSERT_TRUE(commands[1].isNotify);
+  ASSERT_EQ(small, commands[1].buf);
+  ASSERT_EQ(3, commands[2].command);
+  ASSERT_TRUE(commands[2].needReply());
+  ASSERT_EQ(big, commands[2].buf);
+}
+
+TEST(LevinProtocol, burstOfNotificationsIsSentInOneWrite) {
+  Dispatcher dispatcher;
+  TcpListener listener(dispatcher, LISTEN_ADDRESS, LISTEN_PORT + 1);
+  TcpConnection sender = TcpConnector(dispatcher).connect(LISTEN_ADDRESS, LISTEN_PORT + 1);
+  TcpConnection receiver = listener.accept();
+
+  // a writer batch, header and body of each message are two of the 64 gathered buffers
+  const size_t MESSAGE_COUNT = 32;
+  std::vector<cn::BinaryArray> messages;
+  for (size_t i = 0; i < MESSAGE_COUNT; ++i) {
+    messages.emplace_back(100 + i, static_cast<uint8_t>(i));
+  }
+
+  std::vector<cn::LevinProtocol::Command> commands;
+
+  ContextGroup contextGroup(dispatcher);
+  contextGroup.spawn([&] {
+    cn::LevinProtocol proto(receiver);
+    cn::LevinProtocol::Command cmd;
+    while (proto.readCommand(cmd)) {
+      commands.push_back(cmd);
+    }
+  });
+
+  contextGroup.spawn([&] {
+    cn::LevinProtocol proto(sender);
+    for (size_t i = 0; i < MESSAGE_COUNT; ++i) {
+      proto.queueMessage(static_cast<uint32_t>(i), messages[i], false);
+    }
+
+    ASSERT_EQ(1, proto.flush());
+    sender = TcpConnection();
+  });
+
+  contextGroup.wait();
+
+  ASSERT_EQ(MESSAGE_COUNT, commands.size());
+  for (size_t i = 0; i < MESSAGE_COUNT; ++i) {
+    ASSERT_EQ(i, commands[i].command);
+    ASSERT_EQ(messages[i], commands[i].buf);
+  }
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "CryptoNoteCore/MappedBlockStore.h"
+#include "CryptoNoteCore/SwappedVector.h"
+#include "Serialization/SerializationOverloads.h"
+
+namespace {
+
+struct TestItem {
+  uint32_t height;
+  std::string payload;
+
+  void serialize(cn::ISerializer& s) {
+    s(height, "height");
+    s(payload, "payload");
+  }
+};
+
+struct TestItemPrefix {
+  uint32_t height;
+
+  void serialize(cn::ISerializer& s) {
+    s(height, "height");
+  }
+};
+
+TestItem makeItem(uint32_t height) {
+  TestItem item;
+  item.height = height;
+  item.payload = std::string(height % 97 + 1, static_cast<char>('a' + height % 26));
+  return item;
+}
+
+class MappedBlockStoreTest : public ::testing::Test {
+public:
+  MappedBlockStoreTest() : m_dir(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {
+    boost::filesystem::create_directories(m_dir);
+  }
+
+  ~MappedBlockStoreTest() {
+    boost::system::error_code ignore;
+    boost::filesystem::remove_all(m_dir, ignore);
+  }
+
+  std::string path(const std::string& name) const {
+    return (m_dir / name).string();
+  }
+
+protected:
+  boost::filesystem::path m_dir;
+};
+
+}
+
+TEST_F(MappedBlockStoreTest, pushedItemsSurviveReopen) {
+  {
+    MappedBlockStore<TestItem> store;
+    ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+    for (uint32_t i = 0; i < 100; ++i) {
+      store.push_back(makeItem(i));
+    }
+  }
+
+  MappedBlockStore<TestItem> store;
+  ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+  ASSERT_EQ(100, store.size());
+  for (uint32_t i = 0; i < 100; ++i) {
+    ASSERT_EQ(i, store[i].height);
+    ASSERT_EQ(makeItem(i).payload, store[i].payload);
+  }
+}
+
+TEST_F(MappedBlockStoreTest, popBackTruncatesItems) {
+  MappedBlockStore<TestItem> store;
+  ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+  for (uint32_t i = 0; i < 10; ++i) {
+    store.push_back(makeItem(i));
+  }
+
+  store.pop_back();
+  store.pop_back();
+  store.push_back(makeItem(42));
+
+  ASSERT_EQ(9, store.size());
+  ASSERT_EQ(7, store[7].height);
+  ASSERT_EQ(42, store.back().height);
+  ASSERT_EQ(makeItem(42).payload, store.back().payload);
+}
+
+TEST_F(MappedBlockStoreTest, decodePrefixReadsLeadingFields) {
+  MappedBlockStore<TestItem> store;
+  ASSERT_TRUE(store.open(path("items"), path("index"), 1));
+  for (uint32_t i = 0; i < 10; ++i) {
+    store.push_back(makeItem(i));
+  }
+
+  TestItemPrefix prefix;
+  store.decodePrefix(5, prefix);
+  ASSERT_EQ(5, prefix.height);
+}
+
+TEST_F(MappedBlockStoreTest, importsSwappedVectorFiles) {
+  {
+    SwappedVector<TestItem> legacy;
+    ASSERT_TRUE(legacy.open(path("legacy_items"), path("legacy_index"), 4));
+    for (uint32_t i = 0; i < 50; ++i) {
+      legacy.push_back(makeItem(i));
+    }
+  }
+
+  MappedBlockStore<TestItem> store;
+  ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+  ASSERT_TRUE(store.importSwappedVector(path("legacy_items"), path("legacy_index")));
+  ASSERT_EQ(50, store.size());
+  for (uint32_t i = 0; i < 50; ++i) {
+    ASSERT_EQ(makeItem(i).payload, store[i].payload);
+  }
+}
+
+TEST_F(MappedBlockStoreTest, readerCachesAreDroppedOnThreadExit) {
+  MappedBlockStore<TestItem> store;
+  ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+  for (uint32_t i = 0; i < 10; ++i) {
+    store.push_back(makeItem(i));
+  }
+
+  ASSERT_EQ(4, store.cachedItemCount());
+
+  for (uint32_t round = 0; round < 3; ++round) {
+    std::vector<std::thread> readers;
+    for (uint32_t reader = 0; reader < 4; ++reader) {
+      readers.emplace_back([&store, reader] {
+        for (uint32_t i = 0; i < 10; ++i) {
+          ASSERT_EQ((i + reader) % 10, store[(i + reader) % 10].height);
+        }
+      });
+    }
+
+    for (auto& reader : readers) {
+      reader.join();
+    }
+
+    ASSERT_EQ(4, store.cachedItemCount());
+  }
+}
+
+TEST_F(MappedBlockStoreTest, readerMayOutliveStore) {
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool read = false;
+  bool closed = false;
+
+  std::thread reader;
+  {
+    MappedBlockStore<TestItem> store;
+    ASSERT_TRUE(store.open(path("items"), path("index"), 4));
+    store.push_back(makeItem(1));
+
+    reader = std::thread([&] {
+      ASSERT_EQ(1, store[0].height);
+      std::unique_lock<std::mutex> lock(mutex);
+      read = true;
+      condition.notify_all();
+      condition.wait(lock, [&] { return closed; });
+    });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    condition.wait(lock, [&] { return read; });
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    condition.notify_all();
+  }
+
+  reader.join();
+}
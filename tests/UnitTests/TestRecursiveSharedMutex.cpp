@@ -0,0 +1,87 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include "CryptoNoteCore/RecursiveSharedMutex.h"
+
+using namespace cn;
+
+TEST(RecursiveSharedMutex, readersDontBlockEachOther) {
+  RecursiveSharedMutex mutex;
+  SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+
+  auto reader = std::async(std::launch::async, [&mutex] {
+    SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+    return true;
+  });
+
+  ASSERT_EQ(std::future_status::ready, reader.wait_for(std::chrono::seconds(5)));
+}
+
+TEST(RecursiveSharedMutex, writerWaitsForReaders) {
+  RecursiveSharedMutex mutex;
+  std::atomic<bool> written(false);
+  std::future<void> writer;
+  {
+    SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+    writer = std::async(std::launch::async, [&] {
+      std::lock_guard<RecursiveSharedMutex> lock(mutex);
+      written = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_FALSE(written);
+  }
+
+  writer.get();
+  ASSERT_TRUE(written);
+  ASSERT_EQ(1, mutex.statistics().exclusiveWaits);
+}
+
+TEST(RecursiveSharedMutex, readerReentersPastWaitingWriter) {
+  RecursiveSharedMutex mutex;
+  std::future<void> writer;
+  {
+    SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+    writer = std::async(std::launch::async, [&mutex] {
+      std::lock_guard<RecursiveSharedMutex> lock(mutex);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    SharedLockGuard<RecursiveSharedMutex> nested(mutex);
+  }
+
+  writer.get();
+}
+
+TEST(RecursiveSharedMutex, ownerMayReenterAndRead) {
+  RecursiveSharedMutex mutex;
+  std::unique_lock<RecursiveSharedMutex> lock(mutex);
+  {
+    std::lock_guard<RecursiveSharedMutex> nested(mutex);
+    SharedLockGuard<RecursiveSharedMutex> read(mutex);
+  }
+
+  auto reader = std::async(std::launch::async, [&mutex] {
+    SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+  });
+
+  bool readerBlocked = reader.wait_for(std::chrono::milliseconds(50)) == std::future_status::timeout;
+  lock.unlock();
+  reader.get();
+  ASSERT_TRUE(readerBlocked);
+}
+
+TEST(RecursiveSharedMutex, upgradeThrows) {
+  RecursiveSharedMutex mutex;
+  SharedLockGuard<RecursiveSharedMutex> lock(mutex);
+  ASSERT_THROW(mutex.lock(), std::logic_error);
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/RingSignatureBatch.h"
+#include "crypto/hash.h"
+
+using namespace cn;
+
+namespace {
+
+const size_t RING_SIZE = 3;
+
+class RingSignatureBatchTest : public ::testing::Test {
+public:
+  // Adds a valid signature of transaction input (transactionIndex, inputIndex), or a corrupted one
+  void addInput(size_t transactionIndex, size_t inputIndex, bool valid = true) {
+    std::vector<crypto::PublicKey> publicKeys(RING_SIZE);
+    crypto::SecretKey secretKey;
+    for (size_t i = 0; i < RING_SIZE; ++i) {
+      crypto::SecretKey unused;
+      crypto::generate_keys(publicKeys[i], i == 1 ? secretKey : unused);
+    }
+
+    crypto::KeyImage keyImage;
+    crypto::generate_key_image(publicKeys[1], secretKey, keyImage);
+
+    crypto::Hash prefixHash = crypto::rand<crypto::Hash>();
+    std::vector<const crypto::PublicKey*> keys;
+    for (const auto& key : publicKeys) {
+      keys.push_back(&key);
+    }
+
+    std::vector<crypto::Signature> signatures(RING_SIZE);
+    crypto::generate_ring_signature(prefixHash, keyImage, keys, secretKey, 1, signatures.data());
+    if (!valid) {
+      prefixHash.data[0] ^= 1;
+    }
+
+    batch.add(transactionIndex, inputIndex, prefixHash, keyImage, keys, signatures);
+  }
+
+  RingSignatureBatch batch;
+};
+
+}
+
+TEST_F(RingSignatureBatchTest, acceptsValidSignatures) {
+  for (size_t i = 0; i < 8; ++i) {
+    addInput(i / 2, i % 2);
+  }
+
+  RingSignatureBatch::Failure failure;
+  ASSERT_TRUE(batch.verify(1, failure));
+  ASSERT_TRUE(batch.verify(4, failure));
+}
+
+TEST_F(RingSignatureBatchTest, reportsFirstFailedInput) {
+  for (size_t i = 0; i < 16; ++i) {
+    addInput(i / 4, i % 4, i != 6 && i != 13);
+  }
+
+  for (size_t threads = 1; threads <= 8; threads *= 2) {
+    RingSignatureBatch::Failure failure;
+    ASSERT_FALSE(batch.verify(threads, failure));
+    ASSERT_EQ(1, failure.transactionIndex);
+    ASSERT_EQ(2, failure.inputIndex);
+  }
+}
+
+TEST_F(RingSignatureBatchTest, emptyBatchIsValid) {
+  RingSignatureBatch::Failure failure;
+  ASSERT_TRUE(batch.verify(4, failure));
+}
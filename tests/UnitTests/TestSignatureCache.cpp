@@ -0,0 +1,129 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/SignatureCache.h"
+
+using namespace cn;
+
+namespace {
+
+const size_t RING_SIZE = 3;
+
+class SignatureCacheTest : public ::testing::Test {
+public:
+  SignatureCacheTest() : m_prefixHash(crypto::rand<crypto::Hash>()), m_ringKeys(RING_SIZE), m_signatures(RING_SIZE) {
+    for (size_t i = 0; i < RING_SIZE; ++i) {
+      m_ringKeys[i] = crypto::rand<crypto::PublicKey>();
+      m_signatures[i] = crypto::rand<crypto::Signature>();
+    }
+  }
+
+  crypto::Hash makeKey(size_t inputIndex = 0) const {
+    return makeKey(m_prefixHash, inputIndex, m_ringKeys, m_signatures);
+  }
+
+  static crypto::Hash makeKey(const crypto::Hash& prefixHash, size_t inputIndex, const std::vector<crypto::PublicKey>& ringKeys,
+    const std::vector<crypto::Signature>& signatures) {
+    std::vector<const crypto::PublicKey*> keys;
+    for (const auto& key : ringKeys) {
+      keys.push_back(&key);
+    }
+
+    return SignatureCache::makeKey(prefixHash, inputIndex, keys, signatures);
+  }
+
+  static std::vector<crypto::Hash> randomKeys(size_t count) {
+    std::vector<crypto::Hash> keys;
+    for (size_t i = 0; i < count; ++i) {
+      keys.push_back(crypto::rand<crypto::Hash>());
+    }
+
+    return keys;
+  }
+
+protected:
+  crypto::Hash m_prefixHash;
+  std::vector<crypto::PublicKey> m_ringKeys;
+  std::vector<crypto::Signature> m_signatures;
+};
+
+}
+
+TEST_F(SignatureCacheTest, keyDependsOnEveryPart) {
+  crypto::Hash key = makeKey();
+  ASSERT_EQ(key, makeKey());
+
+  ASSERT_NE(key, makeKey(crypto::rand<crypto::Hash>(), 0, m_ringKeys, m_signatures));
+  ASSERT_NE(key, makeKey(1));
+
+  for (size_t i = 0; i < RING_SIZE; ++i) {
+    std::vector<crypto::PublicKey> ringKeys = m_ringKeys;
+    ringKeys[i] = crypto::rand<crypto::PublicKey>();
+    ASSERT_NE(key, makeKey(m_prefixHash, 0, ringKeys, m_signatures)) << "ring member " << i;
+  }
+
+  // a flipped bit in the first or last byte of every signature, the prefix hash doesn't cover them
+  for (size_t i = 0; i < RING_SIZE; ++i) {
+    for (size_t byte = 0; byte < sizeof(crypto::Signature); byte += sizeof(crypto::Signature) - 1) {
+      std::vector<crypto::Signature> signatures = m_signatures;
+      reinterpret_cast<uint8_t*>(&signatures[i])[byte] ^= 1;
+      ASSERT_NE(key, makeKey(m_prefixHash, 0, m_ringKeys, signatures)) << "signature " << i << ", byte " << byte;
+    }
+  }
+}
+
+TEST_F(SignatureCacheTest, oldestEntriesAreEvictedPastCapacity) {
+  const size_t CAPACITY = 10;
+  SignatureCache cache(CAPACITY);
+  std::vector<crypto::Hash> keys = randomKeys(CAPACITY + 4);
+  for (const auto& key : keys) {
+    cache.insert(key);
+  }
+
+  ASSERT_EQ(CAPACITY, cache.getStatistics().size);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_EQ(i >= keys.size() - CAPACITY, cache.contains(keys[i])) << "key " << i;
+  }
+
+  // inserting a key again doesn't refresh it or take another place
+  cache.insert(keys[4]);
+  cache.insert(crypto::rand<crypto::Hash>());
+  ASSERT_EQ(CAPACITY, cache.getStatistics().size);
+  ASSERT_FALSE(cache.contains(keys[4]));
+  ASSERT_TRUE(cache.contains(keys[5]));
+}
+
+TEST_F(SignatureCacheTest, zeroCapacityNeverStores) {
+  SignatureCache cache(0);
+  crypto::Hash key = makeKey();
+  cache.insert(key);
+  ASSERT_FALSE(cache.contains(key));
+  ASSERT_EQ(0, cache.getStatistics().size);
+}
+
+TEST_F(SignatureCacheTest, lookupsAreCounted) {
+  SignatureCache cache(4);
+  std::vector<crypto::Hash> keys = randomKeys(3);
+  cache.insert(keys[0]);
+  cache.insert(keys[1]);
+
+  ASSERT_TRUE(cache.contains(keys[0]));
+  ASSERT_TRUE(cache.contains(keys[1]));
+  ASSERT_TRUE(cache.contains(keys[0]));
+  ASSERT_FALSE(cache.contains(keys[2]));
+
+  // inserting isn't a lookup
+  cache.insert(keys[2]);
+
+  SignatureCache::Statistics statistics = cache.getStatistics();
+  ASSERT_EQ(3, statistics.hits);
+  ASSERT_EQ(1, statistics.misses);
+  ASSERT_EQ(3, statistics.size);
+  ASSERT_EQ("hits 3, misses 1, hit rate 75%, entries 3", cache.toString());
+}
@@ -0,0 +1,171 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Common/ThreadPool.h"
+
+using namespace common;
+
+namespace {
+
+const size_t THREAD_COUNT = 3;
+
+// Counts the calls made for every index of a range
+class VisitCounter {
+public:
+  explicit VisitCounter(size_t count) : m_visits(new std::atomic<size_t>[count]), m_count(count) {
+    for (size_t i = 0; i < count; ++i) {
+      m_visits[i] = 0;
+    }
+  }
+
+  void visit(size_t index) {
+    ASSERT_LT(index, m_count);
+    ++m_visits[index];
+  }
+
+  bool eachVisitedOnce() const {
+    for (size_t i = 0; i < m_count; ++i) {
+      if (m_visits[i] != 1) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  std::unique_ptr<std::atomic<size_t>[]> m_visits;
+  size_t m_count;
+};
+
+}
+
+TEST(ThreadPool, everyIndexIsVisitedOnce) {
+  ThreadPool pool(THREAD_COUNT);
+  ASSERT_EQ(THREAD_COUNT + 1, pool.getConcurrency());
+
+  // every job is a new generation, the threads must not skip one or run one twice
+  for (size_t count : { 2, 3, 7, 100, 1, 10000, 64, 5 }) {
+    VisitCounter counter(count);
+    pool.parallelFor(count, [&](size_t i) { counter.visit(i); });
+    ASSERT_TRUE(counter.eachVisitedOnce()) << "count " << count;
+  }
+}
+
+TEST(ThreadPool, zeroLengthRangeCallsNothing) {
+  ThreadPool pool(THREAD_COUNT);
+  std::atomic<size_t> calls(0);
+  pool.parallelFor(0, [&](size_t) { ++calls; });
+  ASSERT_EQ(0, calls);
+
+  // the pool still works after an empty job
+  VisitCounter counter(10);
+  pool.parallelFor(10, [&](size_t i) { counter.visit(i); });
+  ASSERT_TRUE(counter.eachVisitedOnce());
+}
+
+TEST(ThreadPool, poolWithoutThreadsRunsOnCaller) {
+  ThreadPool pool(0);
+  ASSERT_EQ(1, pool.getConcurrency());
+
+  std::thread::id caller = std::this_thread::get_id();
+  VisitCounter counter(100);
+  pool.parallelFor(100, [&](size_t i) {
+    ASSERT_EQ(caller, std::this_thread::get_id());
+    counter.visit(i);
+  });
+
+  ASSERT_TRUE(counter.eachVisitedOnce());
+}
+
+TEST(ThreadPool, callerWorksOnTheJob) {
+  ThreadPool pool(1);
+
+  // both calls wait for each other, the single thread can't finish the job alone
+  std::atomic<size_t> started(0);
+  std::atomic<bool> callerTookPart(false);
+  std::thread::id caller = std::this_thread::get_id();
+  pool.parallelFor(2, [&](size_t) {
+    if (std::this_thread::get_id() == caller) {
+      callerTookPart = true;
+    }
+
+    ++started;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+  });
+
+  ASSERT_EQ(2, started);
+  ASSERT_TRUE(callerTookPart);
+}
+
+TEST(ThreadPool, concurrentCallersGetTheirOwnJobs) {
+  const size_t CALLER_COUNT = 4;
+  const size_t JOB_COUNT = 50;
+  const size_t JOB_SIZE = 1000;
+
+  ThreadPool pool(THREAD_COUNT);
+  std::vector<std::thread> callers;
+  std::vector<size_t> failedJobs(CALLER_COUNT, 0);
+  for (size_t c = 0; c < CALLER_COUNT; ++c) {
+    callers.emplace_back([&, c] {
+      for (size_t job = 0; job < JOB_COUNT; ++job) {
+        VisitCounter counter(JOB_SIZE + c);
+        pool.parallelFor(JOB_SIZE + c, [&](size_t i) { counter.visit(i); });
+        if (!counter.eachVisitedOnce()) {
+          ++failedJobs[c];
+        }
+      }
+    });
+  }
+
+  for (auto& caller : callers) {
+    caller.join();
+  }
+
+  ASSERT_EQ(std::vector<size_t>(CALLER_COUNT, 0), failedJobs);
+}
+
+TEST(ThreadPool, bodyMayRunJobsOnAnotherPool) {
+  const size_t OUTER_COUNT = 8;
+  const size_t INNER_COUNT = 100;
+
+  ThreadPool outer(THREAD_COUNT);
+  ThreadPool inner(THREAD_COUNT);
+  VisitCounter counter(OUTER_COUNT * INNER_COUNT);
+  outer.parallelFor(OUTER_COUNT, [&](size_t i) {
+    inner.parallelFor(INNER_COUNT, [&](size_t j) { counter.visit(i * INNER_COUNT + j); });
+  });
+
+  ASSERT_TRUE(counter.eachVisitedOnce());
+}
+
+TEST(ThreadPool, exceptionIsRethrownToCaller) {
+  ThreadPool pool(THREAD_COUNT);
+  std::atomic<size_t> calls(0);
+  ASSERT_THROW(pool.parallelFor(1000, [&](size_t i) {
+    ++calls;
+    if (i == 10) {
+      throw std::runtime_error("body failed");
+    }
+  }), std::runtime_error);
+
+  ASSERT_LE(11, calls);
+
+  // the error belongs to the failed job alone
+  VisitCounter counter(1000);
+  pool.parallelFor(1000, [&](size_t i) { counter.visit(i); });
+  ASSERT_TRUE(counter.eachVisitedOnce());
+}
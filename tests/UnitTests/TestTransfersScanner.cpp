@@ -0,0 +1,113 @@
+// Copyright (c) 2017-2022 UltraNote Infinity developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/Account.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/TransactionApi.h"
+#include "Logging/LoggerGroup.h"
+#include "Transfers/CommonTypes.h"
+#include "Transfers/TransfersScanner.h"
+
+using namespace cn;
+
+namespace {
+
+const size_t ACCOUNT_COUNT = 3;
+const uint32_t BLOCK_COUNT = 20;
+
+class TransfersScannerTest : public ::testing::Test {
+public:
+  TransfersScannerTest() : m_currency(CurrencyBuilder(m_logger).currency()), m_accounts(ACCOUNT_COUNT), m_blocks(BLOCK_COUNT) {
+    for (auto& account : m_accounts) {
+      account.generate();
+    }
+
+    // every block pays one of the accounts
+    for (uint32_t i = 0; i < BLOCK_COUNT; ++i) {
+      m_blocks[i].blockHash = crypto::rand<crypto::Hash>();
+      m_blocks[i].block = Block();
+      m_blocks[i].block->timestamp = 1000 + i;
+      Transaction tx;
+      m_currency.constructMinerTx(i, 0, 0, 2, 0, m_accounts[i % ACCOUNT_COUNT].getAccountKeys().address, tx);
+      m_blocks[i].transactions.emplace_back(createTransactionPrefix(tx));
+    }
+  }
+
+  void setAccount(TransfersScanner& scanner, size_t account) {
+    const AccountKeys& keys = m_accounts[account].getAccountKeys();
+    scanner.setAccount(keys.viewSecretKey, { keys.address.spendPublicKey }, 0);
+  }
+
+  std::vector<TransfersScanner::TransactionOutputs> scanBlocks(TransfersScanner& scanner, size_t account, uint32_t startHeight, uint32_t endHeight) {
+    return scanner.scanBlocks(m_accounts[account].getAccountKeys().viewSecretKey, m_blocks.data() + startHeight, startHeight, endHeight - startHeight);
+  }
+
+  // What a scanner with the account alone finds
+  void checkScan(TransfersScanner& scanner, size_t account, uint32_t startHeight, uint32_t endHeight) {
+    TransfersScanner ownScanner(m_logger);
+    setAccount(ownScanner, account);
+    auto expected = scanBlocks(ownScanner, account, startHeight, endHeight);
+    auto found = scanBlocks(scanner, account, startHeight, endHeight);
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(expected.size(), found.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      ASSERT_EQ(expected[i].blockOffset, found[i].blockOffset);
+      ASSERT_EQ(expected[i].transactionIndex, found[i].transactionIndex);
+      ASSERT_EQ(expected[i].outputs, found[i].outputs);
+    }
+  }
+
+protected:
+  logging::LoggerGroup m_logger;
+  Currency m_currency;
+  std::vector<AccountBase> m_accounts;
+  std::vector<CompleteBlock> m_blocks;
+};
+
+}
+
+TEST_F(TransfersScannerTest, consumersGetTheirTailOfBatch) {
+  TransfersScanner scanner(m_logger);
+  for (size_t account = 0; account < ACCOUNT_COUNT; ++account) {
+    setAccount(scanner, account);
+  }
+
+  checkScan(scanner, 1, 6, 10);
+  checkScan(scanner, 0, 0, 10);
+  checkScan(scanner, 2, 3, 10);
+
+  checkScan(scanner, 0, 10, 20);
+  checkScan(scanner, 1, 10, 20);
+  checkScan(scanner, 2, 10, 20);
+}
+
+TEST_F(TransfersScannerTest, consumerBehindCatchesUp) {
+  TransfersScanner scanner(m_logger);
+  for (size_t account = 0; account < ACCOUNT_COUNT; ++account) {
+    setAccount(scanner, account);
+  }
+
+  checkScan(scanner, 0, 0, 10);
+  checkScan(scanner, 1, 0, 10);
+  checkScan(scanner, 2, 0, 10);
+
+  // account 2 resyncs from the start while the others go on
+  checkScan(scanner, 0, 10, 20);
+  checkScan(scanner, 2, 0, 20);
+  checkScan(scanner, 1, 10, 20);
+}
+
+TEST_F(TransfersScannerTest, changedAccountIsScannedAgain) {
+  TransfersScanner scanner(m_logger);
+  setAccount(scanner, 0);
+  setAccount(scanner, 1);
+  checkScan(scanner, 0, 0, 10);
+
+  setAccount(scanner, 2);
+  checkScan(scanner, 2, 0, 10);
+  checkScan(scanner, 1, 0, 10);
+}